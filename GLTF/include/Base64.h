@@ -3,6 +3,9 @@
 #include <string>
 
 namespace Base64 {
-	char* encode(unsigned char* data, size_t length);
+	size_t encodedLength(size_t length);
+	// Writes the encoding of data to destination, which must hold encodedLength(length) characters
+	size_t encode(const unsigned char* data, size_t length, char* destination);
+	std::string encode(const unsigned char* data, size_t length);
 	std::string decode(std::string uri);
-}
\ No newline at end of file
+}
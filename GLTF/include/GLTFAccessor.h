@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "GLTFBufferView.h"
 #include "GLTFConstants.h"
@@ -21,11 +24,12 @@ namespace GLTF {
 		};
 
 		GLTF::BufferView* bufferView = NULL;
-		int byteOffset = 0;
+		size_t byteOffset = 0;
 		GLTF::Constants::WebGL componentType;
-		int count = 0;
+		size_t count = 0;
 		float* max = NULL;
 		float* min = NULL;
+		bool normalized = false;
 		Type type = Type::UNKNOWN;
 
 		Accessor(GLTF::Accessor::Type type, GLTF::Constants::WebGL componentType);
@@ -33,31 +37,59 @@ namespace GLTF {
 		Accessor(GLTF::Accessor::Type type,
 			GLTF::Constants::WebGL componentType,
 			unsigned char* data,
-			int count,
+			size_t count,
 			GLTF::Constants::WebGL target
 		);
 
 		Accessor(GLTF::Accessor::Type type,
 			GLTF::Constants::WebGL componentType,
 			unsigned char* data,
-			int count,
+			size_t count,
 			GLTF::BufferView* bufferView
 		);
 
+		/**
+		 * Takes ownership of data allocated with `new[]` instead of copying it.
+		 */
 		Accessor(GLTF::Accessor::Type type,
 			GLTF::Constants::WebGL componentType,
-			int byteOffset,
-			int count,
+			std::unique_ptr<unsigned char[]> data,
+			size_t count,
+			GLTF::Constants::WebGL target
+		);
+
+		/**
+		 * Takes ownership of the storage of a vector instead of copying it, the number of elements is
+		 * derived from the size of the vector.
+		 */
+		template <typename T>
+		Accessor(GLTF::Accessor::Type type,
+			GLTF::Constants::WebGL componentType,
+			std::vector<T>&& data,
+			GLTF::Constants::WebGL target
+		) : Accessor(type, componentType) {
+			std::shared_ptr<std::vector<T>> storage = std::make_shared<std::vector<T>>(std::move(data));
+			adoptData((unsigned char*)storage->data(), storage->size() * sizeof(T), storage, target);
+		}
+
+		Accessor(GLTF::Accessor::Type type,
+			GLTF::Constants::WebGL componentType,
+			size_t byteOffset,
+			size_t count,
 			GLTF::BufferView* bufferView
 		);
 
 		static int getComponentByteLength(GLTF::Constants::WebGL componentType);
 		static int getNumberOfComponents(GLTF::Accessor::Type type);
 
+		/**
+		 * Computes the bounds of the accessor from the stored components, so integer accessors
+		 * (including normalized and quantized ones) get bounds in their integer domain.
+		 */
 		bool computeMinMax();
 		int getByteStride();
-		bool getComponentAtIndex(int index, float *component);
-		bool writeComponentAtIndex(int index, float* component);
+		bool getComponentAtIndex(size_t index, float *component);
+		bool writeComponentAtIndex(size_t index, float* component);
 		int getComponentByteLength();
 		int getNumberOfComponents();
 		bool equals(GLTF::Accessor* accessor);
@@ -65,5 +97,8 @@ namespace GLTF {
 
 		virtual std::string typeName();
 		virtual void writeJSON(void* writer, GLTF::Options* options);
+
+	private:
+		void adoptData(unsigned char* data, size_t byteLength, std::shared_ptr<void> storage, GLTF::Constants::WebGL target);
 	};
 };
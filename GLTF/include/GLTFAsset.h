@@ -8,6 +8,8 @@
 #include "GLTFDracoExtension.h"
 #include "GLTFObject.h"
 #include "GLTFScene.h"
+#include "GLTFThreadPool.h"
+#include "MeshOptimizer.h"
 
 #include "draco/compression/encode.h"
 
@@ -15,6 +17,22 @@ namespace GLTF {
 	class Asset : public GLTF::Object {
 	private:
 		std::vector<GLTF::MaterialCommon::Light*> _ambientLights;
+
+		// Objects reachable from the default scene, collected in one traversal and shared by the getAll* functions
+		bool _indexed = false;
+		std::vector<GLTF::Node*> _nodes;
+		std::vector<GLTF::Mesh*> _meshes;
+		std::vector<GLTF::Primitive*> _primitives;
+		std::vector<GLTF::Skin*> _skins;
+		std::vector<GLTF::Material*> _materials;
+		std::vector<GLTF::Technique*> _techniques;
+		std::vector<GLTF::Program*> _programs;
+		std::vector<GLTF::Shader*> _shaders;
+		std::vector<GLTF::Texture*> _textures;
+		std::vector<GLTF::Image*> _images;
+		std::vector<GLTF::Accessor*> _accessors;
+
+		void buildIndex();
 	public:
 		class Metadata : public GLTF::Object {
 		public:
@@ -48,10 +66,25 @@ namespace GLTF {
 		std::vector<GLTF::Texture*> getAllTextures();
 		std::vector<GLTF::Image*> getAllImages();
 		std::vector<GLTF::Accessor*> getAllPrimitiveAccessors(GLTF::Primitive* primitive) const;
+		// The getAll* results are cached until this is called, passes on the asset call it after changing
+		// the graph and other code that changes the graph afterwards must call it too
+		void invalidateIndex();
 		void mergeAnimations();
 		void removeUnusedSemantics();
 		void removeUnusedNodes(GLTF::Options* options);
-		GLTF::Buffer* packAccessors();
+		void removeDuplicateMeshes();
+		void removeDuplicateAccessors();
+		void removeDuplicateImages(GLTF::ThreadPool* threadPool);
+		void atlasTextures(GLTF::Options* options, GLTF::ThreadPool* threadPool);
+		void processTextures(GLTF::Options* options, GLTF::ThreadPool* threadPool);
+		void flattenNodes();
+		void batchPrimitives(GLTF::Options* options);
+		void optimizeVertexCache(MeshOptimizer::VertexCacheStatistics* before, MeshOptimizer::VertexCacheStatistics* after);
+		void optimizeVertexFetch();
+		void generateLevelsOfDetail(GLTF::Options* options);
+		void instanceMeshes();
+		void quantizeAttributes(GLTF::Options* options);
+		std::vector<GLTF::Buffer*> packAccessors(GLTF::Options* options);
 
 		// Functions for Draco compression extension.
 		std::vector<GLTF::BufferView*> getAllCompressedBufferView();
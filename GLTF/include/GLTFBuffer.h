@@ -1,15 +1,19 @@
 #pragma once
 
+#include <memory>
+
 #include "GLTFObject.h"
 
 namespace GLTF {
 	class Buffer : public GLTF::Object {
 	public:
 		unsigned char* data = NULL;
-		int byteLength;
+		size_t byteLength;
 		std::string uri;
+		// Keeps adopted storage alive when `data` points into a container rather than its own allocation
+		std::shared_ptr<void> storage;
 
-		Buffer(unsigned char* data, int dataLength);
+		Buffer(unsigned char* data, size_t dataLength);
 		
 		virtual std::string typeName();
 		virtual void writeJSON(void* writer, GLTF::Options* options);
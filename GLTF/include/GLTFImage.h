@@ -1,15 +1,16 @@
 #pragma once
 
+#include <future>
+#include <mutex>
+
 #include "GLTFBufferView.h"
 #include "GLTFObject.h"
+#include "GLTFThreadPool.h"
 
 namespace GLTF {
 	class Image : public GLTF::Object {
 	public:
 		std::string uri;
-		unsigned char* data = NULL;
-		size_t byteLength = 0;
-		std::string mimeType;
 		GLTF::BufferView* bufferView = NULL;
 
 		Image(std::string uri);
@@ -17,14 +18,38 @@ namespace GLTF {
 		virtual ~Image();
 
 		static GLTF::Image* load(path path);
+		void prefetch(GLTF::ThreadPool* threadPool);
+		unsigned char* getData();
+		size_t getByteLength();
+		std::string getMimeType();
 		std::pair<int, int> getDimensions();
+		unsigned long long getContentHash();
+		bool contentEquals(GLTF::Image* other);
+		bool write(path destination);
+		void replaceData(unsigned char* data, size_t byteLength);
 		virtual std::string typeName();
 		virtual void writeJSON(void* writer, GLTF::Options* options);
 
 	private:
 		const std::string cacheKey;
+		unsigned char* _data = NULL;
+		// Data read from the file or replaced later is allocated with malloc and freed by the image
+		bool _ownsData = false;
+		size_t _byteLength = 0;
+		std::string _mimeType;
+		std::string _fileExtension;
+		// Resolved once the file behind a loaded image has been read
+		std::shared_future<void> _loading;
+		std::mutex _loadingMutex;
+		unsigned long long _contentHash = 0;
+		bool _hasContentHash = false;
 
 		Image(std::string uri, std::string cacheKey);
 		Image(std::string uri, std::string cacheKey, unsigned char* data, size_t byteLength, std::string fileExtension);
+
+		void setData(unsigned char* data, size_t byteLength, std::string fileExtension);
+		void read();
+		void ensureLoaded();
+		bool isInMemory();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "GLTFAccessor.h"
+#include "GLTFExtension.h"
+
+namespace GLTF {
+	/**
+	 * The EXT_mesh_gpu_instancing extension on a node, drawing its mesh once for each element of the
+	 * per-instance TRANSLATION, ROTATION and SCALE accessors. Instance transforms are applied before the
+	 * transform of the node.
+	 */
+	class InstancingExtension : public GLTF::Extension {
+	public:
+		std::map<std::string, GLTF::Accessor*> attributes;
+
+		virtual void writeJSON(void* writer, GLTF::Options* options);
+	};
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Base64.h"
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/stream.h"
+
+namespace GLTF {
+	/**
+	 * The writer that glTF objects write their JSON to.
+	 *
+	 * Objects only depend on this interface, so the same document can be written by any rapidjson
+	 * writer to any output stream, compact or pretty printed, by wrapping it in a `JSONWriterAdapter`.
+	 */
+	class JSONWriter {
+	public:
+		virtual ~JSONWriter() {}
+		virtual bool Null() = 0;
+		virtual bool Bool(bool value) = 0;
+		virtual bool Int(int value) = 0;
+		virtual bool Uint(unsigned int value) = 0;
+		virtual bool Int64(int64_t value) = 0;
+		virtual bool Uint64(uint64_t value) = 0;
+		virtual bool Double(double value) = 0;
+		virtual bool String(const char* value) = 0;
+		virtual bool String(const char* value, size_t length) = 0;
+		virtual bool Key(const char* key) = 0;
+		// Writes a base64 data URI string for data without building it in memory first
+		virtual bool DataUri(const char* mimeType, const unsigned char* data, size_t length) = 0;
+		virtual bool StartObject() = 0;
+		virtual bool EndObject() = 0;
+		virtual bool StartArray() = 0;
+		virtual bool EndArray() = 0;
+	};
+
+	template <typename Writer, typename OutputStream>
+	class JSONWriterAdapter : public JSONWriter {
+	public:
+		Writer* writer;
+		// The stream the writer writes to, used to write long strings in chunks
+		OutputStream* stream;
+
+		JSONWriterAdapter(Writer* writer, OutputStream* stream) : writer(writer), stream(stream) {}
+
+		virtual bool Null() { return writer->Null(); }
+		virtual bool Bool(bool value) { return writer->Bool(value); }
+		virtual bool Int(int value) { return writer->Int(value); }
+		virtual bool Uint(unsigned int value) { return writer->Uint(value); }
+		virtual bool Int64(int64_t value) { return writer->Int64(value); }
+		virtual bool Uint64(uint64_t value) { return writer->Uint64(value); }
+		virtual bool Double(double value) { return writer->Double(value); }
+		virtual bool String(const char* value) { return writer->String(value); }
+		virtual bool String(const char* value, size_t length) { return writer->String(value, length); }
+		virtual bool Key(const char* key) { return writer->Key(key); }
+		virtual bool DataUri(const char* mimeType, const unsigned char* data, size_t length) {
+			std::string prefix = std::string("\"data:") + mimeType + ";base64,";
+			// Lets the writer place the separator and opening quote, then appends the rest to the stream
+			if (!writer->RawValue(prefix.c_str(), prefix.length(), rapidjson::kStringType)) {
+				return false;
+			}
+			const size_t chunkLength = 3 * 16384;
+			char* base64 = new char[Base64::encodedLength(chunkLength)];
+			for (size_t offset = 0; offset < length; offset += chunkLength) {
+				size_t base64Length = Base64::encode(data + offset, std::min(chunkLength, length - offset), base64);
+				rapidjson::PutReserve(*stream, base64Length);
+				for (size_t i = 0; i < base64Length; i++) {
+					rapidjson::PutUnsafe(*stream, base64[i]);
+				}
+			}
+			delete[] base64;
+			rapidjson::PutReserve(*stream, 1);
+			rapidjson::PutUnsafe(*stream, '"');
+			return true;
+		}
+		virtual bool StartObject() { return writer->StartObject(); }
+		virtual bool EndObject() { return writer->EndObject(); }
+		virtual bool StartArray() { return writer->StartArray(); }
+		virtual bool EndArray() { return writer->EndArray(); }
+	};
+}
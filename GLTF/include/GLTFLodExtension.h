@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "GLTFExtension.h"
+#include "GLTFNode.h"
+
+namespace GLTF {
+	/**
+	 * The MSFT_lod extension on a node, listing nodes with lower levels of detail from highest to lowest.
+	 */
+	class LodExtension : public GLTF::Extension {
+	public:
+		/**
+		 * The MSFT_screencoverage extra, with the screen coverage at or above which the node and each of
+		 * its lower levels are used. Nothing is drawn below the last value.
+		 */
+		class ScreenCoverage : public GLTF::Object {
+		public:
+			std::vector<float> coverage;
+
+			virtual void writeJSONValue(void* writer, GLTF::Options* options);
+		};
+
+		std::vector<GLTF::Node*> nodes;
+
+		virtual void writeJSON(void* writer, GLTF::Options* options);
+	};
+}
@@ -31,6 +31,7 @@ namespace GLTF {
 			float* transparency = NULL;
 			GLTF::Texture* bumpTexture = NULL;
 
+			bool equals(GLTF::Material::Values* values);
 			void writeJSON(void* writer, GLTF::Options* options);
 		};
 
@@ -41,6 +42,8 @@ namespace GLTF {
 
 		Material();
 		bool hasTexture();
+		// Whether two materials render the same, regardless of their names
+		virtual bool equals(GLTF::Material* material);
 		virtual std::string typeName();
 		virtual void writeJSON(void* writer, GLTF::Options* options);
 	};
@@ -53,6 +56,7 @@ namespace GLTF {
 			GLTF::Texture* texture = NULL;
 			int texCoord = -1;
 
+			bool equals(Texture* texture);
 			void writeJSON(void* writer, GLTF::Options* options);
 		};
 
@@ -94,6 +98,7 @@ namespace GLTF {
 		bool doubleSided = false;
 
 		MaterialPBR();
+		virtual bool equals(GLTF::Material* material);
 		void writeJSON(void* writer, GLTF::Options* options);
 	};
 
@@ -134,6 +139,7 @@ namespace GLTF {
 		MaterialCommon::Technique technique = MaterialCommon::Technique::UNKNOWN;
 
 		MaterialCommon();
+		virtual bool equals(GLTF::Material* material);
 		const char* getTechniqueName();
 		GLTF::Material* getMaterial(std::vector<GLTF::MaterialCommon::Light*> lights, GLTF::Options* options);
 		GLTF::Material* getMaterial(std::vector<GLTF::MaterialCommon::Light*> lights, bool hasColorAttribute, GLTF::Options* options);
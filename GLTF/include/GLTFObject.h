@@ -20,5 +20,6 @@ namespace GLTF {
 		virtual std::string typeName();
 		virtual GLTF::Object* clone(GLTF::Object* clone);
 		virtual void writeJSON(void* writer, GLTF::Options* options);
+		virtual void writeJSONValue(void* writer, GLTF::Options* options);
 	};
 }
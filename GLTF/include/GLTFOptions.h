@@ -21,7 +21,38 @@ namespace GLTF {
 		bool specularGlossiness = false;
 		std::string version = "2.0";
 		std::vector<std::string> metallicRoughnessTexturePaths;
-		// For Draco compression extension.
+		int threads = 1;
+		bool removeDuplicateMeshes = false;
+		bool removeDuplicateAccessors = false;
+		bool removeDuplicateImages = false;
+		// Pack diffuse textures of at most atlasMaxTextureSize pixels into atlases of at most atlasSize pixels
+		bool atlasTextures = false;
+		int atlasMaxTextureSize = 512;
+		int atlasSize = 2048;
+		// Scale textures down so neither dimension is larger than this many pixels, 0 keeps their size
+		int maxTextureSize = 0;
+		// Resize textures to the nearest power of two in each dimension
+		bool powerOfTwoTextures = false;
+		// Collapse sibling nodes that share a mesh into one node with the EXT_mesh_gpu_instancing extension
+		bool gpuInstancing = false;
+		// Bake static node transforms into vertex data and flatten the node hierarchy
+		bool flatten = false;
+		// Store the vertex attributes of each primitive in one interleaved bufferView
+		bool interleave = false;
+		// Split the packed data into buffers of at most this many megabytes, 0 keeps a single buffer
+		int maxBufferSize = 0;
+		// Merge primitives of static nodes that share a material to reduce draw calls
+		bool batchPrimitives = false;
+		int batchMaxVertices = 65535;
+		bool optimizeVertexCache = false;
+		bool optimizeVertexFetch = false;
+		// Levels of detail written with the MSFT_lod extension
+		int lodLevels = 0;
+		float lodRatio = 0.5;
+		float lodError = 0.01;
+		// Store attributes as normalized integers with the KHR_mesh_quantization extension
+		bool meshQuantization = false;
+		// For Draco compression extension, the attribute bits are also used by mesh quantization.
 		bool dracoCompression = false;
 		int positionQuantizationBits = 14;
 		int normalQuantizationBits = 10;
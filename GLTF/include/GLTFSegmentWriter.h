@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace GLTF {
+	/**
+	 * A list of memory ranges that are written to a file back to back without being copied into
+	 * a single buffer first.
+	 *
+	 * The ranges are only referenced, so they must stay alive until the segments are written.
+	 */
+	class SegmentWriter {
+	public:
+		void append(const void* data, size_t length);
+		void append(SegmentWriter* segments);
+		// Appends up to three bytes of padding filled with value
+		void appendPadding(size_t length, char value);
+		size_t length();
+		bool write(FILE* file);
+
+	private:
+		std::vector<std::pair<const void*, size_t>> _segments;
+		size_t _length = 0;
+	};
+}
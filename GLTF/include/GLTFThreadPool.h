@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace GLTF {
+	/**
+	 * A fixed set of worker threads that run queued tasks in the order they were enqueued.
+	 *
+	 * A pool with no threads runs each task on the calling thread as it is enqueued.
+	 */
+	class ThreadPool {
+	public:
+		ThreadPool(int threadCount);
+		~ThreadPool();
+
+		int size();
+
+		template<typename F>
+		std::future<typename std::result_of<F()>::type> enqueue(F task) {
+			typedef typename std::result_of<F()>::type Result;
+			std::shared_ptr<std::packaged_task<Result()>> packagedTask(new std::packaged_task<Result()>(task));
+			std::future<Result> result = packagedTask->get_future();
+			if (_workers.size() == 0) {
+				(*packagedTask)();
+			}
+			else {
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_tasks.push([packagedTask]() {
+						(*packagedTask)();
+					});
+				}
+				_condition.notify_one();
+			}
+			return result;
+		}
+
+	private:
+		std::vector<std::thread> _workers;
+		std::queue<std::function<void()>> _tasks;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stopping = false;
+
+		void work();
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ImageCodec {
+	/**
+	 * An image decoded to 8-bit RGBA, with rows stored from top to bottom.
+	 */
+	struct Pixels {
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> rgba;
+	};
+
+	/**
+	 * Decodes a PNG of any standard color type and bit depth, interlaced or not. Sixteen bit
+	 * channels keep their most significant byte.
+	 *
+	 * @return `false` if the data is not a PNG this decoder understands
+	 */
+	bool decodePNG(const unsigned char* data, size_t length, Pixels* pixels);
+
+	/**
+	 * Decodes a baseline or extended sequential Huffman JPEG with one or three components.
+	 * Progressive, arithmetic coded and CMYK JPEGs are not supported.
+	 *
+	 * @return `false` if the data is not a JPEG this decoder understands
+	 */
+	bool decodeJPEG(const unsigned char* data, size_t length, Pixels* pixels);
+
+	/**
+	 * Decodes a PNG or JPEG, detected from its signature.
+	 */
+	bool decode(const unsigned char* data, size_t length, Pixels* pixels);
+
+	/**
+	 * Encodes an RGBA PNG with adaptive row filters, compressed with fixed Huffman codes.
+	 */
+	std::vector<unsigned char> encodePNG(const Pixels& pixels);
+
+	/**
+	 * Encodes a baseline JPEG with the standard tables scaled to a quality between 1 and 100.
+	 * Alpha is dropped.
+	 */
+	std::vector<unsigned char> encodeJPEG(const Pixels& pixels, int quality);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace MeshOptimizer {
+	/**
+	 * Post-transform vertex cache statistics for a triangle list, simulated with a FIFO cache.
+	 * ACMR is the number of cache misses per triangle and ATVR is the number of cache misses per
+	 * referenced vertex, where 1.0 is optimal.
+	 */
+	struct VertexCacheStatistics {
+		size_t triangleCount = 0;
+		size_t vertexCount = 0;
+		size_t cacheMisses = 0;
+		float acmr = 0;
+		float atvr = 0;
+	};
+
+	VertexCacheStatistics analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = 16);
+
+	/**
+	 * Reorders the triangles of a triangle list in place to improve post-transform vertex cache
+	 * hit rates, using Tom Forsyth's linear-speed vertex cache optimization. The winding of
+	 * each triangle is preserved.
+	 */
+	void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+	/**
+	 * Computes a new vertex order that follows the order in which a list of indices first uses each
+	 * vertex. Vertices that are never used keep their relative order after the used vertices.
+	 *
+	 * @return The new index of each vertex
+	 */
+	std::vector<unsigned int> computeVertexFetchRemap(const unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+	/**
+	 * Simplifies a triangle list by collapsing edges in order of their quadric error. Edges only
+	 * collapse onto existing vertices, so the result can share the vertex attributes of the input.
+	 * Vertices on attribute seams collapse together with the matching vertices on the other side of the
+	 * seam, and open borders only collapse along themselves.
+	 *
+	 * @param positions Vertex positions, with `positionStride` floats between vertices
+	 * @param targetIndexCount Stop once there are this many indices or fewer
+	 * @param targetError The largest error allowed, as a fraction of the size of the mesh
+	 * @param resultError Receives the error of the simplified triangles, as a fraction of the size of the mesh
+	 * @return The indices of the simplified triangles
+	 */
+	std::vector<unsigned int> simplify(const unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "ImageCodec.h"
+
+namespace TextureProcessor {
+	/**
+	 * Where packAtlases placed an image: the atlas it is in, or -1 if it didn't fit in one, and the
+	 * position of its top left pixel inside the padding.
+	 */
+	struct AtlasPlacement {
+		int atlas = -1;
+		int x = 0;
+		int y = 0;
+	};
+
+	/**
+	 * Gets the size an image is processed to. Images larger than the maximum are scaled down to fit
+	 * it, keeping their aspect ratio, and each dimension is then optionally rounded to the nearest
+	 * power of two that doesn't exceed the maximum.
+	 *
+	 * @param maxSize The largest width or height, or 0 for no limit
+	 */
+	std::pair<int, int> getTargetSize(int width, int height, int maxSize, bool powerOfTwo);
+
+	/**
+	 * Resamples an image, averaging the pixels each output pixel covers when shrinking and
+	 * interpolating bilinearly when growing. sRGB color is filtered in linear light and weighted by
+	 * alpha so that transparent pixels don't bleed into their neighbours, while the channels of
+	 * linear images are filtered independently.
+	 */
+	ImageCodec::Pixels resize(const ImageCodec::Pixels& pixels, int width, int height, bool srgb);
+
+	/**
+	 * Packs images into as few atlases as it can, on shelves filled from the tallest image down, with
+	 * padding around each image. Images that don't fit in an atlas with their padding aren't placed.
+	 *
+	 * @param sizes The width and height of each image
+	 * @param atlasSize The largest width or height of an atlas
+	 * @param placements Set to the placement of each image
+	 * @return The width and height each atlas needs
+	 */
+	std::vector<std::pair<int, int>> packAtlases(const std::vector<std::pair<int, int>>& sizes, int atlasSize, int padding, std::vector<AtlasPlacement>* placements);
+
+	/**
+	 * Copies an image into an atlas with its top left pixel at x and y, repeating its edge pixels
+	 * into the padding around it so that filtering doesn't blend in neighbouring images.
+	 */
+	void blit(const ImageCodec::Pixels& image, ImageCodec::Pixels* atlas, int x, int y, int padding);
+}
@@ -1,47 +1,134 @@
 #include "Base64.h"
 
-#include <cmath>
+#include <cctype>
 
 static inline bool is_base64(unsigned char c) {
 	return (isalnum(c) || (c == '+') || (c == '/'));
 }
 
 static const std::string base64CharSet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-char* Base64::encode(unsigned char* data, size_t length) {
-	size_t base64Length = (size_t)(ceil(length / 3.0) * 4) + 1;
-	char* base64 = new char[base64Length];
-	int index;
-	int j = 0;
-	for (size_t i = 0; i < length; i += 3) {
-		index = (data[i] & 0xFC) >> 2;
-		base64[j] = base64CharSet[index];
-		j++;
-		index = (data[i] & 0x03) << 4;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_SIMD
+#include <immintrin.h>
+
+/**
+ * Splits the first 12 bytes of each 128-bit lane into sixteen 6-bit indices and maps them to
+ * the base64 alphabet, see http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+ */
+__attribute__((target("ssse3")))
+static inline __m128i encodeLane(__m128i in) {
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	__m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+	__m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+	__m128i indices = _mm_or_si128(high, low);
+
+	__m128i offsetIndex = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	__m128i uppercase = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+	offsetIndex = _mm_or_si128(offsetIndex, _mm_and_si128(uppercase, _mm_set1_epi8(13)));
+	__m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	return _mm_add_epi8(_mm_shuffle_epi8(offsets, offsetIndex), indices);
+}
+
+/**
+ * Encodes 12 bytes into 16 characters per iteration, returning the number of bytes consumed.
+ */
+__attribute__((target("ssse3")))
+static size_t encodeSSSE3(const unsigned char* data, size_t length, char* destination) {
+	size_t i = 0;
+	// Each load reads 16 bytes to use 12 of them
+	for (; i + 16 <= length; i += 12) {
+		__m128i in = _mm_loadu_si128((const __m128i*)(data + i));
+		_mm_storeu_si128((__m128i*)destination, encodeLane(in));
+		destination += 16;
+	}
+	return i;
+}
+
+/**
+ * Encodes 24 bytes into 32 characters per iteration, returning the number of bytes consumed.
+ */
+__attribute__((target("avx2")))
+static size_t encodeAVX2(const unsigned char* data, size_t length, char* destination) {
+	const __m256i shuffle = _mm256_set_epi8(
+		10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+		10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m256i offsets = _mm256_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	size_t i = 0;
+	// The upper lane reads 16 bytes starting 12 bytes in
+	for (; i + 28 <= length; i += 24) {
+		__m128i lower = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i upper = _mm_loadu_si128((const __m128i*)(data + i + 12));
+		__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lower), upper, 1);
+		in = _mm256_shuffle_epi8(in, shuffle);
+		__m256i high = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		__m256i low = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		__m256i indices = _mm256_or_si256(high, low);
+
+		__m256i offsetIndex = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		__m256i uppercase = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+		offsetIndex = _mm256_or_si256(offsetIndex, _mm256_and_si256(uppercase, _mm256_set1_epi8(13)));
+		_mm256_storeu_si256((__m256i*)destination, _mm256_add_epi8(_mm256_shuffle_epi8(offsets, offsetIndex), indices));
+		destination += 32;
+	}
+	return i;
+}
+#endif
+
+/**
+ * Encodes whole groups of three bytes and pads the final group.
+ */
+static size_t encodeScalar(const unsigned char* data, size_t length, char* destination) {
+	size_t j = 0;
+	size_t i = 0;
+	for (; i + 3 <= length; i += 3) {
+		destination[j++] = base64CharSet[data[i] >> 2];
+		destination[j++] = base64CharSet[((data[i] & 0x03) << 4) | (data[i + 1] >> 4)];
+		destination[j++] = base64CharSet[((data[i + 1] & 0x0F) << 2) | (data[i + 2] >> 6)];
+		destination[j++] = base64CharSet[data[i + 2] & 0x3F];
+	}
+	if (i < length) {
+		destination[j++] = base64CharSet[data[i] >> 2];
 		if (i + 1 < length) {
-			index |= (data[i + 1] & 0xF0) >> 4;
-			base64[j] = base64CharSet[index];
-			j++;
-			index = (data[i + 1] & 0x0F) << 2;
-			if (i + 2 < length) {
-				index |= (data[i + 2] & 0xC0) >> 6;
-				base64[j] = base64CharSet[index];
-				j++;
-				index = data[i + 2] & 0x3F;
-				base64[j] = base64CharSet[index];
-				j++;
-			}
-			else {
-				base64[j] = base64CharSet[index];
-				base64[j + 1] = '=';
-			}
+			destination[j++] = base64CharSet[((data[i] & 0x03) << 4) | (data[i + 1] >> 4)];
+			destination[j++] = base64CharSet[(data[i + 1] & 0x0F) << 2];
 		}
 		else {
-			base64[j] = base64CharSet[index];
-			base64[j + 1] = '=';
-			base64[j + 2] = '=';
+			destination[j++] = base64CharSet[(data[i] & 0x03) << 4];
+			destination[j++] = '=';
 		}
+		destination[j++] = '=';
+	}
+	return j;
+}
+
+size_t Base64::encodedLength(size_t length) {
+	return (length + 2) / 3 * 4;
+}
+
+size_t Base64::encode(const unsigned char* data, size_t length, char* destination) {
+	size_t i = 0;
+#ifdef BASE64_SIMD
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	static const bool hasSSSE3 = __builtin_cpu_supports("ssse3");
+	if (hasAVX2) {
+		i = encodeAVX2(data, length, destination);
 	}
-	base64[base64Length - 1] = '\0';
+	if (hasSSSE3) {
+		i += encodeSSSE3(data + i, length - i, destination + i / 3 * 4);
+	}
+#endif
+	return i / 3 * 4 + encodeScalar(data + i, length - i, destination + i / 3 * 4);
+}
+
+std::string Base64::encode(const unsigned char* data, size_t length) {
+	std::string base64(encodedLength(length), '\0');
+	encode(data, length, &base64[0]);
 	return base64;
 }
 
@@ -3,11 +3,11 @@
 #include <cstring>
 #include <set>
 #include <stdlib.h>
+#include <vector>
 
 #include "GLTFAccessor.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 	GLTF::Constants::WebGL componentType
@@ -16,10 +16,10 @@ GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 	GLTF::Constants::WebGL componentType,
 	unsigned char* data,
-	int count,
+	size_t count,
 	GLTF::Constants::WebGL target
 ) : Accessor(type, componentType) {
-	int byteLength = count * this->getNumberOfComponents() * this->getComponentByteLength();
+	size_t byteLength = count * this->getNumberOfComponents() * this->getComponentByteLength();
 	unsigned char* allocatedData = (unsigned char*)malloc(byteLength);
 	std::memcpy(allocatedData, data, byteLength);
 	this->bufferView = new GLTF::BufferView(allocatedData, byteLength, target);
@@ -30,7 +30,7 @@ GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 	GLTF::Constants::WebGL componentType,
 	unsigned char* data,
-	int count,
+	size_t count,
 	GLTF::BufferView* bufferView
 ) : Accessor(type, componentType) {
 	GLTF::Buffer* buffer = bufferView->buffer;
@@ -38,9 +38,9 @@ GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 	this->byteOffset = bufferView->byteLength;
 	this->count = count;
 	int componentByteLength = this->getComponentByteLength();
-	int byteLength = count * this->getNumberOfComponents() * componentByteLength;
+	size_t byteLength = count * this->getNumberOfComponents() * componentByteLength;
 
-	int padding = byteOffset % componentByteLength;
+	size_t padding = byteOffset % componentByteLength;
 	if (padding != 0) {
 		padding = componentByteLength - padding;
 	}
@@ -55,8 +55,27 @@ GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 
 GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 	GLTF::Constants::WebGL componentType,
-	int byteOffset,
-	int count,
+	std::unique_ptr<unsigned char[]> data,
+	size_t count,
+	GLTF::Constants::WebGL target
+) : Accessor(type, componentType) {
+	size_t byteLength = count * this->getNumberOfComponents() * this->getComponentByteLength();
+	std::shared_ptr<unsigned char> storage(data.release(), std::default_delete<unsigned char[]>());
+	adoptData(storage.get(), byteLength, storage, target);
+}
+
+void GLTF::Accessor::adoptData(unsigned char* data, size_t byteLength, std::shared_ptr<void> storage, GLTF::Constants::WebGL target) {
+	this->bufferView = new GLTF::BufferView(0, byteLength, new GLTF::Buffer(data, byteLength));
+	this->bufferView->buffer->storage = storage;
+	this->bufferView->target = target;
+	this->count = byteLength / (this->getNumberOfComponents() * this->getComponentByteLength());
+	this->computeMinMax();
+}
+
+GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
+	GLTF::Constants::WebGL componentType,
+	size_t byteOffset,
+	size_t count,
 	GLTF::BufferView* bufferView
 ) : Accessor(type, componentType) {
 	this->byteOffset = byteOffset;
@@ -66,7 +85,7 @@ GLTF::Accessor::Accessor(GLTF::Accessor::Type type,
 
 bool GLTF::Accessor::computeMinMax() {
 	int numberOfComponents = this->getNumberOfComponents();
-	int count = this->count;
+	size_t count = this->count;
 	if (count > 0) {
 		if (max == NULL) {
 			max = new float[numberOfComponents];
@@ -80,13 +99,14 @@ bool GLTF::Accessor::computeMinMax() {
 			min[i] = component[i];
 			max[i] = component[i];
 		}
-		for (int i = 1; i < this->count; i++) {
+		for (size_t i = 1; i < this->count; i++) {
 			this->getComponentAtIndex(i, component);
 			for (int j = 0; j < numberOfComponents; j++) {
 				min[j] = std::min(component[j], min[j]);
 				max[j] = std::max(component[j], max[j]);
 			}
 		}
+		delete[] component;
 	}
 	return true;
 }
@@ -98,8 +118,8 @@ int GLTF::Accessor::getByteStride() {
 	return this->bufferView->byteStride;
 }
 
-bool GLTF::Accessor::getComponentAtIndex(int index, float* component) {
-	int byteOffset = this->byteOffset + this->bufferView->byteOffset;
+bool GLTF::Accessor::getComponentAtIndex(size_t index, float* component) {
+	size_t byteOffset = this->byteOffset + this->bufferView->byteOffset;
 	int numberOfComponents = this->getNumberOfComponents();
 	byteOffset += this->getByteStride() * index;
 	unsigned char* buf = this->bufferView->buffer->data + byteOffset;
@@ -107,7 +127,7 @@ bool GLTF::Accessor::getComponentAtIndex(int index, float* component) {
 	for (int i = 0; i < numberOfComponents; i++) {
 		switch (this->componentType) {
 		case GLTF::Constants::WebGL::BYTE:
-			component[i] = (float)((char*)buf)[i];
+			component[i] = (float)((signed char*)buf)[i];
 			break;
 		case GLTF::Constants::WebGL::UNSIGNED_BYTE:
 			component[i] = (float)buf[i];
@@ -131,8 +151,8 @@ bool GLTF::Accessor::getComponentAtIndex(int index, float* component) {
 	return true;
 }
 
-bool GLTF::Accessor::writeComponentAtIndex(int index, float* component) {
-	int byteOffset = this->byteOffset + this->bufferView->byteOffset;
+bool GLTF::Accessor::writeComponentAtIndex(size_t index, float* component) {
+	size_t byteOffset = this->byteOffset + this->bufferView->byteOffset;
 	int numberOfComponents = this->getNumberOfComponents();
 	byteOffset += this->getByteStride() * index;
 	unsigned char* buf = this->bufferView->buffer->data + byteOffset;
@@ -140,7 +160,7 @@ bool GLTF::Accessor::writeComponentAtIndex(int index, float* component) {
 	for (int i = 0; i < numberOfComponents; i++) {
 		switch (this->componentType) {
 		case GLTF::Constants::WebGL::BYTE:
-			buf[i] = (char)component[i];
+			((signed char*)buf)[i] = (signed char)component[i];
 			break;
 		case GLTF::Constants::WebGL::UNSIGNED_BYTE:
 			buf[i] = (unsigned char)component[i];
@@ -231,11 +251,11 @@ bool GLTF::Accessor::equals(GLTF::Accessor* accessor) {
 		return false;
 	}
 	int numberOfComponents = getNumberOfComponents();
-	float* componentOne = new float[numberOfComponents];
-	float* componentTwo = new float[numberOfComponents];
-	for (int i = 0; i < count; i++) {
-		this->getComponentAtIndex(i, componentOne);
-		accessor->getComponentAtIndex(i, componentTwo);
+	std::vector<float> componentOne(numberOfComponents);
+	std::vector<float> componentTwo(numberOfComponents);
+	for (size_t i = 0; i < count; i++) {
+		this->getComponentAtIndex(i, &componentOne[0]);
+		accessor->getComponentAtIndex(i, &componentTwo[0]);
 		for (int j = 0; j < numberOfComponents; j++) {
 			if (componentOne[j] != componentTwo[j]) {
 				return false;
@@ -250,7 +270,7 @@ std::string GLTF::Accessor::typeName() {
 }
 
 void GLTF::Accessor::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (this->bufferView) {
 		jsonWriter->Key("bufferView");
 		if (options->version == "1.0") {
@@ -260,7 +280,7 @@ void GLTF::Accessor::writeJSON(void* writer, GLTF::Options* options) {
 			jsonWriter->Int(this->bufferView->id);
 		}
 		jsonWriter->Key("byteOffset");
-		jsonWriter->Int(this->byteOffset);
+		jsonWriter->Uint64(this->byteOffset);
 	}
 	if (options->version == "1.0") {
 		int byteStride = bufferView->byteStride;
@@ -272,7 +292,11 @@ void GLTF::Accessor::writeJSON(void* writer, GLTF::Options* options) {
 	jsonWriter->Key("componentType");
 	jsonWriter->Int((int)this->componentType);
 	jsonWriter->Key("count");
-	jsonWriter->Int(this->count);
+	jsonWriter->Uint64(this->count);
+	if (this->normalized) {
+		jsonWriter->Key("normalized");
+		jsonWriter->Bool(true);
+	}
 	if (this->max) {
 		jsonWriter->Key("max");
 		jsonWriter->StartArray();
@@ -1,7 +1,6 @@
 #include "GLTFAnimation.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string pathString(GLTF::Animation::Path path) {
 	switch (path) {
@@ -22,7 +21,7 @@ std::string GLTF::Animation::typeName() {
 }
 
 void GLTF::Animation::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("channels");
 	jsonWriter->StartArray();
@@ -120,7 +119,7 @@ std::string GLTF::Animation::Sampler::typeName() {
 }
 
 void GLTF::Animation::Sampler::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("input");
 	if (options->version == "1.0") {
@@ -142,7 +141,7 @@ void GLTF::Animation::Sampler::writeJSON(void* writer, GLTF::Options* options) {
 }
 
 void GLTF::Animation::Channel::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("sampler");
 	if (options->version == "1.0") {
@@ -160,7 +159,7 @@ void GLTF::Animation::Channel::writeJSON(void* writer, GLTF::Options* options) {
 }
 
 void GLTF::Animation::Channel::Target::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	
 	if (options->version == "1.0") {
 		jsonWriter->Key("id");
@@ -1,12 +1,20 @@
 #include "GLTFAsset.h"
+#include "GLTFInstancingExtension.h"
+#include "GLTFLodExtension.h"
+#include "ImageCodec.h"
+#include "TextureProcessor.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <functional>
+#include <iostream>
 #include <map>
 #include <set>
+#include <tuple>
+#include <unordered_set>
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::map<GLTF::Image*, GLTF::Texture*> _pbrTextureCache;
 
@@ -16,7 +24,7 @@ GLTF::Asset::Asset() {
 }
 
 void GLTF::Asset::Metadata::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (options->version != "") {
 		version = options->version;
 	}
@@ -59,63 +67,33 @@ GLTF::Scene* GLTF::Asset::getDefaultScene() {
 	return scene;
 }
 
-std::vector<GLTF::Accessor*> GLTF::Asset::getAllAccessors() {
-	std::set<GLTF::Accessor*> uniqueAccessors;
-	std::vector<GLTF::Accessor*> accessors;
-	for (GLTF::Skin* skin : getAllSkins()) {
-		GLTF::Accessor* inverseBindMatrices = skin->inverseBindMatrices;
-		if (inverseBindMatrices != NULL) {
-			if (uniqueAccessors.find(inverseBindMatrices) == uniqueAccessors.end()) {
-				accessors.push_back(inverseBindMatrices);
-				uniqueAccessors.insert(inverseBindMatrices);
-			}
-		}
-	}
-
-	for (GLTF::Primitive* primitive : getAllPrimitives()) {
-		for (auto* accessor: getAllPrimitiveAccessors(primitive)) {
-			if (uniqueAccessors.find(accessor) == uniqueAccessors.end()) {
-				accessors.push_back(accessor);
-				uniqueAccessors.insert(accessor);
-			}
-		}
-		GLTF::Accessor* indicesAccessor = primitive->indices;
-		if (indicesAccessor != NULL) {
-			if (uniqueAccessors.find(indicesAccessor) == uniqueAccessors.end()) {
-				accessors.push_back(indicesAccessor);
-				uniqueAccessors.insert(indicesAccessor);
-			}
-		}
-	}
-
-	for (GLTF::Animation* animation : animations) {
-		for (GLTF::Animation::Channel* channel : animation->channels) {
-			GLTF::Animation::Sampler* sampler = channel->sampler;
-			if (uniqueAccessors.find(sampler->input) == uniqueAccessors.end()) {
-				accessors.push_back(sampler->input);
-				uniqueAccessors.insert(sampler->input);
-			}
-			if (uniqueAccessors.find(sampler->output) == uniqueAccessors.end()) {
-				accessors.push_back(sampler->output);
-				uniqueAccessors.insert(sampler->input);
-			}
-		}
-	}
-	return accessors;
-}
+void GLTF::Asset::buildIndex() {
+	_nodes.clear();
+	_meshes.clear();
+	_primitives.clear();
+	_skins.clear();
+	_materials.clear();
+	_techniques.clear();
+	_programs.clear();
+	_shaders.clear();
+	_textures.clear();
+	_images.clear();
+	_accessors.clear();
+
+	// Every object is only ever reached as one type, so a single set tracks all of them
+	std::unordered_set<GLTF::Object*> visited;
+	auto visit = [&visited](GLTF::Object* object) {
+		return object != NULL && visited.insert(object).second;
+	};
 
-std::vector<GLTF::Node*> GLTF::Asset::getAllNodes() {
 	std::vector<GLTF::Node*> nodeStack;
-	std::vector<GLTF::Node*> nodes;
-	std::set<GLTF::Node*> uniqueNodes;
 	for (GLTF::Node* node : getDefaultScene()->nodes) {
 		nodeStack.push_back(node);
 	}
 	while (nodeStack.size() > 0) {
 		GLTF::Node* node = nodeStack.back();
-		if (uniqueNodes.find(node) == uniqueNodes.end()) {
-			nodes.push_back(node);
-			uniqueNodes.insert(node);
+		if (visit(node)) {
+			_nodes.push_back(node);
 		}
 		nodeStack.pop_back();
 		for (GLTF::Node* child : node->children) {
@@ -131,218 +109,201 @@ std::vector<GLTF::Node*> GLTF::Asset::getAllNodes() {
 				nodeStack.push_back(jointNode);
 			}
 		}
+		auto findLod = node->extensions.find("MSFT_lod");
+		if (findLod != node->extensions.end()) {
+			for (GLTF::Node* lodNode : ((GLTF::LodExtension*)findLod->second)->nodes) {
+				nodeStack.push_back(lodNode);
+			}
+		}
 	}
-	return nodes;
-}
 
-std::vector<GLTF::Mesh*> GLTF::Asset::getAllMeshes() {
-	std::vector<GLTF::Mesh*> meshes;
-	std::set<GLTF::Mesh*> uniqueMeshes;
-	for (GLTF::Node* node : getAllNodes()) {
-		if (node->mesh != NULL) {
-			if (uniqueMeshes.find(node->mesh) == uniqueMeshes.end()) {
-				meshes.push_back(node->mesh);
-				uniqueMeshes.insert(node->mesh);
+	for (GLTF::Node* node : _nodes) {
+		if (visit(node->mesh)) {
+			_meshes.push_back(node->mesh);
+		}
+		if (visit(node->skin)) {
+			_skins.push_back(node->skin);
+		}
+	}
+	for (GLTF::Mesh* mesh : _meshes) {
+		for (GLTF::Primitive* primitive : mesh->primitives) {
+			if (visit(primitive)) {
+				_primitives.push_back(primitive);
 			}
 		}
 	}
-	return meshes;
-}
+	for (GLTF::Primitive* primitive : _primitives) {
+		if (visit(primitive->material)) {
+			_materials.push_back(primitive->material);
+		}
+	}
+	for (GLTF::Material* material : _materials) {
+		if (visit(material->technique)) {
+			_techniques.push_back(material->technique);
+		}
+	}
+	for (GLTF::Technique* technique : _techniques) {
+		if (visit(technique->program)) {
+			_programs.push_back(technique->program);
+		}
+	}
+	for (GLTF::Program* program : _programs) {
+		if (visit(program->vertexShader)) {
+			_shaders.push_back(program->vertexShader);
+		}
+		if (visit(program->fragmentShader)) {
+			_shaders.push_back(program->fragmentShader);
+		}
+	}
 
-std::vector<GLTF::Primitive*> GLTF::Asset::getAllPrimitives() {
-	std::vector<GLTF::Primitive*> primitives;
-	std::set<GLTF::Primitive*> uniquePrimitives;
-	for (GLTF::Mesh* mesh : getAllMeshes()) {
-		for (GLTF::Primitive* primitive : mesh->primitives) {
-			if (uniquePrimitives.find(primitive) == uniquePrimitives.end()) {
-				primitives.push_back(primitive);
-				uniquePrimitives.insert(primitive);
+	auto visitTexture = [&](GLTF::Texture* texture) {
+		if (visit(texture)) {
+			_textures.push_back(texture);
+		}
+	};
+	for (GLTF::Material* material : _materials) {
+		if (material->type == GLTF::Material::MATERIAL || material->type == GLTF::Material::MATERIAL_COMMON) {
+			GLTF::Material::Values* values = material->values;
+			visitTexture(values->ambientTexture);
+			visitTexture(values->diffuseTexture);
+			visitTexture(values->emissionTexture);
+			visitTexture(values->specularTexture);
+			visitTexture(values->bumpTexture);
+		}
+		else if (material->type == GLTF::Material::PBR_METALLIC_ROUGHNESS) {
+			GLTF::MaterialPBR* materialPBR = (GLTF::MaterialPBR*)material;
+			std::vector<GLTF::MaterialPBR::Texture*> pbrTextures = {
+				materialPBR->metallicRoughness->baseColorTexture,
+				materialPBR->metallicRoughness->metallicRoughnessTexture,
+				materialPBR->emissiveTexture,
+				materialPBR->normalTexture,
+				materialPBR->occlusionTexture,
+				materialPBR->specularGlossiness->diffuseTexture,
+				materialPBR->specularGlossiness->specularGlossinessTexture
+			};
+			for (GLTF::MaterialPBR::Texture* pbrTexture : pbrTextures) {
+				if (pbrTexture != NULL) {
+					visitTexture(pbrTexture->texture);
+				}
 			}
 		}
 	}
-	return primitives;
-}
+	for (GLTF::Texture* texture : _textures) {
+		if (visit(texture->source)) {
+			_images.push_back(texture->source);
+		}
+	}
 
-std::vector<GLTF::Skin*> GLTF::Asset::getAllSkins() {
-	std::vector<GLTF::Skin*> skins;
-	std::set<GLTF::Skin*> uniqueSkins;
-	for (GLTF::Node* node : getAllNodes()) {
-		GLTF::Skin* skin = node->skin;
-		if (skin != NULL) {
-			if (uniqueSkins.find(skin) == uniqueSkins.end()) {
-				skins.push_back(skin);
-				uniqueSkins.insert(skin);
+	auto visitAccessor = [&](GLTF::Accessor* accessor) {
+		if (visit(accessor)) {
+			_accessors.push_back(accessor);
+		}
+	};
+	for (GLTF::Skin* skin : _skins) {
+		visitAccessor(skin->inverseBindMatrices);
+	}
+	for (GLTF::Primitive* primitive : _primitives) {
+		for (GLTF::Accessor* accessor : getAllPrimitiveAccessors(primitive)) {
+			visitAccessor(accessor);
+		}
+		visitAccessor(primitive->indices);
+	}
+	for (GLTF::Node* node : _nodes) {
+		auto findInstancing = node->extensions.find("EXT_mesh_gpu_instancing");
+		if (findInstancing != node->extensions.end()) {
+			for (const auto& attribute : ((GLTF::InstancingExtension*)findInstancing->second)->attributes) {
+				visitAccessor(attribute.second);
 			}
 		}
 	}
-	return skins;
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			visitAccessor(channel->sampler->input);
+			visitAccessor(channel->sampler->output);
+		}
+	}
+	_indexed = true;
+}
+
+void GLTF::Asset::invalidateIndex() {
+	_indexed = false;
+}
+
+std::vector<GLTF::Accessor*> GLTF::Asset::getAllAccessors() {
+	if (!_indexed) {
+		buildIndex();
+	}
+	return _accessors;
+}
+
+std::vector<GLTF::Node*> GLTF::Asset::getAllNodes() {
+	if (!_indexed) {
+		buildIndex();
+	}
+	return _nodes;
+}
+
+std::vector<GLTF::Mesh*> GLTF::Asset::getAllMeshes() {
+	if (!_indexed) {
+		buildIndex();
+	}
+	return _meshes;
+}
+
+std::vector<GLTF::Primitive*> GLTF::Asset::getAllPrimitives() {
+	if (!_indexed) {
+		buildIndex();
+	}
+	return _primitives;
+}
+
+std::vector<GLTF::Skin*> GLTF::Asset::getAllSkins() {
+	if (!_indexed) {
+		buildIndex();
+	}
+	return _skins;
 }
 
 std::vector<GLTF::Material*> GLTF::Asset::getAllMaterials() {
-	std::vector<GLTF::Material*> materials;
-	std::set<GLTF::Material*> uniqueMaterials;
-	for (GLTF::Primitive* primitive : getAllPrimitives()) {
-		GLTF::Material* material = primitive->material;
-		if (material != NULL) {
-			if (uniqueMaterials.find(material) == uniqueMaterials.end()) {
-				materials.push_back(material);
-				uniqueMaterials.insert(material);
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return materials;
+	return _materials;
 }
 
 std::vector<GLTF::Technique*> GLTF::Asset::getAllTechniques() {
-	std::vector<GLTF::Technique*> techniques;
-	std::set<GLTF::Technique*> uniqueTechniques;
-	for (GLTF::Material* material : getAllMaterials()) {
-		GLTF::Technique* technique = material->technique;
-		if (technique != NULL) {
-			if (uniqueTechniques.find(technique) == uniqueTechniques.end()) {
-				techniques.push_back(technique);
-				uniqueTechniques.insert(technique);
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return techniques;
+	return _techniques;
 }
 
 std::vector<GLTF::Program*> GLTF::Asset::getAllPrograms() {
-	std::vector<GLTF::Program*> programs;
-	std::set<GLTF::Program*> uniquePrograms;
-	for (GLTF::Technique* technique : getAllTechniques()) {
-		GLTF::Program* program = technique->program;
-		if (program != NULL) {
-			if (uniquePrograms.find(program) == uniquePrograms.end()) {
-				programs.push_back(program);
-				uniquePrograms.insert(program);
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return programs;
+	return _programs;
 }
+
 std::vector<GLTF::Shader*> GLTF::Asset::getAllShaders() {
-	std::vector<GLTF::Shader*> shaders;
-	std::set<GLTF::Shader*> uniqueShaders;
-	for (GLTF::Program* program : getAllPrograms()) {
-		GLTF::Shader* vertexShader = program->vertexShader;
-		if (vertexShader != NULL) {
-			if (uniqueShaders.find(vertexShader) == uniqueShaders.end()) {
-				shaders.push_back(vertexShader);
-				uniqueShaders.insert(vertexShader);
-			}
-		}
-		GLTF::Shader* fragmentShader = program->fragmentShader;
-		if (fragmentShader != NULL) {
-			if (uniqueShaders.find(fragmentShader) == uniqueShaders.end()) {
-				shaders.push_back(fragmentShader);
-				uniqueShaders.insert(fragmentShader);
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return shaders;
+	return _shaders;
 }
 
 std::vector<GLTF::Texture*> GLTF::Asset::getAllTextures() {
-	std::vector<GLTF::Texture*> textures;
-	std::set<GLTF::Texture*> uniqueTextures;
-	for (GLTF::Material* material : getAllMaterials()) {
-		if (material->type == GLTF::Material::MATERIAL || material->type == GLTF::Material::MATERIAL_COMMON) {
-			GLTF::Material::Values* values = material->values;
-			if (values->ambientTexture != NULL) {
-				if (uniqueTextures.find(values->ambientTexture) == uniqueTextures.end()) {
-					textures.push_back(values->ambientTexture);
-					uniqueTextures.insert(values->ambientTexture);
-				}
-			}
-			if (values->diffuseTexture != NULL) {
-				if (uniqueTextures.find(values->diffuseTexture) == uniqueTextures.end()) {
-					textures.push_back(values->diffuseTexture);
-					uniqueTextures.insert(values->diffuseTexture);
-				}
-			}
-			if (values->emissionTexture != NULL) {
-				if (uniqueTextures.find(values->emissionTexture) == uniqueTextures.end()) {
-					textures.push_back(values->emissionTexture);
-					uniqueTextures.insert(values->emissionTexture);
-				}
-			}
-			if (values->specularTexture != NULL) {
-				if (uniqueTextures.find(values->specularTexture) == uniqueTextures.end()) {
-					textures.push_back(values->specularTexture);
-					uniqueTextures.insert(values->specularTexture);
-				}
-			}
-			if (values->bumpTexture != NULL) {
-				if (uniqueTextures.find(values->bumpTexture) == uniqueTextures.end()) {
-					textures.push_back(values->bumpTexture);
-					uniqueTextures.insert(values->bumpTexture);
-				}
-			}
-		}
-		else if (material->type == GLTF::Material::PBR_METALLIC_ROUGHNESS) {
-			GLTF::MaterialPBR* materialPBR = (GLTF::MaterialPBR*)material;
-			if (materialPBR->metallicRoughness->baseColorTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->metallicRoughness->baseColorTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->metallicRoughness->baseColorTexture->texture);
-					uniqueTextures.insert(materialPBR->metallicRoughness->baseColorTexture->texture);
-				}
-			}
-			if (materialPBR->metallicRoughness->metallicRoughnessTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->metallicRoughness->metallicRoughnessTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->metallicRoughness->metallicRoughnessTexture->texture);
-					uniqueTextures.insert(materialPBR->metallicRoughness->metallicRoughnessTexture->texture);
-				}
-			}
-			if (materialPBR->emissiveTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->emissiveTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->emissiveTexture->texture);
-					uniqueTextures.insert(materialPBR->emissiveTexture->texture);
-				}
-			}
-			if (materialPBR->normalTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->normalTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->normalTexture->texture);
-					uniqueTextures.insert(materialPBR->normalTexture->texture);
-				}
-			}
-			if (materialPBR->occlusionTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->occlusionTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->occlusionTexture->texture);
-					uniqueTextures.insert(materialPBR->occlusionTexture->texture);
-				}
-			}
-			if (materialPBR->specularGlossiness->diffuseTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->specularGlossiness->diffuseTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->specularGlossiness->diffuseTexture->texture);
-					uniqueTextures.insert(materialPBR->specularGlossiness->diffuseTexture->texture);
-				}
-			}
-			if (materialPBR->specularGlossiness->specularGlossinessTexture != NULL) {
-				if (uniqueTextures.find(materialPBR->specularGlossiness->specularGlossinessTexture->texture) == uniqueTextures.end()) {
-					textures.push_back(materialPBR->specularGlossiness->specularGlossinessTexture->texture);
-					uniqueTextures.insert(materialPBR->specularGlossiness->specularGlossinessTexture->texture);
-				}
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return textures;
+	return _textures;
 }
 
 std::vector<GLTF::Image*> GLTF::Asset::getAllImages() {
-	std::vector<GLTF::Image*> images;
-	std::set<GLTF::Image*> uniqueImages;
-	for (GLTF::Texture* texture : getAllTextures()) {
-		GLTF::Image* image = texture->source;
-		if (image != NULL) {
-			if (uniqueImages.find(image) == uniqueImages.end()) {
-				images.push_back(image);
-				uniqueImages.insert(image);
-			}
-		}
+	if (!_indexed) {
+		buildIndex();
 	}
-	return images;
+	return _images;
 }
 
 std::vector<GLTF::Accessor*> GLTF::Asset::getAllPrimitiveAccessors(GLTF::Primitive* primitive) const
@@ -374,186 +335,2139 @@ std::vector<GLTF::BufferView*> GLTF::Asset::getAllCompressedBufferView() {
 			}
 		}
 	}
-	return compressedBufferViews;
+	return compressedBufferViews;
+}
+
+void GLTF::Asset::mergeAnimations() {
+	if (animations.size() == 0) { return; }
+
+	GLTF::Animation* mergedAnimation = new GLTF::Animation();
+
+	// Merge all animations. In the future, animations should be grouped
+	// according to COLLADA <animation_clip/> nodes.
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			mergedAnimation->channels.push_back(channel);
+		}
+	}
+
+	animations.clear();
+	animations.push_back(mergedAnimation);
+}
+
+void GLTF::Asset::removeUncompressedBufferViews() {
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		auto dracoExtensionPtr = primitive->extensions.find("KHR_draco_mesh_compression");
+		if (dracoExtensionPtr != primitive->extensions.end()) {
+			// Currently assume all attributes are compressed in Draco extension.
+			for (const auto accessor: getAllPrimitiveAccessors(primitive)) {
+				if (accessor->bufferView) {
+					delete accessor->bufferView;
+					accessor->bufferView = NULL;
+				}
+			}
+			GLTF::Accessor* indicesAccessor = primitive->indices;
+			if (indicesAccessor != NULL && indicesAccessor->bufferView) {
+				delete indicesAccessor->bufferView;
+				indicesAccessor->bufferView = NULL;
+			}
+		}
+	}
+}
+
+void GLTF::Asset::removeUnusedSemantics() {
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		GLTF::Material* material = primitive->material;
+		if (material != NULL) {
+			GLTF::Material::Values* values = material->values;
+			std::map<std::string, GLTF::Accessor*> attributes = primitive->attributes;
+			for (const auto attribute : attributes) {
+				std::string semantic = attribute.first;
+				if (semantic.find("TEXCOORD") != std::string::npos) {
+					std::map<std::string, GLTF::Accessor*>::iterator removeTexcoord = primitive->attributes.find(semantic);
+					if (semantic == "TEXCOORD_0") {
+						if (values->ambientTexture == NULL && values->diffuseTexture == NULL && values->emissionTexture == NULL && 
+								values->specularTexture == NULL && values->bumpTexture == NULL) {
+							std::map<std::string, GLTF::Accessor*>::iterator removeTexcoord = primitive->attributes.find(semantic);
+							primitive->attributes.erase(removeTexcoord);
+							removeAttributeFromDracoExtension(primitive, semantic);
+						}
+					}
+					else {
+						// Right now we don't support multiple sets of texture coordinates
+						primitive->attributes.erase(removeTexcoord);
+						removeAttributeFromDracoExtension(primitive, semantic);
+					}
+				}
+			}
+		}
+	}
+	invalidateIndex();
+}
+
+void GLTF::Asset::removeAttributeFromDracoExtension(GLTF::Primitive* primitive, const std::string &semantic) {
+	auto extensionPtr = primitive->extensions.find("KHR_draco_mesh_compression");
+	if (extensionPtr != primitive->extensions.end()) {
+		GLTF::DracoExtension* dracoExtension = (GLTF::DracoExtension*)extensionPtr->second;
+		auto attPtr = dracoExtension->attributeToId.find(semantic);
+		if (attPtr != dracoExtension->attributeToId.end()) {
+			const int att_id = attPtr->second;
+			// Remove from the extension.
+			dracoExtension->attributeToId.erase(attPtr);
+			// Remove from draco mesh.
+			dracoExtension->dracoMesh->DeleteAttribute(att_id);
+		}
+	}
+}
+
+bool isUnusedNode(GLTF::Node* node, std::set<GLTF::Node*> skinNodes, bool isPbr) {
+	if (node->children.size() == 0 && node->mesh == NULL && node->camera == NULL && node->skin == NULL) {
+		if (isPbr || node->light == NULL || node->light->type == GLTF::MaterialCommon::Light::AMBIENT) {
+			if (std::find(skinNodes.begin(), skinNodes.end(), node) == skinNodes.end()) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void GLTF::Asset::removeUnusedNodes(GLTF::Options* options) {
+	std::vector<GLTF::Node*> nodeStack;
+	std::set<GLTF::Node*> skinNodes;
+	bool isPbr = !options->glsl && !options->materialsCommon;
+	for (GLTF::Skin* skin : getAllSkins()) {
+		if (skin->skeleton != NULL) {
+			skinNodes.insert(skin->skeleton);
+		}
+		for (GLTF::Node* jointNode : skin->joints) {
+			skinNodes.insert(jointNode);
+		}
+	}
+
+	GLTF::Scene* defaultScene = getDefaultScene();
+	bool needsPass = true;
+	while (needsPass) {
+		needsPass = false;
+		for (size_t i = 0; i < defaultScene->nodes.size(); i++) {
+			GLTF::Node* node = defaultScene->nodes[i];
+			if (isUnusedNode(node, skinNodes, isPbr)) {
+				// Nodes associated with ambient lights may be optimized out,
+				// but we should hang on to the lights so that they are 
+				// still written into the shader or common materials object.
+				if (node->light != NULL) {
+					_ambientLights.push_back(node->light);
+				}
+				defaultScene->nodes.erase(defaultScene->nodes.begin() + i);
+				i--;
+			}
+			else {
+				nodeStack.push_back(node);
+			}
+		}
+		while (nodeStack.size() > 0) {
+			GLTF::Node* node = nodeStack.back();
+			nodeStack.pop_back();
+			for (size_t i = 0; i < node->children.size(); i++) {
+				GLTF::Node* child = node->children[i];
+				if (isUnusedNode(child, skinNodes, isPbr)) {
+					if (child->light != NULL) {
+						_ambientLights.push_back(child->light);
+					}
+					// this node is extraneous, remove it
+					node->children.erase(node->children.begin() + i);
+					i--;
+					if (node->children.size() == 0) {
+						// another pass may be required to clean up the parent
+						needsPass = true;
+					}
+				}
+				else {
+					nodeStack.push_back(child);
+				}
+			}
+		}
+	}
+	invalidateIndex();
+}
+
+/**
+ * Hashes the type and element data of an accessor with 64-bit FNV-1a, skipping any padding between elements.
+ */
+unsigned long long hashAccessor(GLTF::Accessor* accessor) {
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned int header[3] = { (unsigned int)accessor->type, (unsigned int)accessor->componentType, (unsigned int)accessor->count };
+	const unsigned char* headerBytes = (const unsigned char*)header;
+	for (size_t i = 0; i < sizeof(header); i++) {
+		hash ^= headerBytes[i];
+		hash *= 1099511628211ULL;
+	}
+	if (accessor->bufferView == NULL || accessor->bufferView->buffer == NULL) {
+		return hash;
+	}
+	const unsigned char* data = accessor->bufferView->buffer->data + accessor->bufferView->byteOffset + accessor->byteOffset;
+	size_t byteStride = accessor->getByteStride();
+	size_t elementByteLength = accessor->getNumberOfComponents() * accessor->getComponentByteLength();
+	for (size_t i = 0; i < accessor->count; i++) {
+		const unsigned char* element = data + i * byteStride;
+		for (size_t j = 0; j < elementByteLength; j++) {
+			hash ^= element[j];
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+/**
+ * Compares the type and element data of two accessors byte for byte.
+ */
+bool accessorDataEquals(GLTF::Accessor* a, GLTF::Accessor* b) {
+	if (a == b) {
+		return true;
+	}
+	if (a == NULL || b == NULL || a->type != b->type || a->componentType != b->componentType || a->count != b->count || a->normalized != b->normalized) {
+		return false;
+	}
+	if (a->bufferView == NULL || b->bufferView == NULL) {
+		return a->bufferView == b->bufferView;
+	}
+	const unsigned char* aData = a->bufferView->buffer->data + a->bufferView->byteOffset + a->byteOffset;
+	const unsigned char* bData = b->bufferView->buffer->data + b->bufferView->byteOffset + b->byteOffset;
+	size_t aByteStride = a->getByteStride();
+	size_t bByteStride = b->getByteStride();
+	size_t elementByteLength = a->getNumberOfComponents() * a->getComponentByteLength();
+	if (aByteStride == elementByteLength && bByteStride == elementByteLength) {
+		return std::memcmp(aData, bData, elementByteLength * a->count) == 0;
+	}
+	for (size_t i = 0; i < a->count; i++) {
+		if (std::memcmp(aData + i * aByteStride, bData + i * bByteStride, elementByteLength) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Gets the attribute semantics of a primitive, including those of its morph targets, in the same order
+ * as `GLTF::Asset::getAllPrimitiveAccessors`.
+ */
+std::vector<std::string> getPrimitiveSemantics(GLTF::Primitive* primitive) {
+	std::vector<std::string> semantics;
+	for (const auto& attribute : primitive->attributes) {
+		semantics.push_back(attribute.first);
+	}
+	for (GLTF::Primitive::Target* target : primitive->targets) {
+		semantics.push_back("");
+		for (const auto& attribute : target->attributes) {
+			semantics.push_back(attribute.first);
+		}
+	}
+	return semantics;
+}
+
+void GLTF::Asset::removeDuplicateMeshes() {
+	// Primitives are bucketed by a hash of their geometry, and confirmed by comparing the data
+	std::map<GLTF::Accessor*, unsigned long long> accessorHashes;
+	auto getAccessorHash = [&accessorHashes](GLTF::Accessor* accessor) {
+		if (accessor == NULL) {
+			return 0ULL;
+		}
+		auto findHash = accessorHashes.find(accessor);
+		if (findHash != accessorHashes.end()) {
+			return findHash->second;
+		}
+		unsigned long long hash = hashAccessor(accessor);
+		accessorHashes[accessor] = hash;
+		return hash;
+	};
+
+	std::map<unsigned long long, std::vector<GLTF::Primitive*>> geometryBuckets;
+	std::map<GLTF::Primitive*, GLTF::Primitive*> duplicatePrimitives;
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		if (primitive->extensions.size() > 0) {
+			// Extensions such as Draco compression hold data of their own that isn't compared
+			continue;
+		}
+		std::vector<std::string> semantics = getPrimitiveSemantics(primitive);
+		std::vector<GLTF::Accessor*> accessors = getAllPrimitiveAccessors(primitive);
+		unsigned long long hash = (unsigned long long)primitive->mode;
+		hash = hash * 31 + getAccessorHash(primitive->indices);
+		for (size_t i = 0; i < accessors.size(); i++) {
+			hash = hash * 31 + std::hash<std::string>()(semantics[i]);
+			hash = hash * 31 + getAccessorHash(accessors[i]);
+		}
+
+		std::vector<GLTF::Primitive*>& bucket = geometryBuckets[hash];
+		GLTF::Primitive* sameGeometry = NULL;
+		GLTF::Primitive* samePrimitive = NULL;
+		for (GLTF::Primitive* candidate : bucket) {
+			if (candidate->mode != primitive->mode || getPrimitiveSemantics(candidate) != semantics || !accessorDataEquals(candidate->indices, primitive->indices)) {
+				continue;
+			}
+			std::vector<GLTF::Accessor*> candidateAccessors = getAllPrimitiveAccessors(candidate);
+			bool equals = true;
+			for (size_t i = 0; i < accessors.size() && equals; i++) {
+				equals = accessorDataEquals(candidateAccessors[i], accessors[i]);
+			}
+			if (!equals) {
+				continue;
+			}
+			sameGeometry = candidate;
+			if (candidate->material == primitive->material) {
+				samePrimitive = candidate;
+				break;
+			}
+		}
+
+		if (samePrimitive != NULL) {
+			duplicatePrimitives[primitive] = samePrimitive;
+		}
+		else {
+			if (sameGeometry != NULL) {
+				// Only the material differs, so the geometry can still be shared
+				primitive->indices = sameGeometry->indices;
+				primitive->attributes = sameGeometry->attributes;
+				for (size_t i = 0; i < primitive->targets.size(); i++) {
+					primitive->targets[i]->attributes = sameGeometry->targets[i]->attributes;
+				}
+			}
+			bucket.push_back(primitive);
+		}
+	}
+
+	// Meshes made of the same primitives with the same morph target weights are then merged
+	std::map<std::pair<std::vector<GLTF::Primitive*>, std::vector<float>>, GLTF::Mesh*> uniqueMeshes;
+	std::map<GLTF::Mesh*, GLTF::Mesh*> duplicateMeshes;
+	for (GLTF::Mesh* mesh : getAllMeshes()) {
+		for (size_t i = 0; i < mesh->primitives.size(); i++) {
+			auto findDuplicate = duplicatePrimitives.find(mesh->primitives[i]);
+			if (findDuplicate != duplicatePrimitives.end()) {
+				mesh->primitives[i] = findDuplicate->second;
+			}
+		}
+		auto key = std::make_pair(mesh->primitives, mesh->weights);
+		auto findMesh = uniqueMeshes.find(key);
+		if (findMesh == uniqueMeshes.end()) {
+			uniqueMeshes[key] = mesh;
+		}
+		else {
+			duplicateMeshes[mesh] = findMesh->second;
+		}
+	}
+	for (GLTF::Node* node : getAllNodes()) {
+		if (node->mesh == NULL) {
+			continue;
+		}
+		auto findDuplicate = duplicateMeshes.find(node->mesh);
+		if (findDuplicate != duplicateMeshes.end()) {
+			node->mesh = findDuplicate->second;
+		}
+	}
+	invalidateIndex();
+}
+
+void GLTF::Asset::removeDuplicateAccessors() {
+	// Accessors are bucketed by their layout and a hash of their data, and confirmed with memcmp
+	typedef std::tuple<int, int, size_t, int, unsigned long long> AccessorKey;
+	std::map<AccessorKey, std::vector<GLTF::Accessor*>> buckets;
+	std::map<GLTF::Accessor*, GLTF::Accessor*> duplicateAccessors;
+	for (GLTF::Accessor* accessor : getAllAccessors()) {
+		// Vertex attributes, indices and animation data live in different kinds of bufferViews
+		int target = accessor->bufferView == NULL ? 0 : (int)accessor->bufferView->target;
+		AccessorKey key((int)accessor->type, (int)accessor->componentType, accessor->count, target, hashAccessor(accessor));
+		std::vector<GLTF::Accessor*>& bucket = buckets[key];
+		GLTF::Accessor* original = NULL;
+		for (GLTF::Accessor* candidate : bucket) {
+			if (accessorDataEquals(candidate, accessor)) {
+				original = candidate;
+				break;
+			}
+		}
+		if (original != NULL) {
+			duplicateAccessors[accessor] = original;
+		}
+		else {
+			bucket.push_back(accessor);
+		}
+	}
+	if (duplicateAccessors.size() == 0) {
+		return;
+	}
+
+	auto replace = [&duplicateAccessors](GLTF::Accessor** accessor) {
+		auto findDuplicate = duplicateAccessors.find(*accessor);
+		if (findDuplicate != duplicateAccessors.end()) {
+			*accessor = findDuplicate->second;
+		}
+	};
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		if (primitive->indices != NULL) {
+			replace(&primitive->indices);
+		}
+		for (auto& attribute : primitive->attributes) {
+			replace(&attribute.second);
+		}
+		for (GLTF::Primitive::Target* target : primitive->targets) {
+			for (auto& attribute : target->attributes) {
+				replace(&attribute.second);
+			}
+		}
+	}
+	for (GLTF::Skin* skin : getAllSkins()) {
+		if (skin->inverseBindMatrices != NULL) {
+			replace(&skin->inverseBindMatrices);
+		}
+	}
+	for (GLTF::Node* node : getAllNodes()) {
+		auto findInstancing = node->extensions.find("EXT_mesh_gpu_instancing");
+		if (findInstancing != node->extensions.end()) {
+			for (auto& attribute : ((GLTF::InstancingExtension*)findInstancing->second)->attributes) {
+				replace(&attribute.second);
+			}
+		}
+	}
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			replace(&channel->sampler->input);
+			replace(&channel->sampler->output);
+		}
+	}
+	invalidateIndex();
+}
+
+/**
+ * Makes textures whose images have identical contents share a single image, so that the same file
+ * stored under different names or paths is only embedded or written once.
+ *
+ * @param threadPool The pool that hashes the images, which may mean reading each file
+ */
+void GLTF::Asset::removeDuplicateImages(GLTF::ThreadPool* threadPool) {
+	std::vector<GLTF::Image*> images = getAllImages();
+	std::vector<std::future<unsigned long long>> hashes;
+	for (GLTF::Image* image : images) {
+		hashes.push_back(threadPool->enqueue([image]() {
+			return image->getContentHash();
+		}));
+	}
+
+	// Images are bucketed by the hash of their contents, and confirmed by comparing the bytes
+	std::map<unsigned long long, std::vector<GLTF::Image*>> buckets;
+	std::map<GLTF::Image*, GLTF::Image*> duplicateImages;
+	for (size_t i = 0; i < images.size(); i++) {
+		GLTF::Image* image = images[i];
+		std::vector<GLTF::Image*>& bucket = buckets[hashes[i].get()];
+		GLTF::Image* original = NULL;
+		for (GLTF::Image* candidate : bucket) {
+			if (candidate->contentEquals(image)) {
+				original = candidate;
+				break;
+			}
+		}
+		if (original != NULL) {
+			duplicateImages[image] = original;
+		}
+		else {
+			bucket.push_back(image);
+		}
+	}
+	if (duplicateImages.size() == 0) {
+		return;
+	}
+
+	for (GLTF::Texture* texture : getAllTextures()) {
+		auto findDuplicate = duplicateImages.find(texture->source);
+		if (findDuplicate != duplicateImages.end()) {
+			texture->source = findDuplicate->second;
+		}
+	}
+	invalidateIndex();
+}
+
+// Quality of JPEG images that are encoded again after resizing
+const int TEXTURE_JPEG_QUALITY = 90;
+
+/**
+ * Decodes an image and re-encodes it in its own format if it needs to be resized.
+ */
+void processTextureImage(GLTF::Image* image, bool srgb, GLTF::Options* options) {
+	unsigned char* data = image->getData();
+	if (data == NULL) {
+		return;
+	}
+	ImageCodec::Pixels pixels;
+	if (!ImageCodec::decode(data, image->getByteLength(), &pixels)) {
+		std::cout << "WARNING: Image " << image->uri << " could not be decoded and is left unprocessed" << std::endl;
+		return;
+	}
+	std::pair<int, int> size = TextureProcessor::getTargetSize(pixels.width, pixels.height, options->maxTextureSize, options->powerOfTwoTextures);
+	if (size.first != pixels.width || size.second != pixels.height) {
+		pixels = TextureProcessor::resize(pixels, size.first, size.second, srgb);
+		std::vector<unsigned char> encoded;
+		if (image->getMimeType() == "image/jpeg") {
+			encoded = ImageCodec::encodeJPEG(pixels, TEXTURE_JPEG_QUALITY);
+		}
+		else {
+			encoded = ImageCodec::encodePNG(pixels);
+		}
+		unsigned char* encodedData = (unsigned char*)malloc(encoded.size());
+		std::memcpy(encodedData, encoded.data(), encoded.size());
+		image->replaceData(encodedData, encoded.size());
+	}
+}
+
+/**
+ * Scales images down to the maxTextureSize option, and to a power of two with the
+ * powerOfTwoTextures option.
+ *
+ * @param threadPool The pool that decodes, resizes and encodes the images
+ */
+void GLTF::Asset::processTextures(GLTF::Options* options, GLTF::ThreadPool* threadPool) {
+	// Color textures are filtered and stored as sRGB, images that are also used for data stay linear
+	std::set<GLTF::Image*> colorImages;
+	std::set<GLTF::Image*> dataImages;
+	auto addImage = [](std::set<GLTF::Image*>* images, GLTF::Texture* texture) {
+		if (texture != NULL && texture->source != NULL) {
+			images->insert(texture->source);
+		}
+	};
+	auto addPBRImage = [&addImage](std::set<GLTF::Image*>* images, GLTF::MaterialPBR::Texture* pbrTexture) {
+		if (pbrTexture != NULL) {
+			addImage(images, pbrTexture->texture);
+		}
+	};
+	for (GLTF::Material* material : getAllMaterials()) {
+		if (material->type == GLTF::Material::MATERIAL || material->type == GLTF::Material::MATERIAL_COMMON) {
+			GLTF::Material::Values* values = material->values;
+			addImage(&colorImages, values->ambientTexture);
+			addImage(&colorImages, values->diffuseTexture);
+			addImage(&colorImages, values->emissionTexture);
+			addImage(&colorImages, values->specularTexture);
+			addImage(&dataImages, values->bumpTexture);
+		}
+		else if (material->type == GLTF::Material::PBR_METALLIC_ROUGHNESS) {
+			GLTF::MaterialPBR* materialPBR = (GLTF::MaterialPBR*)material;
+			addPBRImage(&colorImages, materialPBR->metallicRoughness->baseColorTexture);
+			addPBRImage(&colorImages, materialPBR->emissiveTexture);
+			addPBRImage(&colorImages, materialPBR->specularGlossiness->diffuseTexture);
+			addPBRImage(&colorImages, materialPBR->specularGlossiness->specularGlossinessTexture);
+			addPBRImage(&dataImages, materialPBR->metallicRoughness->metallicRoughnessTexture);
+			addPBRImage(&dataImages, materialPBR->normalTexture);
+			addPBRImage(&dataImages, materialPBR->occlusionTexture);
+		}
+	}
+
+	std::vector<std::future<void>> processedImages;
+	for (GLTF::Image* image : getAllImages()) {
+		bool srgb = colorImages.count(image) > 0 && dataImages.count(image) == 0;
+		processedImages.push_back(threadPool->enqueue([image, srgb, options]() {
+			processTextureImage(image, srgb, options);
+		}));
+	}
+	for (std::future<void>& processedImage : processedImages) {
+		processedImage.get();
+	}
+}
+
+// Pixels of each image repeated around it in an atlas, so that filtering doesn't blend in its neighbours
+const int ATLAS_PADDING = 4;
+// How far outside [0, 1] texture coordinates can be and still be treated as not repeating
+const float ATLAS_TEXCOORD_TOLERANCE = 1e-4f;
+
+struct AtlasRegion {
+	GLTF::Texture* texture = NULL;
+	float offset[2];
+	float scale[2];
+};
+
+/**
+ * Gets the texture of a material that can be moved into an atlas. It has to be the diffuse or base
+ * color texture and the only texture the material uses, since remapping the texture coordinates of
+ * its primitives would move any other texture too.
+ *
+ * @return The texture, or `NULL` if the material has none that can be moved
+ */
+GLTF::Texture* getAtlasTexture(GLTF::Material* material) {
+	GLTF::Texture* texture = NULL;
+	std::vector<GLTF::Texture*> otherTextures;
+	if (material->type == GLTF::Material::MATERIAL || material->type == GLTF::Material::MATERIAL_COMMON) {
+		GLTF::Material::Values* values = material->values;
+		texture = values->diffuseTexture;
+		otherTextures = { values->ambientTexture, values->emissionTexture, values->specularTexture, values->bumpTexture };
+	}
+	else if (material->type == GLTF::Material::PBR_METALLIC_ROUGHNESS) {
+		GLTF::MaterialPBR* materialPBR = (GLTF::MaterialPBR*)material;
+		GLTF::MaterialPBR::Texture* baseColorTexture = materialPBR->metallicRoughness->baseColorTexture;
+		if (baseColorTexture == NULL || baseColorTexture->texCoord > 0) {
+			return NULL;
+		}
+		texture = baseColorTexture->texture;
+		for (GLTF::MaterialPBR::Texture* pbrTexture : { materialPBR->metallicRoughness->metallicRoughnessTexture, materialPBR->normalTexture, materialPBR->occlusionTexture, materialPBR->emissiveTexture, materialPBR->specularGlossiness->diffuseTexture, materialPBR->specularGlossiness->specularGlossinessTexture }) {
+			if (pbrTexture != NULL) {
+				otherTextures.push_back(pbrTexture->texture);
+			}
+		}
+	}
+	if (texture == NULL || texture->source == NULL || texture->extensions.size() > 0) {
+		return NULL;
+	}
+	for (GLTF::Texture* otherTexture : otherTextures) {
+		if (otherTexture != NULL && otherTexture != texture) {
+			return NULL;
+		}
+	}
+	return texture;
+}
+
+/**
+ * Whether every texture coordinate of a primitive is inside [0, 1], so that it never repeats its
+ * texture and can sample it from an atlas instead.
+ */
+bool hasAtlasTexCoords(GLTF::Primitive* primitive) {
+	if (primitive->extensions.size() > 0 || primitive->targets.size() > 0) {
+		return false;
+	}
+	auto findTexCoord = primitive->attributes.find("TEXCOORD_0");
+	if (findTexCoord == primitive->attributes.end()) {
+		return false;
+	}
+	GLTF::Accessor* accessor = findTexCoord->second;
+	if (accessor->bufferView == NULL || accessor->type != GLTF::Accessor::Type::VEC2 || accessor->componentType != GLTF::Constants::WebGL::FLOAT) {
+		return false;
+	}
+	float texCoord[2];
+	for (size_t i = 0; i < accessor->count; i++) {
+		accessor->getComponentAtIndex(i, texCoord);
+		for (int j = 0; j < 2; j++) {
+			// Also rejects NaN
+			if (!(texCoord[j] >= -ATLAS_TEXCOORD_TOLERANCE && texCoord[j] <= 1 + ATLAS_TEXCOORD_TOLERANCE)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Packs diffuse and base color images no larger than the atlasMaxTextureSize option into atlases of
+ * at most atlasSize pixels, remaps the TEXCOORD_0 of the primitives sampling them, and merges the
+ * materials that only differed in those textures. Textures are only moved when they are the only
+ * texture of their materials and every primitive using them has texture coordinates inside [0, 1],
+ * since a repeating texture can't be sampled from an atlas.
+ *
+ * @param threadPool The pool that decodes the images and encodes the atlases
+ */
+void GLTF::Asset::atlasTextures(GLTF::Options* options, GLTF::ThreadPool* threadPool) {
+	std::vector<GLTF::Material*> atlasMaterials;
+	std::map<GLTF::Material*, GLTF::Texture*> materialTextures;
+	for (GLTF::Material* material : getAllMaterials()) {
+		GLTF::Texture* texture = getAtlasTexture(material);
+		if (texture != NULL) {
+			atlasMaterials.push_back(material);
+			materialTextures[material] = texture;
+		}
+	}
+	std::map<GLTF::Material*, std::vector<GLTF::Primitive*>> materialPrimitives;
+	std::set<GLTF::Material*> repeatingMaterials;
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		if (materialTextures.count(primitive->material) == 0) {
+			continue;
+		}
+		materialPrimitives[primitive->material].push_back(primitive);
+		if (!hasAtlasTexCoords(primitive)) {
+			repeatingMaterials.insert(primitive->material);
+		}
+	}
+	atlasMaterials.erase(std::remove_if(atlasMaterials.begin(), atlasMaterials.end(), [&repeatingMaterials](GLTF::Material* material) {
+		return repeatingMaterials.count(material) > 0;
+	}), atlasMaterials.end());
+
+	// An atlas has a single sampler, so images are only packed with others sampled the same way
+	std::vector<GLTF::Sampler*> samplers;
+	std::map<GLTF::Sampler*, std::vector<GLTF::Image*>> samplerImages;
+	std::vector<GLTF::Image*> images;
+	std::map<GLTF::Image*, std::future<ImageCodec::Pixels>> decoding;
+	for (GLTF::Material* material : atlasMaterials) {
+		GLTF::Texture* texture = materialTextures[material];
+		GLTF::Image* image = texture->source;
+		if (samplerImages.count(texture->sampler) == 0) {
+			samplers.push_back(texture->sampler);
+		}
+		std::vector<GLTF::Image*>& imagesForSampler = samplerImages[texture->sampler];
+		if (std::find(imagesForSampler.begin(), imagesForSampler.end(), image) == imagesForSampler.end()) {
+			imagesForSampler.push_back(image);
+		}
+		if (decoding.count(image) > 0) {
+			continue;
+		}
+		images.push_back(image);
+		decoding[image] = threadPool->enqueue([image, options]() {
+			// Images that can't be read or decoded, or that are too large, are left empty and keep their own texture
+			ImageCodec::Pixels pixels;
+			if (image->getData() != NULL) {
+				std::pair<int, int> dimensions = image->getDimensions();
+				if (std::max(dimensions.first, dimensions.second) <= options->atlasMaxTextureSize &&
+					(!ImageCodec::decode(image->getData(), image->getByteLength(), &pixels) || std::max(pixels.width, pixels.height) > options->atlasMaxTextureSize)) {
+					pixels = ImageCodec::Pixels();
+				}
+			}
+			return pixels;
+		});
+	}
+	std::map<GLTF::Image*, ImageCodec::Pixels> decodedImages;
+	for (GLTF::Image* image : images) {
+		decodedImages[image] = decoding[image].get();
+	}
+
+	std::map<std::pair<GLTF::Sampler*, GLTF::Image*>, AtlasRegion> regions;
+	std::vector<GLTF::Texture*> atlases;
+	std::vector<std::future<GLTF::Image*>> atlasImages;
+	for (GLTF::Sampler* sampler : samplers) {
+		std::vector<GLTF::Image*> packedImages;
+		std::vector<std::pair<int, int>> sizes;
+		for (GLTF::Image* image : samplerImages[sampler]) {
+			const ImageCodec::Pixels& pixels = decodedImages[image];
+			if (pixels.width > 0 && pixels.height > 0) {
+				packedImages.push_back(image);
+				sizes.push_back(std::pair<int, int>(pixels.width, pixels.height));
+			}
+		}
+		std::vector<TextureProcessor::AtlasPlacement> placements;
+		std::vector<std::pair<int, int>> atlasSizes = TextureProcessor::packAtlases(sizes, options->atlasSize, ATLAS_PADDING, &placements);
+		for (size_t atlas = 0; atlas < atlasSizes.size(); atlas++) {
+			std::vector<size_t> members;
+			for (size_t i = 0; i < placements.size(); i++) {
+				if (placements[i].atlas == (int)atlas) {
+					members.push_back(i);
+				}
+			}
+			// An atlas holding a single image doesn't save a material
+			if (members.size() < 2) {
+				continue;
+			}
+
+			int width = atlasSizes[atlas].first;
+			int height = atlasSizes[atlas].second;
+			GLTF::Texture* atlasTexture = new GLTF::Texture();
+			atlasTexture->sampler = sampler;
+			std::vector<std::tuple<const ImageCodec::Pixels*, int, int>> blits;
+			bool jpeg = true;
+			for (size_t i : members) {
+				GLTF::Image* image = packedImages[i];
+				const TextureProcessor::AtlasPlacement& placement = placements[i];
+				AtlasRegion& region = regions[std::pair<GLTF::Sampler*, GLTF::Image*>(sampler, image)];
+				region.texture = atlasTexture;
+				region.offset[0] = (float)placement.x / width;
+				region.offset[1] = (float)placement.y / height;
+				region.scale[0] = (float)sizes[i].first / width;
+				region.scale[1] = (float)sizes[i].second / height;
+				blits.push_back(std::make_tuple(&decodedImages[image], placement.x, placement.y));
+				jpeg = jpeg && image->getMimeType() == "image/jpeg";
+			}
+			std::string uri = options->name + "_atlas" + std::to_string(atlases.size()) + (jpeg ? ".jpg" : ".png");
+			atlases.push_back(atlasTexture);
+			atlasImages.push_back(threadPool->enqueue([blits, width, height, jpeg, uri]() {
+				ImageCodec::Pixels atlasPixels;
+				atlasPixels.width = width;
+				atlasPixels.height = height;
+				atlasPixels.rgba.assign((size_t)width * height * 4, 0);
+				for (const std::tuple<const ImageCodec::Pixels*, int, int>& blit : blits) {
+					TextureProcessor::blit(*std::get<0>(blit), &atlasPixels, std::get<1>(blit), std::get<2>(blit), ATLAS_PADDING);
+				}
+				std::vector<unsigned char> encoded = jpeg ? ImageCodec::encodeJPEG(atlasPixels, TEXTURE_JPEG_QUALITY) : ImageCodec::encodePNG(atlasPixels);
+				unsigned char* data = (unsigned char*)malloc(encoded.size());
+				std::memcpy(data, encoded.data(), encoded.size());
+				return new GLTF::Image(uri, data, encoded.size(), jpeg ? "jpg" : "png");
+			}));
+		}
+	}
+	for (size_t i = 0; i < atlases.size(); i++) {
+		atlases[i]->source = atlasImages[i].get();
+	}
+	if (atlases.size() == 0) {
+		return;
+	}
+
+	std::map<std::pair<GLTF::Accessor*, const AtlasRegion*>, GLTF::Accessor*> atlasTexCoords;
+	std::map<GLTF::Texture*, std::vector<GLTF::Material*>> atlasTextureMaterials;
+	std::map<GLTF::Material*, GLTF::Material*> duplicateMaterials;
+	for (GLTF::Material* material : atlasMaterials) {
+		GLTF::Texture* texture = materialTextures[material];
+		auto findRegion = regions.find(std::pair<GLTF::Sampler*, GLTF::Image*>(texture->sampler, texture->source));
+		if (findRegion == regions.end()) {
+			continue;
+		}
+		const AtlasRegion* region = &findRegion->second;
+		if (material->type == GLTF::Material::PBR_METALLIC_ROUGHNESS) {
+			GLTF::MaterialPBR* materialPBR = (GLTF::MaterialPBR*)material;
+			for (GLTF::MaterialPBR::Texture** slot : { &materialPBR->metallicRoughness->baseColorTexture, &materialPBR->metallicRoughness->metallicRoughnessTexture, &materialPBR->normalTexture, &materialPBR->occlusionTexture, &materialPBR->emissiveTexture, &materialPBR->specularGlossiness->diffuseTexture, &materialPBR->specularGlossiness->specularGlossinessTexture }) {
+				if (*slot != NULL && (*slot)->texture == texture) {
+					GLTF::MaterialPBR::Texture* atlasTexture = new GLTF::MaterialPBR::Texture();
+					atlasTexture->scale = (*slot)->scale;
+					atlasTexture->texCoord = (*slot)->texCoord;
+					atlasTexture->texture = region->texture;
+					*slot = atlasTexture;
+				}
+			}
+		}
+		else {
+			GLTF::Material::Values* values = material->values;
+			for (GLTF::Texture** slot : { &values->ambientTexture, &values->diffuseTexture, &values->emissionTexture, &values->specularTexture, &values->bumpTexture }) {
+				if (*slot == texture) {
+					*slot = region->texture;
+				}
+			}
+		}
+
+		for (GLTF::Primitive* primitive : materialPrimitives[material]) {
+			GLTF::Accessor*& texCoord = primitive->attributes["TEXCOORD_0"];
+			std::pair<GLTF::Accessor*, const AtlasRegion*> key(texCoord, region);
+			auto findTexCoord = atlasTexCoords.find(key);
+			if (findTexCoord != atlasTexCoords.end()) {
+				texCoord = findTexCoord->second;
+				continue;
+			}
+			std::vector<float> data(texCoord->count * 2);
+			for (size_t i = 0; i < texCoord->count; i++) {
+				float* component = &data[i * 2];
+				texCoord->getComponentAtIndex(i, component);
+				for (int j = 0; j < 2; j++) {
+					component[j] = region->offset[j] + std::min(1.0f, std::max(0.0f, component[j])) * region->scale[j];
+				}
+			}
+			GLTF::Accessor* atlasTexCoord = new GLTF::Accessor(GLTF::Accessor::Type::VEC2, GLTF::Constants::WebGL::FLOAT, std::move(data), GLTF::Constants::WebGL::ARRAY_BUFFER);
+			atlasTexCoords[key] = atlasTexCoord;
+			texCoord = atlasTexCoord;
+		}
+
+		// Materials that only differed in their textures can now be the same
+		std::vector<GLTF::Material*>& candidates = atlasTextureMaterials[region->texture];
+		for (GLTF::Material* candidate : candidates) {
+			if (candidate->equals(material)) {
+				duplicateMaterials[material] = candidate;
+				break;
+			}
+		}
+		if (duplicateMaterials.count(material) == 0) {
+			candidates.push_back(material);
+		}
+	}
+
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		auto findDuplicate = duplicateMaterials.find(primitive->material);
+		if (findDuplicate != duplicateMaterials.end()) {
+			primitive->material = findDuplicate->second;
+		}
+	}
+	invalidateIndex();
+}
+
+bool readIndices(GLTF::Accessor* accessor, std::vector<unsigned int>* indices) {
+	if (accessor->bufferView == NULL || accessor->bufferView->buffer == NULL) {
+		return false;
+	}
+	unsigned char* data = accessor->bufferView->buffer->data + accessor->bufferView->byteOffset + accessor->byteOffset;
+	indices->resize(accessor->count);
+	for (size_t i = 0; i < accessor->count; i++) {
+		switch (accessor->componentType) {
+		case GLTF::Constants::WebGL::UNSIGNED_BYTE:
+			(*indices)[i] = data[i];
+			break;
+		case GLTF::Constants::WebGL::UNSIGNED_SHORT:
+			(*indices)[i] = ((unsigned short*)data)[i];
+			break;
+		case GLTF::Constants::WebGL::UNSIGNED_INT:
+			(*indices)[i] = ((unsigned int*)data)[i];
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+void writeIndices(GLTF::Accessor* accessor, const std::vector<unsigned int>& indices) {
+	unsigned char* data = accessor->bufferView->buffer->data + accessor->bufferView->byteOffset + accessor->byteOffset;
+	for (size_t i = 0; i < accessor->count; i++) {
+		switch (accessor->componentType) {
+		case GLTF::Constants::WebGL::UNSIGNED_BYTE:
+			data[i] = (unsigned char)indices[i];
+			break;
+		case GLTF::Constants::WebGL::UNSIGNED_SHORT:
+			((unsigned short*)data)[i] = (unsigned short)indices[i];
+			break;
+		case GLTF::Constants::WebGL::UNSIGNED_INT:
+			((unsigned int*)data)[i] = indices[i];
+			break;
+		}
+	}
+}
+
+/**
+ * Creates an indices accessor with the same component type as an existing one.
+ */
+GLTF::Accessor* createIndicesAccessor(GLTF::Accessor* like, const std::vector<unsigned int>& indices) {
+	if (like->componentType == GLTF::Constants::WebGL::UNSIGNED_SHORT) {
+		std::vector<unsigned short> unsignedShortIndices(indices.begin(), indices.end());
+		return new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_SHORT, std::move(unsignedShortIndices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+	}
+	else if (like->componentType == GLTF::Constants::WebGL::UNSIGNED_BYTE) {
+		std::vector<unsigned char> unsignedByteIndices(indices.begin(), indices.end());
+		return new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_BYTE, std::move(unsignedByteIndices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+	}
+	return new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_INT, std::vector<unsigned int>(indices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+}
+
+/**
+ * Computes the cofactor matrix of the upper 3x3 of a transform, stored column-major like the transform.
+ * This is the inverse transpose scaled by the determinant, which is returned.
+ */
+float getCofactorMatrix(const float* matrix, float* cofactor) {
+	cofactor[0] = matrix[5] * matrix[10] - matrix[6] * matrix[9];
+	cofactor[1] = matrix[6] * matrix[8] - matrix[4] * matrix[10];
+	cofactor[2] = matrix[4] * matrix[9] - matrix[5] * matrix[8];
+	cofactor[3] = matrix[9] * matrix[2] - matrix[10] * matrix[1];
+	cofactor[4] = matrix[10] * matrix[0] - matrix[8] * matrix[2];
+	cofactor[5] = matrix[8] * matrix[1] - matrix[9] * matrix[0];
+	cofactor[6] = matrix[1] * matrix[6] - matrix[2] * matrix[5];
+	cofactor[7] = matrix[2] * matrix[4] - matrix[0] * matrix[6];
+	cofactor[8] = matrix[0] * matrix[5] - matrix[1] * matrix[4];
+	return matrix[0] * cofactor[0] + matrix[4] * cofactor[3] + matrix[8] * cofactor[6];
+}
+
+/**
+ * Transforms one element of a vertex attribute by a node transform. Positions are transformed as points,
+ * normals by the cofactor matrix and tangent directions by the upper 3x3. Mirroring transforms also flip
+ * the handedness stored in the w of four component tangents. Other semantics are left as they are.
+ */
+void transformVertexComponent(const std::string& semantic, int numberOfComponents, const float* matrix, const float* cofactor, bool mirrored, float* component) {
+	if (numberOfComponents < 3) {
+		return;
+	}
+	float x = component[0];
+	float y = component[1];
+	float z = component[2];
+	if (semantic == "POSITION") {
+		for (int j = 0; j < 3; j++) {
+			component[j] = matrix[j] * x + matrix[4 + j] * y + matrix[8 + j] * z + matrix[12 + j];
+		}
+	}
+	else if (semantic == "NORMAL" || semantic == "TANGENT") {
+		float length = 0;
+		for (int j = 0; j < 3; j++) {
+			if (semantic == "NORMAL") {
+				// The cofactor matrix flips normals along with the determinant
+				component[j] = cofactor[j] * x + cofactor[3 + j] * y + cofactor[6 + j] * z;
+				if (mirrored) {
+					component[j] = -component[j];
+				}
+			}
+			else {
+				component[j] = matrix[j] * x + matrix[4 + j] * y + matrix[8 + j] * z;
+			}
+			length += component[j] * component[j];
+		}
+		length = sqrtf(length);
+		if (length > 0) {
+			for (int j = 0; j < 3; j++) {
+				component[j] /= length;
+			}
+		}
+		if (semantic == "TANGENT" && mirrored && numberOfComponents == 4) {
+			// The bitangent is rebuilt from the normal and tangent, so it has to flip with them
+			component[3] = -component[3];
+		}
+	}
+}
+
+/**
+ * Reverses the winding of triangle list indices, which mirroring transforms flip.
+ */
+void reverseWinding(std::vector<unsigned int>* indices) {
+	for (size_t i = 0; i + 2 < indices->size(); i += 3) {
+		std::swap((*indices)[i + 1], (*indices)[i + 2]);
+	}
+}
+
+/**
+ * Gets the local transform of a node as a matrix.
+ */
+void getNodeTransformMatrix(GLTF::Node* node, GLTF::Node::TransformMatrix* matrix) {
+	if (node->transform == NULL) {
+		return;
+	}
+	if (node->transform->type == GLTF::Node::Transform::MATRIX) {
+		std::memcpy(matrix->matrix, ((GLTF::Node::TransformMatrix*)node->transform)->matrix, sizeof(matrix->matrix));
+	}
+	else {
+		GLTF::Node::TransformMatrix* trsMatrix = ((GLTF::Node::TransformTRS*)node->transform)->getTransformMatrix();
+		std::memcpy(matrix->matrix, trsMatrix->matrix, sizeof(matrix->matrix));
+		delete trsMatrix;
+	}
+}
+
+/**
+ * Creates a copy of a mesh with a transform baked into its vertex data. Returns NULL if the mesh has data
+ * that can't be transformed, such as morph targets or Draco compressed primitives.
+ */
+GLTF::Mesh* bakeMeshTransform(GLTF::Mesh* mesh, const float* matrix) {
+	float cofactor[9];
+	bool mirrored = getCofactorMatrix(matrix, cofactor) < 0;
+	for (GLTF::Primitive* primitive : mesh->primitives) {
+		if (primitive->targets.size() > 0 || primitive->extensions.size() > 0) {
+			return NULL;
+		}
+		if (mirrored && primitive->mode != GLTF::Primitive::Mode::TRIANGLES && primitive->mode != GLTF::Primitive::Mode::LINES && primitive->mode != GLTF::Primitive::Mode::POINTS) {
+			return NULL;
+		}
+		for (const auto& attribute : primitive->attributes) {
+			GLTF::Accessor* accessor = attribute.second;
+			if ((attribute.first == "POSITION" || attribute.first == "NORMAL" || attribute.first == "TANGENT") &&
+				(accessor == NULL || accessor->bufferView == NULL || accessor->componentType != GLTF::Constants::WebGL::FLOAT)) {
+				return NULL;
+			}
+		}
+	}
+
+	GLTF::Mesh* bakedMesh = new GLTF::Mesh();
+	mesh->clone(bakedMesh);
+	for (GLTF::Primitive* primitive : bakedMesh->primitives) {
+		for (auto& attribute : primitive->attributes) {
+			const std::string& semantic = attribute.first;
+			if (semantic != "POSITION" && semantic != "NORMAL" && semantic != "TANGENT") {
+				continue;
+			}
+			GLTF::Accessor* accessor = attribute.second;
+			int numberOfComponents = accessor->getNumberOfComponents();
+			std::vector<float> data(accessor->count * numberOfComponents);
+			for (size_t i = 0; i < accessor->count; i++) {
+				float* component = &data[i * numberOfComponents];
+				accessor->getComponentAtIndex(i, component);
+				transformVertexComponent(semantic, numberOfComponents, matrix, cofactor, mirrored, component);
+			}
+			attribute.second = new GLTF::Accessor(accessor->type, GLTF::Constants::WebGL::FLOAT, std::move(data), GLTF::Constants::WebGL::ARRAY_BUFFER);
+		}
+		if (mirrored && primitive->mode == GLTF::Primitive::Mode::TRIANGLES) {
+			std::vector<unsigned int> indices;
+			if (primitive->indices == NULL || !readIndices(primitive->indices, &indices)) {
+				indices.resize(primitive->attributes["POSITION"]->count);
+				for (size_t i = 0; i < indices.size(); i++) {
+					indices[i] = i;
+				}
+			}
+			reverseWinding(&indices);
+			if (primitive->indices != NULL) {
+				primitive->indices = createIndicesAccessor(primitive->indices, indices);
+			}
+			else if (indices.size() > 0) {
+				GLTF::Accessor like(GLTF::Accessor::Type::SCALAR, indices.size() < 65536 ? GLTF::Constants::WebGL::UNSIGNED_SHORT : GLTF::Constants::WebGL::UNSIGNED_INT);
+				primitive->indices = createIndicesAccessor(&like, indices);
+			}
+		}
+	}
+	return bakedMesh;
+}
+
+/**
+ * Checks whether a matrix is close enough to the identity to be dropped.
+ */
+bool isIdentityMatrix(const float* matrix) {
+	GLTF::Node::TransformMatrix identity;
+	for (int i = 0; i < 16; i++) {
+		if (std::abs(matrix[i] - identity.matrix[i]) > 1e-6f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void GLTF::Asset::flattenNodes() {
+	// Animated nodes and anything skins refer to keep their place in the hierarchy
+	std::set<GLTF::Node*> fixedNodes;
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			fixedNodes.insert(channel->target->node);
+		}
+	}
+	for (GLTF::Skin* skin : getAllSkins()) {
+		if (skin->skeleton != NULL) {
+			fixedNodes.insert(skin->skeleton);
+		}
+		for (GLTF::Node* joint : skin->joints) {
+			fixedNodes.insert(joint);
+		}
+	}
+
+	// Meshes are baked once for each distinct transform they are drawn with
+	std::map<std::pair<GLTF::Mesh*, std::vector<float>>, GLTF::Mesh*> bakedMeshes;
+	std::set<GLTF::Node*> visitedNodes;
+	std::function<void(GLTF::Node*, const GLTF::Node::TransformMatrix&, std::vector<GLTF::Node*>*)> flattenNode;
+	flattenNode = [&](GLTF::Node* node, const GLTF::Node::TransformMatrix& parentMatrix, std::vector<GLTF::Node*>* output) {
+		if (visitedNodes.find(node) != visitedNodes.end()) {
+			output->push_back(node);
+			return;
+		}
+		visitedNodes.insert(node);
+		std::vector<GLTF::Node*> children = node->children;
+		node->children.clear();
+
+		bool isFixed = fixedNodes.find(node) != fixedNodes.end() || node->skin != NULL || node->extensions.size() > 0;
+		if (isFixed) {
+			// The node keeps its own transform, so the static transform above it goes on a new parent
+			if (isIdentityMatrix(parentMatrix.matrix)) {
+				output->push_back(node);
+			}
+			else {
+				GLTF::Node* parent = new GLTF::Node();
+				GLTF::Node::TransformMatrix* transform = new GLTF::Node::TransformMatrix();
+				std::memcpy(transform->matrix, parentMatrix.matrix, sizeof(transform->matrix));
+				parent->transform = transform;
+				parent->children.push_back(node);
+				output->push_back(parent);
+			}
+			GLTF::Node::TransformMatrix identity;
+			for (GLTF::Node* child : children) {
+				flattenNode(child, identity, &node->children);
+			}
+			return;
+		}
+
+		GLTF::Node::TransformMatrix localMatrix;
+		getNodeTransformMatrix(node, &localMatrix);
+		GLTF::Node::TransformMatrix parent = parentMatrix;
+		GLTF::Node::TransformMatrix matrix;
+		localMatrix.premultiply(&parent, &matrix);
+		bool isIdentity = isIdentityMatrix(matrix.matrix);
+		// Cameras and lights need the node to keep its transform, which would then apply to a baked mesh again
+		bool keepsTransform = node->camera != NULL || node->light != NULL;
+		bool isMeshBaked = isIdentity;
+		if (node->mesh != NULL && !isIdentity && !keepsTransform) {
+			std::pair<GLTF::Mesh*, std::vector<float>> key(node->mesh, std::vector<float>(matrix.matrix, matrix.matrix + 16));
+			auto findBaked = bakedMeshes.find(key);
+			if (findBaked == bakedMeshes.end()) {
+				findBaked = bakedMeshes.insert(std::make_pair(key, bakeMeshTransform(node->mesh, matrix.matrix))).first;
+			}
+			if (findBaked->second != NULL) {
+				node->mesh = findBaked->second;
+				isMeshBaked = true;
+			}
+		}
+
+		// Static nodes are only kept for what they draw, with their children lifted next to them
+		if (keepsTransform || (node->mesh != NULL && !isMeshBaked)) {
+			if (isIdentity) {
+				node->transform = NULL;
+			}
+			else {
+				GLTF::Node::TransformMatrix* transform = new GLTF::Node::TransformMatrix();
+				std::memcpy(transform->matrix, matrix.matrix, sizeof(transform->matrix));
+				node->transform = transform;
+			}
+			output->push_back(node);
+		}
+		else if (node->mesh != NULL) {
+			node->transform = NULL;
+			output->push_back(node);
+		}
+		for (GLTF::Node* child : children) {
+			flattenNode(child, matrix, output);
+		}
+	};
+
+	for (GLTF::Scene* scene : scenes) {
+		std::vector<GLTF::Node*> roots = scene->nodes;
+		scene->nodes.clear();
+		GLTF::Node::TransformMatrix identity;
+		for (GLTF::Node* node : roots) {
+			flattenNode(node, identity, &scene->nodes);
+		}
+	}
+	invalidateIndex();
+}
+
+/**
+ * Checks whether a primitive can be pre-transformed and concatenated with others.
+ */
+bool isBatchablePrimitive(GLTF::Primitive* primitive) {
+	if (primitive->mode != GLTF::Primitive::Mode::TRIANGLES && primitive->mode != GLTF::Primitive::Mode::LINES && primitive->mode != GLTF::Primitive::Mode::POINTS) {
+		return false;
+	}
+	if (primitive->targets.size() > 0 || primitive->extensions.size() > 0) {
+		return false;
+	}
+	auto findPosition = primitive->attributes.find("POSITION");
+	if (findPosition == primitive->attributes.end() || findPosition->second == NULL || findPosition->second->count == 0) {
+		return false;
+	}
+	if (primitive->indices != NULL && primitive->indices->count == 0) {
+		return false;
+	}
+	size_t vertexCount = findPosition->second->count;
+	for (const auto& attribute : primitive->attributes) {
+		GLTF::Accessor* accessor = attribute.second;
+		if (accessor == NULL || accessor->bufferView == NULL || accessor->componentType != GLTF::Constants::WebGL::FLOAT || accessor->count != vertexCount) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void GLTF::Asset::batchPrimitives(GLTF::Options* options) {
+	std::set<GLTF::Node*> fixedNodes;
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			fixedNodes.insert(channel->target->node);
+		}
+	}
+	for (GLTF::Skin* skin : getAllSkins()) {
+		if (skin->skeleton != NULL) {
+			fixedNodes.insert(skin->skeleton);
+		}
+		for (GLTF::Node* joint : skin->joints) {
+			fixedNodes.insert(joint);
+		}
+	}
+	std::map<GLTF::Mesh*, size_t> meshUses;
+	for (GLTF::Node* node : getAllNodes()) {
+		if (node->mesh != NULL) {
+			meshUses[node->mesh]++;
+		}
+	}
+
+	// Find static nodes along with their transforms in scene space. Animation on a node moves all of
+	// its descendants, so they are skipped as well.
+	typedef std::tuple<GLTF::Material*, int, std::vector<std::string>> BatchKey;
+	std::vector<BatchKey> batchKeys;
+	std::map<BatchKey, std::vector<std::pair<GLTF::Primitive*, GLTF::Node::TransformMatrix>>> batchPrimitives;
+	std::vector<std::pair<GLTF::Node*, GLTF::Node::TransformMatrix>> nodeStack;
+	GLTF::Scene* scene = getDefaultScene();
+	for (GLTF::Node* node : scene->nodes) {
+		nodeStack.push_back(std::make_pair(node, GLTF::Node::TransformMatrix()));
+	}
+	std::set<GLTF::Node*> visitedNodes;
+	while (nodeStack.size() > 0) {
+		GLTF::Node* node = nodeStack.back().first;
+		GLTF::Node::TransformMatrix parentMatrix = nodeStack.back().second;
+		nodeStack.pop_back();
+		if (fixedNodes.find(node) != fixedNodes.end() || visitedNodes.find(node) != visitedNodes.end()) {
+			continue;
+		}
+		visitedNodes.insert(node);
+		GLTF::Node::TransformMatrix localMatrix;
+		getNodeTransformMatrix(node, &localMatrix);
+		GLTF::Node::TransformMatrix matrix;
+		localMatrix.premultiply(&parentMatrix, &matrix);
+		for (GLTF::Node* child : node->children) {
+			nodeStack.push_back(std::make_pair(child, matrix));
+		}
+
+		GLTF::Mesh* mesh = node->mesh;
+		if (mesh == NULL || node->skin != NULL || node->extensions.size() > 0 || mesh->primitives.size() == 0) {
+			continue;
+		}
+		if (options->gpuInstancing && meshUses[mesh] > 1) {
+			// Leave repeated meshes to be drawn as instances
+			continue;
+		}
+		bool batchable = true;
+		for (GLTF::Primitive* primitive : mesh->primitives) {
+			batchable = batchable && isBatchablePrimitive(primitive);
+		}
+		if (!batchable) {
+			continue;
+		}
+		for (GLTF::Primitive* primitive : mesh->primitives) {
+			std::vector<std::string> layout;
+			for (const auto& attribute : primitive->attributes) {
+				layout.push_back(attribute.first + ":" + attribute.second->getTypeName());
+			}
+			BatchKey key(primitive->material, (int)primitive->mode, layout);
+			if (batchPrimitives.find(key) == batchPrimitives.end()) {
+				batchKeys.push_back(key);
+			}
+			batchPrimitives[key].push_back(std::make_pair(primitive, matrix));
+		}
+		node->mesh = NULL;
+	}
+	if (batchKeys.size() == 0) {
+		invalidateIndex();
+		return;
+	}
+
+	GLTF::Mesh* batchedMesh = new GLTF::Mesh();
+	batchedMesh->name = "batched";
+	size_t maxVertices = (size_t)std::max(1, options->batchMaxVertices);
+	for (const BatchKey& key : batchKeys) {
+		std::vector<std::pair<GLTF::Primitive*, GLTF::Node::TransformMatrix>>& sources = batchPrimitives[key];
+		size_t sourceIndex = 0;
+		while (sourceIndex < sources.size()) {
+			GLTF::Primitive* first = sources[sourceIndex].first;
+			std::map<std::string, std::vector<float>> attributeData;
+			std::vector<unsigned int> indices;
+			size_t vertexCount = 0;
+			// Start a new batch once the next primitive would go over the maximum vertex count
+			while (sourceIndex < sources.size()) {
+				GLTF::Primitive* primitive = sources[sourceIndex].first;
+				float* matrix = sources[sourceIndex].second.matrix;
+				size_t primitiveVertexCount = primitive->attributes["POSITION"]->count;
+				if (vertexCount > 0 && vertexCount + primitiveVertexCount > maxVertices) {
+					break;
+				}
+				sourceIndex++;
+
+				std::vector<unsigned int> primitiveIndices;
+				if (primitive->indices == NULL || !readIndices(primitive->indices, &primitiveIndices)) {
+					primitiveIndices.resize(primitiveVertexCount);
+					for (size_t i = 0; i < primitiveVertexCount; i++) {
+						primitiveIndices[i] = i;
+					}
+				}
+				float cofactor[9];
+				bool mirrored = getCofactorMatrix(matrix, cofactor) < 0;
+				if (mirrored && primitive->mode == GLTF::Primitive::Mode::TRIANGLES) {
+					reverseWinding(&primitiveIndices);
+				}
+				for (unsigned int index : primitiveIndices) {
+					indices.push_back(index + vertexCount);
+				}
+
+				for (const auto& attribute : primitive->attributes) {
+					const std::string& semantic = attribute.first;
+					GLTF::Accessor* accessor = attribute.second;
+					int numberOfComponents = accessor->getNumberOfComponents();
+					std::vector<float>& data = attributeData[semantic];
+					float component[16];
+					for (size_t i = 0; i < accessor->count; i++) {
+						accessor->getComponentAtIndex(i, component);
+						transformVertexComponent(semantic, numberOfComponents, matrix, cofactor, mirrored, component);
+						data.insert(data.end(), component, component + numberOfComponents);
+					}
+				}
+				vertexCount += primitiveVertexCount;
+			}
+
+			GLTF::Primitive* batchedPrimitive = new GLTF::Primitive();
+			batchedPrimitive->mode = first->mode;
+			batchedPrimitive->material = first->material;
+			for (const auto& attribute : first->attributes) {
+				GLTF::Accessor::Type type = attribute.second->type;
+				std::vector<float>& data = attributeData[attribute.first];
+				batchedPrimitive->attributes[attribute.first] = new GLTF::Accessor(type, GLTF::Constants::WebGL::FLOAT, std::move(data), GLTF::Constants::WebGL::ARRAY_BUFFER);
+			}
+			if (vertexCount < 65536) {
+				// Keep 16-bit indices whenever the batch allows it, 65535 is reserved for primitive restart
+				std::vector<unsigned short> unsignedShortIndices(indices.begin(), indices.end());
+				batchedPrimitive->indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_SHORT, std::move(unsignedShortIndices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+			}
+			else {
+				batchedPrimitive->indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_INT, std::move(indices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+			}
+			batchedMesh->primitives.push_back(batchedPrimitive);
+		}
+	}
+
+	GLTF::Node* batchedNode = new GLTF::Node();
+	batchedNode->name = batchedMesh->name;
+	batchedNode->mesh = batchedMesh;
+	scene->nodes.push_back(batchedNode);
+	invalidateIndex();
+}
+
+void addVertexCacheStatistics(MeshOptimizer::VertexCacheStatistics* total, const MeshOptimizer::VertexCacheStatistics& statistics) {
+	total->triangleCount += statistics.triangleCount;
+	total->vertexCount += statistics.vertexCount;
+	total->cacheMisses += statistics.cacheMisses;
+	if (total->triangleCount > 0) {
+		total->acmr = (float)total->cacheMisses / total->triangleCount;
+	}
+	if (total->vertexCount > 0) {
+		total->atvr = (float)total->cacheMisses / total->vertexCount;
+	}
+}
+
+void GLTF::Asset::optimizeVertexCache(MeshOptimizer::VertexCacheStatistics* before, MeshOptimizer::VertexCacheStatistics* after) {
+	std::set<GLTF::Accessor*> optimizedIndices;
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		GLTF::Accessor* indicesAccessor = primitive->indices;
+		if (primitive->mode != GLTF::Primitive::Mode::TRIANGLES || indicesAccessor == NULL) {
+			continue;
+		}
+		auto findPosition = primitive->attributes.find("POSITION");
+		if (findPosition == primitive->attributes.end() || findPosition->second == NULL) {
+			continue;
+		}
+		size_t vertexCount = findPosition->second->count;
+		std::vector<unsigned int> indices;
+		if (!readIndices(indicesAccessor, &indices) || indices.size() < 3) {
+			continue;
+		}
+		// Primitives that share an indices accessor are only reordered once
+		if (optimizedIndices.find(indicesAccessor) == optimizedIndices.end()) {
+			addVertexCacheStatistics(before, MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount));
+			MeshOptimizer::optimizeVertexCache(&indices[0], indices.size(), vertexCount);
+			addVertexCacheStatistics(after, MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount));
+			writeIndices(indicesAccessor, indices);
+			optimizedIndices.insert(indicesAccessor);
+		}
+
+		// Keep the faces of the Draco mesh in the same order
+		auto dracoExtensionPtr = primitive->extensions.find("KHR_draco_mesh_compression");
+		if (dracoExtensionPtr != primitive->extensions.end()) {
+			GLTF::DracoExtension* dracoExtension = (GLTF::DracoExtension*)dracoExtensionPtr->second;
+			draco::Mesh* dracoMesh = dracoExtension->dracoMesh.get();
+			if (dracoMesh != NULL && dracoMesh->num_faces() == indices.size() / 3) {
+				for (draco::FaceIndex i(0); i < dracoMesh->num_faces(); ++i) {
+					draco::Mesh::Face face;
+					face[0] = indices[i.value() * 3];
+					face[1] = indices[i.value() * 3 + 1];
+					face[2] = indices[i.value() * 3 + 2];
+					dracoMesh->SetFace(i, face);
+				}
+			}
+		}
+	}
+	invalidateIndex();
+}
+
+void remapAccessor(GLTF::Accessor* accessor, const std::vector<unsigned int>& remap) {
+	unsigned char* data = accessor->bufferView->buffer->data + accessor->bufferView->byteOffset + accessor->byteOffset;
+	size_t byteStride = accessor->getByteStride();
+	size_t elementByteLength = accessor->getNumberOfComponents() * accessor->getComponentByteLength();
+	std::vector<unsigned char> remappedData(accessor->count * elementByteLength);
+	for (size_t i = 0; i < accessor->count; i++) {
+		std::memcpy(&remappedData[remap[i] * elementByteLength], data + i * byteStride, elementByteLength);
+	}
+	for (size_t i = 0; i < accessor->count; i++) {
+		std::memcpy(data + i * byteStride, &remappedData[i * elementByteLength], elementByteLength);
+	}
+}
+
+void GLTF::Asset::optimizeVertexFetch() {
+	// Vertices can only be renumbered if every primitive using an attribute also uses the same indices
+	std::vector<GLTF::Accessor*> indicesAccessors;
+	std::map<GLTF::Accessor*, std::vector<GLTF::Primitive*>> indicesPrimitives;
+	std::map<GLTF::Accessor*, GLTF::Accessor*> attributeIndices;
+	std::set<GLTF::Accessor*> skipIndices;
+	for (GLTF::Primitive* primitive : getAllPrimitives()) {
+		GLTF::Accessor* indicesAccessor = primitive->indices;
+		if (indicesAccessor != NULL) {
+			if (indicesPrimitives.find(indicesAccessor) == indicesPrimitives.end()) {
+				indicesAccessors.push_back(indicesAccessor);
+			}
+			indicesPrimitives[indicesAccessor].push_back(primitive);
+			// Draco chooses its own vertex order when encoding
+			if (primitive->extensions.find("KHR_draco_mesh_compression") != primitive->extensions.end()) {
+				skipIndices.insert(indicesAccessor);
+			}
+		}
+		for (GLTF::Accessor* accessor : getAllPrimitiveAccessors(primitive)) {
+			auto findIndices = attributeIndices.find(accessor);
+			if (findIndices == attributeIndices.end()) {
+				attributeIndices[accessor] = indicesAccessor;
+			}
+			else if (findIndices->second != indicesAccessor) {
+				skipIndices.insert(findIndices->second);
+				skipIndices.insert(indicesAccessor);
+			}
+		}
+	}
+
+	for (GLTF::Accessor* indicesAccessor : indicesAccessors) {
+		if (skipIndices.find(indicesAccessor) != skipIndices.end()) {
+			continue;
+		}
+		std::vector<GLTF::Primitive*> primitives = indicesPrimitives[indicesAccessor];
+		auto findPosition = primitives[0]->attributes.find("POSITION");
+		if (findPosition == primitives[0]->attributes.end() || findPosition->second == NULL) {
+			continue;
+		}
+		size_t vertexCount = findPosition->second->count;
+		std::vector<GLTF::Accessor*> accessors;
+		std::set<GLTF::Accessor*> uniqueAccessors;
+		bool canRemap = true;
+		for (GLTF::Primitive* primitive : primitives) {
+			for (GLTF::Accessor* accessor : getAllPrimitiveAccessors(primitive)) {
+				if (accessor == NULL || accessor->bufferView == NULL || accessor->count != vertexCount) {
+					canRemap = false;
+				}
+				else if (uniqueAccessors.find(accessor) == uniqueAccessors.end()) {
+					accessors.push_back(accessor);
+					uniqueAccessors.insert(accessor);
+				}
+			}
+		}
+		std::vector<unsigned int> indices;
+		if (!canRemap || !readIndices(indicesAccessor, &indices)) {
+			continue;
+		}
+
+		std::vector<unsigned int> remap = MeshOptimizer::computeVertexFetchRemap(&indices[0], indices.size(), vertexCount);
+		for (GLTF::Accessor* accessor : accessors) {
+			remapAccessor(accessor, remap);
+		}
+		for (size_t i = 0; i < indices.size(); i++) {
+			if (indices[i] < remap.size()) {
+				indices[i] = remap[indices[i]];
+			}
+		}
+		writeIndices(indicesAccessor, indices);
+	}
+	invalidateIndex();
+}
+
+/**
+ * Gets the screen coverage below which a level of detail with the given error is used, taking an error
+ * of one pixel at a screen height of LOD_REFERENCE_PIXELS as acceptable.
+ */
+const float LOD_REFERENCE_PIXELS = 1000.0f;
+float getScreenCoverage(float error) {
+	if (error <= 0) {
+		return 1.0f;
+	}
+	float coverage = 1.0f / (error * LOD_REFERENCE_PIXELS);
+	return std::min(1.0f, coverage * coverage);
+}
+
+void GLTF::Asset::generateLevelsOfDetail(GLTF::Options* options) {
+	std::set<GLTF::Node*> weightAnimatedNodes;
+	std::set<GLTF::Node*> animatedNodes;
+	for (GLTF::Animation* animation : animations) {
+		for (GLTF::Animation::Channel* channel : animation->channels) {
+			animatedNodes.insert(channel->target->node);
+			if (channel->target->path == GLTF::Animation::Path::WEIGHTS) {
+				weightAnimatedNodes.insert(channel->target->node);
+			}
+		}
+	}
+
+	// Simplify each mesh once, levels are shared by every node that uses the mesh
+	std::map<GLTF::Mesh*, std::vector<GLTF::Mesh*>> meshLevels;
+	std::map<GLTF::Mesh*, std::vector<float>> meshCoverage;
+	for (GLTF::Mesh* mesh : getAllMeshes()) {
+		std::vector<std::vector<unsigned int>> primitiveIndices(mesh->primitives.size());
+		std::vector<bool> simplifiable(mesh->primitives.size(), false);
+		size_t totalIndexCount = 0;
+		for (size_t i = 0; i < mesh->primitives.size(); i++) {
+			GLTF::Primitive* primitive = mesh->primitives[i];
+			auto findPosition = primitive->attributes.find("POSITION");
+			if (primitive->mode != GLTF::Primitive::Mode::TRIANGLES || primitive->indices == NULL || findPosition == primitive->attributes.end()) {
+				continue;
+			}
+			GLTF::Accessor* position = findPosition->second;
+			if (position == NULL || position->bufferView == NULL || position->componentType != GLTF::Constants::WebGL::FLOAT || position->type != GLTF::Accessor::Type::VEC3) {
+				continue;
+			}
+			if (readIndices(primitive->indices, &primitiveIndices[i])) {
+				simplifiable[i] = true;
+				totalIndexCount += primitiveIndices[i].size();
+			}
+		}
+		if (totalIndexCount == 0) {
+			continue;
+		}
+
+		std::vector<GLTF::Mesh*> levels;
+		std::vector<float> coverage;
+		size_t previousIndexCount = totalIndexCount;
+		float ratio = 1.0f;
+		for (int level = 1; level <= options->lodLevels; level++) {
+			ratio *= options->lodRatio;
+			// Each level continues from the previous one, and is simplified before creating any objects since it may not be kept
+			size_t levelIndexCount = 0;
+			float levelError = 0;
+			for (size_t i = 0; i < mesh->primitives.size(); i++) {
+				if (!simplifiable[i]) {
+					continue;
+				}
+				GLTF::Primitive* primitive = mesh->primitives[i];
+				GLTF::Accessor* position = primitive->attributes["POSITION"];
+				const float* positions = (const float*)(position->bufferView->buffer->data + position->bufferView->byteOffset + position->byteOffset);
+				size_t positionStride = position->getByteStride() / sizeof(float);
+				std::vector<unsigned int>& indices = primitiveIndices[i];
+				size_t targetIndexCount = (size_t)(primitive->indices->count * ratio) / 3 * 3;
+				float error = 0;
+				std::vector<unsigned int> simplified = MeshOptimizer::simplify(&indices[0], indices.size(), positions, position->count, positionStride, targetIndexCount, options->lodError, &error);
+				if (simplified.size() > 0 && simplified.size() < indices.size()) {
+					if (options->optimizeVertexCache) {
+						MeshOptimizer::optimizeVertexCache(&simplified[0], simplified.size(), position->count);
+					}
+					indices = simplified;
+					levelError = std::max(levelError, error);
+				}
+				levelIndexCount += indices.size();
+			}
+			// Stop once simplification no longer makes a meaningful difference
+			if (levelIndexCount > previousIndexCount * 0.9) {
+				break;
+			}
+			previousIndexCount = levelIndexCount;
+
+			GLTF::Mesh* levelMesh = new GLTF::Mesh();
+			levelMesh->name = mesh->name + "_LOD" + std::to_string(level);
+			levelMesh->weights = mesh->weights;
+			for (size_t i = 0; i < mesh->primitives.size(); i++) {
+				GLTF::Primitive* primitive = mesh->primitives[i];
+				GLTF::Primitive* levelPrimitive = new GLTF::Primitive();
+				primitive->clone(levelPrimitive);
+				if (simplifiable[i] && primitiveIndices[i].size() < primitive->indices->count) {
+					levelPrimitive->indices = createIndicesAccessor(primitive->indices, primitiveIndices[i]);
+				}
+				levelMesh->primitives.push_back(levelPrimitive);
+			}
+			levels.push_back(levelMesh);
+			coverage.push_back(levelError);
+		}
+		if (levels.size() > 0) {
+			meshLevels[mesh] = levels;
+			meshCoverage[mesh] = coverage;
+		}
+	}
+	if (meshLevels.size() == 0) {
+		return;
+	}
+
+	for (GLTF::Node* node : getAllNodes()) {
+		if (node->mesh == NULL || meshLevels.find(node->mesh) == meshLevels.end()) {
+			continue;
+		}
+		if (weightAnimatedNodes.find(node) != weightAnimatedNodes.end()) {
+			// Morph target weights are animated on this node, levels would not receive them
+			continue;
+		}
+		GLTF::Node* meshNode = node;
+		if (node->children.size() > 0 || animatedNodes.find(node) != animatedNodes.end()) {
+			// Levels replace the whole node, so the mesh is moved to a child that can be swapped on its own
+			meshNode = new GLTF::Node();
+			meshNode->name = node->name;
+			meshNode->mesh = node->mesh;
+			meshNode->skin = node->skin;
+			node->mesh = NULL;
+			node->skin = NULL;
+			node->children.push_back(meshNode);
+		}
+
+		GLTF::LodExtension* lodExtension = new GLTF::LodExtension();
+		GLTF::LodExtension::ScreenCoverage* screenCoverage = new GLTF::LodExtension::ScreenCoverage();
+		std::vector<GLTF::Mesh*> levels = meshLevels[meshNode->mesh];
+		std::vector<float> errors = meshCoverage[meshNode->mesh];
+		for (size_t i = 0; i < levels.size(); i++) {
+			GLTF::Node* levelNode = new GLTF::Node();
+			levelNode->name = meshNode->name + "_LOD" + std::to_string(i + 1);
+			levelNode->mesh = levels[i];
+			levelNode->skin = meshNode->skin;
+			levelNode->transform = meshNode->transform;
+			lodExtension->nodes.push_back(levelNode);
+
+			// Each level is used until the next one is accurate enough
+			float coverage = getScreenCoverage(errors[i]);
+			if (screenCoverage->coverage.size() > 0) {
+				coverage = std::min(coverage, screenCoverage->coverage.back());
+			}
+			screenCoverage->coverage.push_back(coverage);
+		}
+		// The last level is used at any size
+		screenCoverage->coverage.push_back(0.0f);
+		meshNode->extensions["MSFT_lod"] = lodExtension;
+		meshNode->extras["MSFT_screencoverage"] = screenCoverage;
+	}
+	useExtension("MSFT_lod");
+	invalidateIndex();
+}
+
+/**
+ * Decomposes the transform of a node into translation, rotation and scale. Returns false if the
+ * transform has shear or projection, which can not be represented that way.
+ */
+bool getNodeTransformTRS(GLTF::Node* node, GLTF::Node::TransformTRS* trs) {
+	for (int i = 0; i < 3; i++) {
+		trs->translation[i] = 0;
+		trs->rotation[i] = 0;
+		trs->scale[i] = 1;
+	}
+	trs->rotation[3] = 1;
+	if (node->transform == NULL) {
+		return true;
+	}
+	if (node->transform->type == GLTF::Node::Transform::TRS) {
+		GLTF::Node::TransformTRS* transform = (GLTF::Node::TransformTRS*)node->transform;
+		std::memcpy(trs->translation, transform->translation, sizeof(trs->translation));
+		std::memcpy(trs->rotation, transform->rotation, sizeof(trs->rotation));
+		std::memcpy(trs->scale, transform->scale, sizeof(trs->scale));
+		return true;
+	}
+
+	float* matrix = ((GLTF::Node::TransformMatrix*)node->transform)->matrix;
+	if (matrix[3] != 0 || matrix[7] != 0 || matrix[11] != 0 || matrix[15] != 1) {
+		return false;
+	}
+	float scale[3];
+	for (int i = 0; i < 3; i++) {
+		scale[i] = sqrtf(matrix[i * 4] * matrix[i * 4] + matrix[i * 4 + 1] * matrix[i * 4 + 1] + matrix[i * 4 + 2] * matrix[i * 4 + 2]);
+		if (scale[i] == 0) {
+			return false;
+		}
+	}
+	// A mirrored basis is expressed with a negative scale
+	float determinant = matrix[0] * (matrix[5] * matrix[10] - matrix[6] * matrix[9]) -
+		matrix[4] * (matrix[1] * matrix[10] - matrix[2] * matrix[9]) +
+		matrix[8] * (matrix[1] * matrix[6] - matrix[2] * matrix[5]);
+	if (determinant < 0) {
+		scale[0] = -scale[0];
+	}
+	GLTF::Node::TransformMatrix rotation;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			rotation.matrix[i * 4 + j] = matrix[i * 4 + j] / scale[i];
+		}
+	}
+	rotation.getTransformTRS(trs);
+	float length = sqrtf(trs->rotation[0] * trs->rotation[0] + trs->rotation[1] * trs->rotation[1] + trs->rotation[2] * trs->rotation[2] + trs->rotation[3] * trs->rotation[3]);
+	// A quaternion and its negation are the same rotation, keeping w positive lets identity rotations be recognized
+	if (trs->rotation[3] < 0) {
+		length = -length;
+	}
+	for (int i = 0; i < 4; i++) {
+		trs->rotation[i] /= length;
+	}
+	for (int i = 0; i < 3; i++) {
+		trs->translation[i] = matrix[12 + i];
+		trs->scale[i] = scale[i];
+	}
+
+	// Check that the decomposition reproduces the matrix
+	GLTF::Node::TransformMatrix* recomposed = trs->getTransformMatrix();
+	float tolerance = 0;
+	for (int i = 0; i < 16; i++) {
+		tolerance = std::max(tolerance, std::abs(matrix[i]));
+	}
+	tolerance *= 1e-4f;
+	bool equals = true;
+	for (int i = 0; i < 16 && equals; i++) {
+		equals = std::abs(recomposed->matrix[i] - matrix[i]) <= tolerance;
+	}
+	delete recomposed;
+	return equals;
 }
 
-void GLTF::Asset::mergeAnimations() {
-	if (animations.size() == 0) { return; }
-
-	GLTF::Animation* mergedAnimation = new GLTF::Animation();
-
-	// Merge all animations. In the future, animations should be grouped
-	// according to COLLADA <animation_clip/> nodes.
+void GLTF::Asset::instanceMeshes() {
+	// Nodes that are animated or used by skins have to stay separate
+	std::set<GLTF::Node*> fixedNodes;
 	for (GLTF::Animation* animation : animations) {
 		for (GLTF::Animation::Channel* channel : animation->channels) {
-			mergedAnimation->channels.push_back(channel);
+			fixedNodes.insert(channel->target->node);
+		}
+	}
+	for (GLTF::Skin* skin : getAllSkins()) {
+		if (skin->skeleton != NULL) {
+			fixedNodes.insert(skin->skeleton);
+		}
+		for (GLTF::Node* joint : skin->joints) {
+			fixedNodes.insert(joint);
 		}
 	}
 
-	animations.clear();
-	animations.push_back(mergedAnimation);
-}
+	std::vector<std::vector<GLTF::Node*>*> siblingLists;
+	siblingLists.push_back(&getDefaultScene()->nodes);
+	for (GLTF::Node* node : getAllNodes()) {
+		siblingLists.push_back(&node->children);
+	}
 
-void GLTF::Asset::removeUncompressedBufferViews() {
-	for (GLTF::Primitive* primitive : getAllPrimitives()) {
-		auto dracoExtensionPtr = primitive->extensions.find("KHR_draco_mesh_compression");
-		if (dracoExtensionPtr != primitive->extensions.end()) {
-			// Currently assume all attributes are compressed in Draco extension.
-			for (const auto accessor: getAllPrimitiveAccessors(primitive)) {
-				if (accessor->bufferView) {
-					delete accessor->bufferView;
-					accessor->bufferView = NULL;
+	bool instanced = false;
+	for (std::vector<GLTF::Node*>* siblings : siblingLists) {
+		// Only leaf nodes that draw nothing but their mesh can become instances
+		std::vector<GLTF::Mesh*> meshes;
+		std::map<GLTF::Mesh*, std::vector<GLTF::Node*>> meshNodes;
+		for (GLTF::Node* node : *siblings) {
+			if (node->mesh == NULL || node->children.size() > 0 || node->skin != NULL || node->camera != NULL || node->light != NULL || node->extensions.size() > 0 || fixedNodes.find(node) != fixedNodes.end()) {
+				continue;
+			}
+			if (meshNodes.find(node->mesh) == meshNodes.end()) {
+				meshes.push_back(node->mesh);
+			}
+			meshNodes[node->mesh].push_back(node);
+		}
+
+		std::map<GLTF::Node*, GLTF::Node*> replacedNodes;
+		for (GLTF::Mesh* mesh : meshes) {
+			std::vector<GLTF::Node*> instanceNodes;
+			std::vector<float> translations;
+			std::vector<float> rotations;
+			std::vector<float> scales;
+			bool hasRotation = false;
+			bool hasScale = false;
+			for (GLTF::Node* node : meshNodes[mesh]) {
+				GLTF::Node::TransformTRS trs;
+				if (!getNodeTransformTRS(node, &trs)) {
+					continue;
 				}
+				instanceNodes.push_back(node);
+				translations.insert(translations.end(), trs.translation, trs.translation + 3);
+				rotations.insert(rotations.end(), trs.rotation, trs.rotation + 4);
+				scales.insert(scales.end(), trs.scale, trs.scale + 3);
+				hasRotation = hasRotation || !trs.isIdentityRotation();
+				hasScale = hasScale || !trs.isIdentityScale();
 			}
-			GLTF::Accessor* indicesAccessor = primitive->indices;
-			if (indicesAccessor != NULL && indicesAccessor->bufferView) {
-				delete indicesAccessor->bufferView;
-				indicesAccessor->bufferView = NULL;
+			if (instanceNodes.size() < 2) {
+				continue;
+			}
+
+			GLTF::InstancingExtension* instancingExtension = new GLTF::InstancingExtension();
+			instancingExtension->attributes["TRANSLATION"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(translations), (GLTF::Constants::WebGL)-1);
+			if (hasRotation) {
+				instancingExtension->attributes["ROTATION"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC4, GLTF::Constants::WebGL::FLOAT, std::move(rotations), (GLTF::Constants::WebGL)-1);
+			}
+			if (hasScale) {
+				instancingExtension->attributes["SCALE"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(scales), (GLTF::Constants::WebGL)-1);
+			}
+			GLTF::Node* instancedNode = new GLTF::Node();
+			instancedNode->name = instanceNodes[0]->name;
+			instancedNode->mesh = mesh;
+			instancedNode->extensions["EXT_mesh_gpu_instancing"] = instancingExtension;
+
+			// The instanced node takes the place of the first instance
+			replacedNodes[instanceNodes[0]] = instancedNode;
+			for (size_t i = 1; i < instanceNodes.size(); i++) {
+				replacedNodes[instanceNodes[i]] = NULL;
+			}
+		}
+		if (replacedNodes.size() == 0) {
+			continue;
+		}
+
+		std::vector<GLTF::Node*> nodes;
+		for (GLTF::Node* node : *siblings) {
+			auto findReplaced = replacedNodes.find(node);
+			if (findReplaced == replacedNodes.end()) {
+				nodes.push_back(node);
+			}
+			else if (findReplaced->second != NULL) {
+				nodes.push_back(findReplaced->second);
 			}
 		}
+		*siblings = nodes;
+		instanced = true;
+	}
+
+	if (instanced) {
+		requireExtension("EXT_mesh_gpu_instancing");
 	}
+	invalidateIndex();
 }
 
-void GLTF::Asset::removeUnusedSemantics() {
-	for (GLTF::Primitive* primitive : getAllPrimitives()) {
-		GLTF::Material* material = primitive->material;
-		if (material != NULL) {
-			GLTF::Material::Values* values = material->values;
-			std::map<std::string, GLTF::Accessor*> attributes = primitive->attributes;
-			for (const auto attribute : attributes) {
-				std::string semantic = attribute.first;
-				if (semantic.find("TEXCOORD") != std::string::npos) {
-					std::map<std::string, GLTF::Accessor*>::iterator removeTexcoord = primitive->attributes.find(semantic);
-					if (semantic == "TEXCOORD_0") {
-						if (values->ambientTexture == NULL && values->diffuseTexture == NULL && values->emissionTexture == NULL && 
-								values->specularTexture == NULL && values->bumpTexture == NULL) {
-							std::map<std::string, GLTF::Accessor*>::iterator removeTexcoord = primitive->attributes.find(semantic);
-							primitive->attributes.erase(removeTexcoord);
-							removeAttributeFromDracoExtension(primitive, semantic);
-						}
-					}
-					else {
-						// Right now we don't support multiple sets of texture coordinates
-						primitive->attributes.erase(removeTexcoord);
-						removeAttributeFromDracoExtension(primitive, semantic);
-					}
+/**
+ * Creates a normalized vertex attribute accessor from quantized integer values. Each element is padded
+ * to a multiple of four bytes, since glTF requires vertex attribute elements to be aligned to four bytes.
+ */
+GLTF::Accessor* createQuantizedAccessor(GLTF::Accessor::Type type, GLTF::Constants::WebGL componentType, const std::vector<int>& values) {
+	int numberOfComponents = GLTF::Accessor::getNumberOfComponents(type);
+	int componentByteLength = GLTF::Accessor::getComponentByteLength(componentType);
+	int byteStride = (numberOfComponents * componentByteLength + 3) / 4 * 4;
+	size_t count = values.size() / numberOfComponents;
+	unsigned char* data = (unsigned char*)calloc(count * byteStride, 1);
+	GLTF::BufferView* bufferView = new GLTF::BufferView(data, count * byteStride, GLTF::Constants::WebGL::ARRAY_BUFFER);
+	bufferView->byteStride = byteStride;
+	GLTF::Accessor* accessor = new GLTF::Accessor(type, componentType, (size_t)0, count, bufferView);
+	accessor->normalized = true;
+	std::vector<float> component(numberOfComponents);
+	for (size_t i = 0; i < count; i++) {
+		for (int j = 0; j < numberOfComponents; j++) {
+			component[j] = (float)values[i * numberOfComponents + j];
+		}
+		accessor->writeComponentAtIndex(i, &component[0]);
+	}
+	accessor->computeMinMax();
+	return accessor;
+}
+
+/**
+ * Rounds a value in [-1, 1], or [0, 1] if unsigned, to a grid with the given number of bits and returns
+ * the grid point in the normalized integer range of a component type with `typeBits` bits.
+ */
+int quantizeNormalized(float value, int bits, int typeBits, bool isSigned) {
+	bits = std::max(isSigned ? 2 : 1, std::min(typeBits, bits));
+	int gridMax = isSigned ? (1 << (bits - 1)) - 1 : (1 << bits) - 1;
+	int typeMax = isSigned ? (1 << (typeBits - 1)) - 1 : (1 << typeBits) - 1;
+	value = std::max(isSigned ? -1.0f : 0.0f, std::min(1.0f, value));
+	float gridValue = std::round(value * gridMax);
+	return (int)std::round(gridValue * typeMax / gridMax);
+}
+
+/**
+ * Quantizes a float vertex attribute for KHR_mesh_quantization. Positions are stored relative to the
+ * `center` and `halfExtent` of their mesh, which are undone by a node transform. Returns NULL if the
+ * attribute should stay as floats.
+ */
+GLTF::Accessor* quantizeAttribute(const std::string& semantic, GLTF::Accessor* accessor, const float* center, float halfExtent, GLTF::Options* options) {
+	if (accessor == NULL || accessor->bufferView == NULL || accessor->componentType != GLTF::Constants::WebGL::FLOAT || accessor->count == 0) {
+		return NULL;
+	}
+	int numberOfComponents = accessor->getNumberOfComponents();
+	std::vector<int> values(accessor->count * numberOfComponents);
+	std::vector<float> component(numberOfComponents);
+	if (semantic == "POSITION") {
+		if (center == NULL || accessor->type != GLTF::Accessor::Type::VEC3) {
+			return NULL;
+		}
+		int bits = std::max(2, std::min(16, options->positionQuantizationBits));
+		float gridMax = (float)((1 << (bits - 1)) - 1);
+		for (size_t i = 0; i < accessor->count; i++) {
+			accessor->getComponentAtIndex(i, &component[0]);
+			for (int j = 0; j < 3; j++) {
+				float value = std::round((component[j] - center[j]) / halfExtent * gridMax);
+				values[i * 3 + j] = (int)std::max(-gridMax, std::min(gridMax, value));
+			}
+		}
+		return createQuantizedAccessor(accessor->type, GLTF::Constants::WebGL::SHORT, values);
+	}
+	else if (semantic == "NORMAL" || semantic == "TANGENT") {
+		if ((semantic == "NORMAL" && accessor->type != GLTF::Accessor::Type::VEC3) || (semantic == "TANGENT" && accessor->type != GLTF::Accessor::Type::VEC4)) {
+			return NULL;
+		}
+		for (size_t i = 0; i < accessor->count; i++) {
+			accessor->getComponentAtIndex(i, &component[0]);
+			for (int j = 0; j < numberOfComponents; j++) {
+				values[i * numberOfComponents + j] = quantizeNormalized(component[j], options->normalQuantizationBits, 8, true);
+			}
+		}
+		return createQuantizedAccessor(accessor->type, GLTF::Constants::WebGL::BYTE, values);
+	}
+	else if (semantic.find("TEXCOORD") == 0) {
+		// Coordinates outside of [0, 1] can not be represented by a normalized unsigned type
+		for (size_t i = 0; i < accessor->count; i++) {
+			accessor->getComponentAtIndex(i, &component[0]);
+			for (int j = 0; j < numberOfComponents; j++) {
+				if (component[j] < 0 || component[j] > 1) {
+					return NULL;
 				}
+				values[i * numberOfComponents + j] = quantizeNormalized(component[j], options->texcoordQuantizationBits, 16, false);
 			}
 		}
+		return createQuantizedAccessor(accessor->type, GLTF::Constants::WebGL::UNSIGNED_SHORT, values);
 	}
-}
-
-void GLTF::Asset::removeAttributeFromDracoExtension(GLTF::Primitive* primitive, const std::string &semantic) {
-	auto extensionPtr = primitive->extensions.find("KHR_draco_mesh_compression");
-	if (extensionPtr != primitive->extensions.end()) {
-		GLTF::DracoExtension* dracoExtension = (GLTF::DracoExtension*)extensionPtr->second;
-		auto attPtr = dracoExtension->attributeToId.find(semantic);
-		if (attPtr != dracoExtension->attributeToId.end()) {
-			const int att_id = attPtr->second;
-			// Remove from the extension.
-			dracoExtension->attributeToId.erase(attPtr);
-			// Remove from draco mesh.
-			dracoExtension->dracoMesh->DeleteAttribute(att_id);
+	else if (semantic.find("COLOR") == 0) {
+		for (size_t i = 0; i < accessor->count; i++) {
+			accessor->getComponentAtIndex(i, &component[0]);
+			for (int j = 0; j < numberOfComponents; j++) {
+				values[i * numberOfComponents + j] = quantizeNormalized(component[j], options->colorQuantizationBits, 8, false);
+			}
 		}
+		return createQuantizedAccessor(accessor->type, GLTF::Constants::WebGL::UNSIGNED_BYTE, values);
 	}
+	return NULL;
 }
 
-bool isUnusedNode(GLTF::Node* node, std::set<GLTF::Node*> skinNodes, bool isPbr) {
-	if (node->children.size() == 0 && node->mesh == NULL && node->camera == NULL && node->skin == NULL) {
-		if (isPbr || node->light == NULL || node->light->type == GLTF::MaterialCommon::Light::AMBIENT) {
-			if (std::find(skinNodes.begin(), skinNodes.end(), node) == skinNodes.end()) {
-				return true;
-			}
+/**
+ * Applies a dequantization transform, made of a translation and a uniform scale, before each instance
+ * transform of an EXT_mesh_gpu_instancing node by rewriting its per-instance accessors.
+ */
+void dequantizeInstances(GLTF::InstancingExtension* instancingExtension, GLTF::Node::TransformTRS* transform) {
+	GLTF::Accessor* translationAccessor = instancingExtension->attributes["TRANSLATION"];
+	GLTF::Accessor* rotationAccessor = instancingExtension->attributes["ROTATION"];
+	GLTF::Accessor* scaleAccessor = instancingExtension->attributes["SCALE"];
+	size_t count = 0;
+	for (GLTF::Accessor* accessor : { translationAccessor, rotationAccessor, scaleAccessor }) {
+		if (accessor != NULL) {
+			count = accessor->count;
 		}
 	}
-	return false;
+	std::vector<float> translations(count * 3);
+	std::vector<float> scales(count * 3);
+	for (size_t i = 0; i < count; i++) {
+		float translation[3] = { 0, 0, 0 };
+		float rotation[4] = { 0, 0, 0, 1 };
+		float scale[3] = { 1, 1, 1 };
+		if (translationAccessor != NULL) {
+			translationAccessor->getComponentAtIndex(i, translation);
+		}
+		if (rotationAccessor != NULL) {
+			rotationAccessor->getComponentAtIndex(i, rotation);
+		}
+		if (scaleAccessor != NULL) {
+			scaleAccessor->getComponentAtIndex(i, scale);
+		}
+		// Rotate the scaled dequantization offset by the instance rotation quaternion
+		float offset[3];
+		for (int j = 0; j < 3; j++) {
+			offset[j] = transform->translation[j] * scale[j];
+		}
+		float cross[3] = {
+			rotation[1] * offset[2] - rotation[2] * offset[1] + rotation[3] * offset[0],
+			rotation[2] * offset[0] - rotation[0] * offset[2] + rotation[3] * offset[1],
+			rotation[0] * offset[1] - rotation[1] * offset[0] + rotation[3] * offset[2]
+		};
+		float rotated[3] = {
+			offset[0] + 2 * (rotation[1] * cross[2] - rotation[2] * cross[1]),
+			offset[1] + 2 * (rotation[2] * cross[0] - rotation[0] * cross[2]),
+			offset[2] + 2 * (rotation[0] * cross[1] - rotation[1] * cross[0])
+		};
+		for (int j = 0; j < 3; j++) {
+			translations[i * 3 + j] = translation[j] + rotated[j];
+			scales[i * 3 + j] = scale[j] * transform->scale[j];
+		}
+	}
+	instancingExtension->attributes["TRANSLATION"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(translations), (GLTF::Constants::WebGL)-1);
+	instancingExtension->attributes["SCALE"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(scales), (GLTF::Constants::WebGL)-1);
+	if (rotationAccessor == NULL) {
+		instancingExtension->attributes.erase("ROTATION");
+	}
 }
 
-void GLTF::Asset::removeUnusedNodes(GLTF::Options* options) {
-	std::vector<GLTF::Node*> nodeStack;
-	std::set<GLTF::Node*> skinNodes;
-	bool isPbr = !options->glsl && !options->materialsCommon;
-	for (GLTF::Skin* skin : getAllSkins()) {
-		if (skin->skeleton != NULL) {
-			skinNodes.insert(skin->skeleton);
+void GLTF::Asset::quantizeAttributes(GLTF::Options* options) {
+	std::vector<GLTF::Node*> nodes = getAllNodes();
+	std::vector<GLTF::Mesh*> meshes = getAllMeshes();
+
+	// Node transforms don't apply to skinned meshes, and morph targets are stored as float offsets
+	std::set<GLTF::Mesh*> skipMeshes;
+	for (GLTF::Node* node : nodes) {
+		if (node->mesh != NULL && node->skin != NULL) {
+			skipMeshes.insert(node->mesh);
 		}
-		for (GLTF::Node* jointNode : skin->joints) {
-			skinNodes.insert(jointNode);
+	}
+	for (GLTF::Mesh* mesh : meshes) {
+		for (GLTF::Primitive* primitive : mesh->primitives) {
+			if (primitive->targets.size() > 0 || primitive->extensions.find("KHR_draco_mesh_compression") != primitive->extensions.end()) {
+				skipMeshes.insert(mesh);
+			}
 		}
 	}
 
-	GLTF::Scene* defaultScene = getDefaultScene();
-	bool needsPass = true;
-	while (needsPass) {
-		needsPass = false;
-		for (size_t i = 0; i < defaultScene->nodes.size(); i++) {
-			GLTF::Node* node = defaultScene->nodes[i];
-			if (isUnusedNode(node, skinNodes, isPbr)) {
-				// Nodes associated with ambient lights may be optimized out,
-				// but we should hang on to the lights so that they are 
-				// still written into the shader or common materials object.
-				if (node->light != NULL) {
-					_ambientLights.push_back(node->light);
-				}
-				defaultScene->nodes.erase(defaultScene->nodes.begin() + i);
-				i--;
+	// Meshes that share a position accessor, such as levels of detail, must also share a dequantization transform
+	std::vector<size_t> meshGroups(meshes.size());
+	std::function<size_t(size_t)> findGroup = [&meshGroups](size_t group) {
+		while (meshGroups[group] != group) {
+			meshGroups[group] = meshGroups[meshGroups[group]];
+			group = meshGroups[group];
+		}
+		return group;
+	};
+	std::map<GLTF::Accessor*, size_t> positionGroups;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		meshGroups[i] = i;
+	}
+	for (size_t i = 0; i < meshes.size(); i++) {
+		if (skipMeshes.find(meshes[i]) != skipMeshes.end()) {
+			continue;
+		}
+		for (GLTF::Primitive* primitive : meshes[i]->primitives) {
+			auto findPosition = primitive->attributes.find("POSITION");
+			if (findPosition == primitive->attributes.end()) {
+				continue;
+			}
+			auto findGroupIndex = positionGroups.find(findPosition->second);
+			if (findGroupIndex == positionGroups.end()) {
+				positionGroups[findPosition->second] = i;
 			}
 			else {
-				nodeStack.push_back(node);
+				meshGroups[findGroup(i)] = findGroup(findGroupIndex->second);
 			}
 		}
-		while (nodeStack.size() > 0) {
-			GLTF::Node* node = nodeStack.back();
-			nodeStack.pop_back();
-			for (size_t i = 0; i < node->children.size(); i++) {
-				GLTF::Node* child = node->children[i];
-				if (isUnusedNode(child, skinNodes, isPbr)) {
-					if (child->light != NULL) {
-						_ambientLights.push_back(child->light);
-					}
-					// this node is extraneous, remove it
-					node->children.erase(node->children.begin() + i);
-					i--;
-					if (node->children.size() == 0) {
-						// another pass may be required to clean up the parent
-						needsPass = true;
-					}
+	}
+
+	// Each group gets a uniform scale so that normals are not distorted by the dequantization transform
+	std::map<size_t, std::vector<float>> groupBounds;
+	std::set<size_t> skipGroups;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		if (skipMeshes.find(meshes[i]) != skipMeshes.end()) {
+			continue;
+		}
+		size_t group = findGroup(i);
+		for (GLTF::Primitive* primitive : meshes[i]->primitives) {
+			auto findPosition = primitive->attributes.find("POSITION");
+			GLTF::Accessor* position = findPosition == primitive->attributes.end() ? NULL : findPosition->second;
+			if (position == NULL || position->bufferView == NULL || position->componentType != GLTF::Constants::WebGL::FLOAT || position->type != GLTF::Accessor::Type::VEC3) {
+				skipGroups.insert(group);
+				continue;
+			}
+			std::vector<float>& bounds = groupBounds[group];
+			float component[3];
+			for (size_t j = 0; j < position->count; j++) {
+				position->getComponentAtIndex(j, component);
+				if (bounds.size() == 0) {
+					bounds.assign(component, component + 3);
+					bounds.insert(bounds.end(), component, component + 3);
 				}
-				else {
-					nodeStack.push_back(child);
+				for (int k = 0; k < 3; k++) {
+					bounds[k] = std::min(bounds[k], component[k]);
+					bounds[k + 3] = std::max(bounds[k + 3], component[k]);
 				}
 			}
 		}
 	}
-}
 
-GLTF::BufferView* packAccessorsForTargetByteStride(std::vector<GLTF::Accessor*> accessors, GLTF::Constants::WebGL target, size_t byteStride) {
-	std::map<GLTF::Accessor*, size_t> byteOffsets;
-	size_t byteLength = 0;
-	for (GLTF::Accessor* accessor : accessors) {
-		int componentByteLength = accessor->getComponentByteLength();
-		int padding = byteLength % componentByteLength;
-		if (padding != 0) {
-			byteLength += (componentByteLength - padding);
+	std::map<GLTF::Accessor*, GLTF::Accessor*> quantizedAccessors;
+	std::map<GLTF::Mesh*, GLTF::Node::TransformTRS*> meshTransforms;
+	bool quantized = false;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		GLTF::Mesh* mesh = meshes[i];
+		if (skipMeshes.find(mesh) != skipMeshes.end()) {
+			continue;
+		}
+		size_t group = findGroup(i);
+		float center[3];
+		float halfExtent = 0;
+		bool quantizePositions = skipGroups.find(group) == skipGroups.end() && groupBounds[group].size() == 6;
+		if (quantizePositions) {
+			std::vector<float>& bounds = groupBounds[group];
+			for (int k = 0; k < 3; k++) {
+				center[k] = (bounds[k] + bounds[k + 3]) / 2;
+				halfExtent = std::max(halfExtent, (bounds[k + 3] - bounds[k]) / 2);
+			}
+			if (halfExtent == 0) {
+				halfExtent = 1;
+			}
+			// Decoding a normalized short divides by 32767, the transform maps that back to the original bounds
+			int bits = std::max(2, std::min(16, options->positionQuantizationBits));
+			float scale = halfExtent * 32767.0f / ((1 << (bits - 1)) - 1);
+			GLTF::Node::TransformTRS* transform = new GLTF::Node::TransformTRS();
+			for (int k = 0; k < 3; k++) {
+				transform->translation[k] = center[k];
+				transform->rotation[k] = 0;
+				transform->scale[k] = scale;
+			}
+			transform->rotation[3] = 1;
+			meshTransforms[mesh] = transform;
+		}
+		for (GLTF::Primitive* primitive : mesh->primitives) {
+			for (auto& attribute : primitive->attributes) {
+				GLTF::Accessor* accessor = attribute.second;
+				auto findQuantized = quantizedAccessors.find(accessor);
+				if (findQuantized == quantizedAccessors.end()) {
+					GLTF::Accessor* quantizedAccessor = quantizeAttribute(attribute.first, accessor, quantizePositions ? center : NULL, halfExtent, options);
+					findQuantized = quantizedAccessors.insert(std::make_pair(accessor, quantizedAccessor)).first;
+				}
+				if (findQuantized->second != NULL) {
+					attribute.second = findQuantized->second;
+					quantized = true;
+				}
+			}
 		}
-		byteOffsets[accessor] = byteLength;
-		byteLength += componentByteLength * accessor->getNumberOfComponents() * accessor->count;
 	}
-	unsigned char* bufferData = new unsigned char[byteLength];
-	GLTF::BufferView* bufferView = new GLTF::BufferView(bufferData, byteLength, target);
-	for (GLTF::Accessor* accessor : accessors) {
-		size_t byteOffset = byteOffsets[accessor];
-		GLTF::Accessor* packedAccessor = new GLTF::Accessor(accessor->type, accessor->componentType, byteOffset, accessor->count, bufferView);
-		int numberOfComponents = accessor->getNumberOfComponents();
-		float* component = new float[numberOfComponents];
-		for (int i = 0; i < accessor->count; i++) {
-			accessor->getComponentAtIndex(i, component);
-			packedAccessor->writeComponentAtIndex(i, component);
+
+	// Dequantize positions with a child node, leaving the node's own transform and children untouched
+	for (GLTF::Node* node : nodes) {
+		if (node->mesh == NULL) {
+			continue;
+		}
+		auto findTransform = meshTransforms.find(node->mesh);
+		if (findTransform == meshTransforms.end()) {
+			continue;
+		}
+		auto findInstancing = node->extensions.find("EXT_mesh_gpu_instancing");
+		if (findInstancing != node->extensions.end()) {
+			// Instance transforms are applied before the node transform, so a child node can't be used
+			dequantizeInstances((GLTF::InstancingExtension*)findInstancing->second, findTransform->second);
+			continue;
 		}
-		accessor->byteOffset = packedAccessor->byteOffset;
-		accessor->bufferView = packedAccessor->bufferView;
+		GLTF::Node* meshNode = new GLTF::Node();
+		meshNode->name = node->name;
+		meshNode->mesh = node->mesh;
+		meshNode->transform = findTransform->second;
+		node->mesh = NULL;
+		node->children.push_back(meshNode);
 	}
-	return bufferView;
+
+	if (quantized) {
+		requireExtension("KHR_mesh_quantization");
+	}
+	invalidateIndex();
 }
 
 bool GLTF::Asset::compressPrimitives(GLTF::Options* options) {
@@ -605,89 +2519,260 @@ bool GLTF::Asset::compressPrimitives(GLTF::Options* options) {
 	return true;
 }
 
-GLTF::Buffer* GLTF::Asset::packAccessors() {
+/**
+ * A bufferView in the packed buffers along with the accessors placed in it. Layouts are planned before
+ * any data is copied, so each packed buffer can be allocated once and filled directly.
+ */
+class BufferViewLayout {
+public:
+	GLTF::BufferView* bufferView;
+	std::vector<std::pair<GLTF::Accessor*, size_t>> accessorOffsets;
+	size_t alignment = 1;
+	size_t bufferIndex = 0;
+};
+
+/**
+ * Plans the bufferViews holding accessors that share a target and byteStride, starting each accessor on a
+ * multiple of its component size. A new bufferView is started whenever the next accessor would take the
+ * current one over `maxByteLength`, unless it is 0.
+ */
+std::vector<BufferViewLayout> planAccessorsForTargetByteStride(const std::vector<GLTF::Accessor*>& accessors, GLTF::Constants::WebGL target, int byteStride, size_t maxByteLength) {
+	std::vector<BufferViewLayout> layouts;
+	size_t byteLength = 0;
+	for (GLTF::Accessor* accessor : accessors) {
+		int componentByteLength = accessor->getComponentByteLength();
+		size_t padding = byteLength % componentByteLength;
+		if (padding != 0) {
+			padding = componentByteLength - padding;
+		}
+		size_t accessorByteLength;
+		if (target == GLTF::Constants::WebGL::ARRAY_BUFFER) {
+			// Vertex attribute elements may be padded past their components
+			accessorByteLength = byteStride * accessor->count;
+		}
+		else {
+			accessorByteLength = accessor->count * componentByteLength * accessor->getNumberOfComponents();
+		}
+		if (layouts.size() == 0 || (maxByteLength > 0 && byteLength > 0 && byteLength + padding + accessorByteLength > maxByteLength)) {
+			BufferViewLayout layout;
+			layout.bufferView = new GLTF::BufferView(0, 0, NULL);
+			layout.bufferView->target = target;
+			if (target == GLTF::Constants::WebGL::ARRAY_BUFFER) {
+				layout.bufferView->byteStride = byteStride;
+			}
+			layouts.push_back(layout);
+			byteLength = 0;
+			padding = 0;
+		}
+		BufferViewLayout& layout = layouts.back();
+		byteLength += padding;
+		layout.accessorOffsets.push_back(std::make_pair(accessor, byteLength));
+		layout.alignment = std::max(layout.alignment, (size_t)componentByteLength);
+		byteLength += accessorByteLength;
+		layout.bufferView->byteLength = byteLength;
+	}
+	return layouts;
+}
+
+/**
+ * Plans the interleaving of the vertex attributes of each primitive into a single bufferView, so that each
+ * vertex is stored contiguously. Primitives that use the same attributes share the bufferView, attributes
+ * that are shared with a primitive using a different set of attributes are left to be packed on their own.
+ */
+std::vector<BufferViewLayout> planInterleavedAttributes(const std::vector<GLTF::Primitive*>& primitives, std::set<GLTF::Accessor*>* interleavedAccessors) {
+	std::vector<std::vector<GLTF::Accessor*>> attributeSets;
+	std::map<std::vector<GLTF::Accessor*>, size_t> attributeSetIndices;
+	std::map<GLTF::Accessor*, size_t> accessorSets;
+	std::set<size_t> skipSets;
+	for (GLTF::Primitive* primitive : primitives) {
+		std::vector<GLTF::Accessor*> attributeSet;
+		bool valid = true;
+		for (const auto& attribute : primitive->attributes) {
+			GLTF::Accessor* accessor = attribute.second;
+			if (accessor == NULL || accessor->bufferView == NULL || accessor->bufferView->target != GLTF::Constants::WebGL::ARRAY_BUFFER) {
+				valid = false;
+			}
+			else if (attributeSet.size() > 0 && accessor->count != attributeSet[0]->count) {
+				valid = false;
+			}
+			attributeSet.push_back(accessor);
+		}
+		if (!valid || attributeSet.size() < 2 || attributeSetIndices.find(attributeSet) != attributeSetIndices.end()) {
+			continue;
+		}
+		size_t setIndex = attributeSets.size();
+		attributeSetIndices[attributeSet] = setIndex;
+		attributeSets.push_back(attributeSet);
+		for (GLTF::Accessor* accessor : attributeSet) {
+			auto findSet = accessorSets.find(accessor);
+			if (findSet != accessorSets.end()) {
+				skipSets.insert(findSet->second);
+				skipSets.insert(setIndex);
+			}
+			else {
+				accessorSets[accessor] = setIndex;
+			}
+		}
+	}
+
+	std::vector<BufferViewLayout> layouts;
+	for (size_t setIndex = 0; setIndex < attributeSets.size(); setIndex++) {
+		if (skipSets.find(setIndex) != skipSets.end()) {
+			continue;
+		}
+		std::vector<GLTF::Accessor*>& attributeSet = attributeSets[setIndex];
+		// Each attribute starts on a four byte boundary within the vertex
+		BufferViewLayout layout;
+		layout.alignment = 4;
+		size_t byteStride = 0;
+		for (GLTF::Accessor* accessor : attributeSet) {
+			layout.accessorOffsets.push_back(std::make_pair(accessor, byteStride));
+			byteStride += (accessor->getNumberOfComponents() * accessor->getComponentByteLength() + 3) / 4 * 4;
+		}
+		if (byteStride > 252) {
+			// The largest byteStride allowed by glTF
+			continue;
+		}
+		layout.bufferView = new GLTF::BufferView(0, attributeSet[0]->count * byteStride, NULL);
+		layout.bufferView->target = GLTF::Constants::WebGL::ARRAY_BUFFER;
+		layout.bufferView->byteStride = byteStride;
+		for (GLTF::Accessor* accessor : attributeSet) {
+			interleavedAccessors->insert(accessor);
+		}
+		layouts.push_back(layout);
+	}
+	return layouts;
+}
+
+/**
+ * Copies the elements of an accessor from its current bufferView to `destination`, spacing them by
+ * `byteStride`. A single memcpy is used when neither side has padding between elements.
+ */
+void copyAccessorData(GLTF::Accessor* accessor, unsigned char* destination, size_t byteStride) {
+	GLTF::BufferView* bufferView = accessor->bufferView;
+	unsigned char* source = bufferView->buffer->data + bufferView->byteOffset + accessor->byteOffset;
+	size_t elementByteLength = accessor->getNumberOfComponents() * accessor->getComponentByteLength();
+	size_t sourceByteStride = accessor->getByteStride();
+	size_t count = accessor->count;
+	if (sourceByteStride == elementByteLength && byteStride == elementByteLength) {
+		std::memcpy(destination, source, elementByteLength * count);
+		return;
+	}
+	for (size_t i = 0; i < count; i++) {
+		std::memcpy(destination + i * byteStride, source + i * sourceByteStride, elementByteLength);
+	}
+}
+
+std::vector<GLTF::Buffer*> GLTF::Asset::packAccessors(GLTF::Options* options) {
 	std::map<GLTF::Constants::WebGL, std::map<int, std::vector<GLTF::Accessor*>>> accessorGroups;
 	accessorGroups[GLTF::Constants::WebGL::ARRAY_BUFFER] = std::map<int, std::vector<GLTF::Accessor*>>();
 	accessorGroups[GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER] = std::map<int, std::vector<GLTF::Accessor*>>();
 	accessorGroups[(GLTF::Constants::WebGL)-1] = std::map<int, std::vector<GLTF::Accessor*>>();
 
-	size_t byteLength = 0;
+	std::set<GLTF::Accessor*> interleavedAccessors;
+	std::vector<BufferViewLayout> interleavedLayouts;
+	if (options->interleave) {
+		interleavedLayouts = planInterleavedAttributes(getAllPrimitives(), &interleavedAccessors);
+	}
 	for (GLTF::Accessor* accessor : getAllAccessors()) {
 		// In glTF 2.0, bufferView is not required in accessor.
-		if (accessor->bufferView == NULL) {
+		if (accessor->bufferView == NULL || interleavedAccessors.find(accessor) != interleavedAccessors.end()) {
 			continue;
 		}
 		GLTF::Constants::WebGL target = accessor->bufferView->target;
-		auto targetGroup = accessorGroups[target];
-		int byteStride = accessor->getByteStride();
-		auto findByteStrideGroup = targetGroup.find(byteStride);
-		std::vector<GLTF::Accessor*> byteStrideGroup;
-		if (findByteStrideGroup == targetGroup.end()) {
-			byteStrideGroup = std::vector<GLTF::Accessor*>();
-		}
-		else {
-			byteStrideGroup = findByteStrideGroup->second;
-		}
-		byteStrideGroup.push_back(accessor);
-		targetGroup[byteStride] = byteStrideGroup;
-		accessorGroups[target] = targetGroup;
-		byteLength += accessor->bufferView->byteLength;
-	}
-
-	// Go through primitives and look for primitives that use Draco extension.
-	// If extension is not enabled, the vector will be empty.
-	std::vector<GLTF::BufferView*> compressedBufferViews = getAllCompressedBufferView();
-	// Reserve data for compressed data.
-	for (GLTF::BufferView* compressedBufferView : compressedBufferViews) {
-		byteLength += compressedBufferView->byteLength;
+		accessorGroups[target][accessor->getByteStride()].push_back(accessor);
 	}
 
+	size_t maxBufferSize = (size_t)std::max(0, options->maxBufferSize) * 1024 * 1024;
 	std::vector<int> byteStrides;
-	std::map<int, std::vector<GLTF::BufferView*>> bufferViews;
-	for (auto targetGroup : accessorGroups) {
-		for (auto byteStrideGroup : targetGroup.second) {
-			GLTF::Constants::WebGL target = targetGroup.first;
+	std::map<int, std::vector<BufferViewLayout>> layouts;
+	for (const auto& targetGroup : accessorGroups) {
+		for (const auto& byteStrideGroup : targetGroup.second) {
 			int byteStride = byteStrideGroup.first;
-			GLTF::BufferView* bufferView = packAccessorsForTargetByteStride(byteStrideGroup.second, target, byteStride);
-			if (target == GLTF::Constants::WebGL::ARRAY_BUFFER) {
-				bufferView->byteStride = byteStride;
-			}
-			auto findBufferViews = bufferViews.find(byteStride);
-			std::vector<GLTF::BufferView*> bufferViewGroup;
-			if (findBufferViews == bufferViews.end()) {
+			if (layouts.find(byteStride) == layouts.end()) {
 				byteStrides.push_back(byteStride);
-				bufferViewGroup = std::vector<GLTF::BufferView*>();
 			}
-			else {
-				bufferViewGroup = findBufferViews->second;
+			for (const BufferViewLayout& layout : planAccessorsForTargetByteStride(byteStrideGroup.second, targetGroup.first, byteStride, maxBufferSize)) {
+				layouts[byteStride].push_back(layout);
 			}
-			bufferViewGroup.push_back(bufferView);
-			bufferViews[byteStride] = bufferViewGroup;
 		}
 	}
+	for (const BufferViewLayout& layout : interleavedLayouts) {
+		int byteStride = layout.bufferView->byteStride;
+		if (layouts.find(byteStride) == layouts.end()) {
+			byteStrides.push_back(byteStride);
+		}
+		layouts[byteStride].push_back(layout);
+	}
 	std::sort(byteStrides.begin(), byteStrides.end(), std::greater<int>());
 
-	// Pack these into a buffer sorted from largest byteStride to smallest
-	unsigned char* bufferData = new unsigned char[byteLength];
-	GLTF::Buffer* buffer = new GLTF::Buffer(bufferData, byteLength);
-	size_t byteOffset = 0;
+	// Lay the bufferViews out from largest byteStride to smallest before copying anything, starting a new
+	// buffer whenever the next bufferView would go over the maximum buffer size. Accessors are never
+	// split, so a bufferView holding one larger than the maximum gets a buffer of its own.
+	std::vector<size_t> bufferByteLengths(1, 0);
+	auto placeBufferView = [&](size_t byteLength, size_t alignment, size_t* bufferIndex) -> size_t {
+		size_t byteOffset = bufferByteLengths.back();
+		size_t padding = byteOffset % alignment;
+		if (padding != 0) {
+			byteOffset += alignment - padding;
+		}
+		if (maxBufferSize > 0 && byteOffset > 0 && byteOffset + byteLength > maxBufferSize) {
+			bufferByteLengths.push_back(0);
+			byteOffset = 0;
+		}
+		*bufferIndex = bufferByteLengths.size() - 1;
+		bufferByteLengths.back() = byteOffset + byteLength;
+		return byteOffset;
+	};
+	for (int byteStride : byteStrides) {
+		for (BufferViewLayout& layout : layouts[byteStride]) {
+			layout.bufferView->byteOffset = placeBufferView(layout.bufferView->byteLength, layout.alignment, &layout.bufferIndex);
+		}
+	}
+
+	// Go through primitives and look for primitives that use Draco extension.
+	// If extension is not enabled, the vector will be empty.
+	std::vector<GLTF::BufferView*> compressedBufferViews = getAllCompressedBufferView();
+	std::vector<size_t> compressedBufferIndices(compressedBufferViews.size());
+	std::vector<size_t> compressedByteOffsets(compressedBufferViews.size());
+	for (size_t i = 0; i < compressedBufferViews.size(); i++) {
+		compressedByteOffsets[i] = placeBufferView(compressedBufferViews[i]->byteLength, 1, &compressedBufferIndices[i]);
+	}
+
+	// Copy each accessor straight from its source into its final location. Buffers are allocated
+	// with calloc so that images can be appended to them later.
+	std::vector<GLTF::Buffer*> buffers;
+	for (size_t byteLength : bufferByteLengths) {
+		unsigned char* bufferData = (unsigned char*)calloc(std::max(byteLength, (size_t)1), 1);
+		buffers.push_back(new GLTF::Buffer(bufferData, byteLength));
+	}
 	for (int byteStride : byteStrides) {
-		for (GLTF::BufferView* bufferView : bufferViews[byteStride]) {
-			std::memcpy(bufferData + byteOffset, bufferView->buffer->data, bufferView->byteLength);
-			bufferView->byteOffset = byteOffset;
+		for (BufferViewLayout& layout : layouts[byteStride]) {
+			GLTF::BufferView* bufferView = layout.bufferView;
+			GLTF::Buffer* buffer = buffers[layout.bufferIndex];
+			for (const auto& accessorOffset : layout.accessorOffsets) {
+				GLTF::Accessor* accessor = accessorOffset.first;
+				size_t elementByteStride = bufferView->byteStride;
+				if (elementByteStride == 0) {
+					elementByteStride = accessor->getNumberOfComponents() * accessor->getComponentByteLength();
+				}
+				copyAccessorData(accessor, buffer->data + bufferView->byteOffset + accessorOffset.second, elementByteStride);
+				accessor->bufferView = bufferView;
+				accessor->byteOffset = accessorOffset.second;
+			}
 			bufferView->buffer = buffer;
-			byteOffset += bufferView->byteLength;
 		}
 	}
 
 	// Append compressed data to buffer.
-	for (GLTF::BufferView* compressedBufferView : compressedBufferViews) {
-		std::memcpy(bufferData + byteOffset, compressedBufferView->buffer->data, compressedBufferView->byteLength);
-		compressedBufferView->byteOffset = byteOffset;
+	for (size_t i = 0; i < compressedBufferViews.size(); i++) {
+		GLTF::BufferView* compressedBufferView = compressedBufferViews[i];
+		GLTF::Buffer* buffer = buffers[compressedBufferIndices[i]];
+		std::memcpy(buffer->data + compressedByteOffsets[i], compressedBufferView->buffer->data, compressedBufferView->byteLength);
+		compressedBufferView->byteOffset = compressedByteOffsets[i];
 		compressedBufferView->buffer = buffer;
-		byteOffset += compressedBufferView->byteLength;
 	}
-	return buffer;
+	return buffers;
 }
 
 void GLTF::Asset::requireExtension(std::string extension) {
@@ -700,7 +2785,7 @@ void GLTF::Asset::useExtension(std::string extension) {
 }
 
 void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	if (options->binary && options->version == "1.0") {
 		useExtension("KHR_binary_glTF");
@@ -749,6 +2834,12 @@ void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
 						nodeStack.push_back(skin->skeleton);
 					}
 				}
+				auto findLod = node->extensions.find("MSFT_lod");
+				if (findLod != node->extensions.end()) {
+					for (GLTF::Node* lodNode : ((GLTF::LodExtension*)findLod->second)->nodes) {
+						nodeStack.push_back(lodNode);
+					}
+				}
 			}
 			if (options->version == "1.0") {
 				jsonWriter->Key(scene->getStringId().c_str());
@@ -776,7 +2867,8 @@ void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
 		}
 	}
 
-	// Write nodes and build mesh, skin, camera, and light arrays
+	// Write nodes and build mesh, skin, camera, light, and instance accessor arrays
+	std::vector<GLTF::Accessor*> accessors;
 	std::vector<GLTF::Mesh*> meshes;
 	std::vector<GLTF::Skin*> skins;
 	std::vector<GLTF::Camera*> cameras;
@@ -814,6 +2906,15 @@ void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
 				light->id = lights.size();
 				lights.push_back(light);
 			}
+			auto findInstancing = node->extensions.find("EXT_mesh_gpu_instancing");
+			if (findInstancing != node->extensions.end()) {
+				for (const auto& attribute : ((GLTF::InstancingExtension*)findInstancing->second)->attributes) {
+					if (attribute.second->id < 0) {
+						attribute.second->id = accessors.size();
+						accessors.push_back(attribute.second);
+					}
+				}
+			}
 			if (options->version == "1.0") {
 				jsonWriter->Key(node->getStringId().c_str());
 			}
@@ -856,7 +2957,6 @@ void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
 	}
 
 	// Write meshes and build accessor and material arrays
-	std::vector<GLTF::Accessor*> accessors;
 	std::vector<GLTF::BufferView*> bufferViews;
 	std::vector<GLTF::Material*> materials;
 	std::map<std::string, GLTF::Technique*> generatedTechniques;
@@ -970,6 +3070,8 @@ void GLTF::Asset::writeJSON(void* writer, GLTF::Options* options) {
 		else {
 			jsonWriter->EndArray();
 		}
+		// Converted materials bring in generated techniques, shaders and metallicRoughness images
+		invalidateIndex();
 	}
 
 	// Write animations and add accessors to the accessor array
@@ -1,10 +1,8 @@
 #include "GLTFBuffer.h"
-#include "Base64.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
-GLTF::Buffer::Buffer(unsigned char* data, int dataLength) {
+GLTF::Buffer::Buffer(unsigned char* data, size_t dataLength) {
 	this->data = data;
 	this->byteLength = dataLength;
 }
@@ -14,18 +12,18 @@ std::string GLTF::Buffer::typeName() {
 }
 
 void GLTF::Buffer::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("byteLength");
-	jsonWriter->Int(this->byteLength);
+	jsonWriter->Uint64(this->byteLength);
 	if (!options->binary || !options->embeddedBuffers) {
 		jsonWriter->Key("uri");
 		if (options->embeddedBuffers) {
-			uri = "data:application/octet-stream;base64," + std::string(Base64::encode(this->data, this->byteLength));
+			jsonWriter->DataUri("application/octet-stream", this->data, this->byteLength);
 		}
 		else {
 			uri = options->name + std::to_string(id) + ".bin";
+			jsonWriter->String(uri.c_str());
 		}
-		jsonWriter->String(uri.c_str());
 	}
 	GLTF::Object::writeJSON(writer, options);
 }
@@ -1,14 +1,13 @@
 #include "GLTFCamera.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Camera::typeName() {
 	return "camera";
 }
 
 void GLTF::Camera::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	if (type != Type::UNKNOWN) {
 		jsonWriter->Key("type");
@@ -23,7 +22,7 @@ void GLTF::Camera::writeJSON(void* writer, GLTF::Options* options) {
 }
 
 void GLTF::CameraOrthographic::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("orthographic");
 	jsonWriter->StartObject();
@@ -41,7 +40,7 @@ void GLTF::CameraOrthographic::writeJSON(void* writer, GLTF::Options* options) {
 }
 
 void GLTF::CameraPerspective::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("perspective");
 	jsonWriter->StartObject();
@@ -1,12 +1,11 @@
 #include "GLTFDracoExtension.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 #include <iostream>
 
 void GLTF::DracoExtension::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("bufferView");
 	jsonWriter->Int(this->bufferView->id);
 	jsonWriter->Key("attributes");
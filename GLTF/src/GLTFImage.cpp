@@ -1,65 +1,353 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <mutex>
 
-#include "Base64.h"
 #include "GLTFImage.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const size_t IMAGE_CHUNK_LENGTH = 65536;
 
 std::map<std::string, GLTF::Image*> _imageCache;
+// Images can be loaded and destroyed from several threads
+std::mutex _imageCacheMutex;
 
 GLTF::Image::Image(std::string uri, std::string cacheKey) : uri(uri), cacheKey(cacheKey) {}
 
 GLTF::Image::Image(std::string uri) : Image(uri, "") {}
 
-GLTF::Image::Image(std::string uri, std::string cacheKey, unsigned char* data, size_t byteLength, std::string fileExtension) : uri(uri), data(data), byteLength(byteLength), cacheKey(cacheKey) {
-	std::string dataSubstring((char*)data, 8);
-	if (dataSubstring.substr(1, 7) == "PNG\r\n\x1a\n") {
-		mimeType = "image/png";
-	}
-	else if (data[0] == 255 && data[1] == 216) {
-		mimeType = "image/jpeg";
-	}
-	else {
-		mimeType = "image/" + fileExtension;
-	}
+GLTF::Image::Image(std::string uri, std::string cacheKey, unsigned char* data, size_t byteLength, std::string fileExtension) : uri(uri), cacheKey(cacheKey) {
+	setData(data, byteLength, fileExtension);
 }
 
 GLTF::Image::Image(std::string uri, unsigned char* data, size_t byteLength, std::string fileExtension) : Image(uri, "", data, byteLength, fileExtension) {}
 
 GLTF::Image::~Image() {
+	if (_loading.valid()) {
+		_loading.wait();
+	}
 	if (!cacheKey.empty()) {
+		std::lock_guard<std::mutex> lock(_imageCacheMutex);
 		_imageCache.erase(cacheKey);
 	}
+	if (_ownsData) {
+		free(_data);
+	}
+}
+
+void GLTF::Image::setData(unsigned char* data, size_t byteLength, std::string fileExtension) {
+	_data = data;
+	_byteLength = byteLength;
+	if (byteLength >= 8 && std::string((char*)data + 1, 7) == "PNG\r\n\x1a\n") {
+		_mimeType = "image/png";
+	}
+	else if (byteLength >= 2 && data[0] == 255 && data[1] == 216) {
+		_mimeType = "image/jpeg";
+	}
+	else {
+		_mimeType = "image/" + fileExtension;
+	}
+}
+
+/**
+ * Reads the whole file into this image, leaving it without data if the file can't be opened.
+ */
+void GLTF::Image::read() {
+	FILE* file = fopen(cacheKey.c_str(), "rb");
+	if (file == NULL) {
+		std::cout << "WARNING: Image uri: " << cacheKey << " could not be resolved " << std::endl;
+		return;
+	}
+	fseek(file, 0, SEEK_END);
+	long int size = ftell(file);
+	rewind(file);
+	unsigned char* buffer = (unsigned char*)malloc(size);
+	size_t bytesRead = fread(buffer, sizeof(unsigned char), size, file);
+	fclose(file);
+	setData(buffer, bytesRead, _fileExtension);
+	_ownsData = true;
 }
 
+/**
+ * Gets the image for a file without reading it. The file is read the first time the image's
+ * data is needed, or ahead of time by `prefetch`.
+ *
+ * @param imagePath The path of the image file
+ * @return The image, which is shared by every load of the same path
+ */
 GLTF::Image* GLTF::Image::load(path imagePath) {
 	std::string fileString = imagePath.string();
+	std::lock_guard<std::mutex> lock(_imageCacheMutex);
 	std::map<std::string, GLTF::Image*>::iterator imageCacheIt = _imageCache.find(fileString);
 	if (imageCacheIt != _imageCache.end()) {
 		return imageCacheIt->second;
 	}
-	std::string fileExtension = imagePath.extension().string();
-	fileExtension.erase(0, 1);
-	GLTF::Image* image = NULL;
-	FILE* file = fopen(fileString.c_str(), "rb");
-	if (file == NULL) {
-		std::cout << "WARNING: Image uri: " << fileString << " could not be resolved " << std::endl;
-		image = new GLTF::Image(imagePath.filename().string(), fileString);
+	GLTF::Image* image = new GLTF::Image(imagePath.filename().string(), fileString);
+	image->_fileExtension = imagePath.extension().string();
+	image->_fileExtension.erase(0, 1);
+	_imageCache[fileString] = image;
+	return image;
+}
+
+/**
+ * Starts reading the file behind this image if it hasn't been read yet.
+ *
+ * @param threadPool The pool that reads the file, or `NULL` to read it on the calling thread
+ */
+void GLTF::Image::prefetch(GLTF::ThreadPool* threadPool) {
+	std::lock_guard<std::mutex> lock(_loadingMutex);
+	if (_loading.valid() || cacheKey.empty()) {
+		return;
+	}
+	if (threadPool != NULL) {
+		_loading = threadPool->enqueue([this]() {
+			read();
+		}).share();
 	}
 	else {
-		fseek(file, 0, SEEK_END);
-		long int size = ftell(file);
-		fclose(file);
-		file = fopen(fileString.c_str(), "rb");
-		unsigned char* buffer = (unsigned char*)malloc(size);
-		int bytesRead = fread(buffer, sizeof(unsigned char), size, file);
-		fclose(file);
-		image = new GLTF::Image(imagePath.filename().string(), fileString, buffer, bytesRead, fileExtension);
+		std::packaged_task<void()> task([this]() {
+			read();
+		});
+		_loading = task.get_future().share();
+		task();
 	}
-	_imageCache[fileString] = image;
-	return image;
+}
+
+void GLTF::Image::ensureLoaded() {
+	prefetch(NULL);
+	if (_loading.valid()) {
+		_loading.wait();
+	}
+}
+
+unsigned char* GLTF::Image::getData() {
+	ensureLoaded();
+	return _data;
+}
+
+size_t GLTF::Image::getByteLength() {
+	ensureLoaded();
+	return _byteLength;
+}
+
+std::string GLTF::Image::getMimeType() {
+	ensureLoaded();
+	return _mimeType;
+}
+
+/**
+ * Reads the bytes of an image in chunks, from memory if they are loaded and from its file otherwise.
+ */
+class ImageBytes {
+public:
+	ImageBytes(const unsigned char* data, size_t byteLength, std::string fileString) : _data(data), _byteLength(byteLength) {
+		if (!fileString.empty()) {
+			_file = fopen(fileString.c_str(), "rb");
+		}
+	}
+
+	~ImageBytes() {
+		if (_file != NULL) {
+			fclose(_file);
+		}
+	}
+
+	bool isValid() {
+		return _file != NULL || _data != NULL;
+	}
+
+	size_t read(unsigned char* buffer, size_t length) {
+		if (_file != NULL) {
+			return fread(buffer, sizeof(unsigned char), length, _file);
+		}
+		size_t count = std::min(length, _byteLength - _offset);
+		if (count > 0) {
+			std::memcpy(buffer, _data + _offset, count);
+			_offset += count;
+		}
+		return count;
+	}
+
+private:
+	const unsigned char* _data;
+	size_t _byteLength;
+	size_t _offset = 0;
+	FILE* _file = NULL;
+};
+
+/**
+ * Copies a file without reading it into memory. On Linux the file is cloned where the filesystem
+ * supports reflinks, and otherwise copied in the kernel with `copy_file_range` or `sendfile`.
+ */
+bool copyFile(std::string source, std::string destination) {
+#ifdef __linux__
+	int in = open(source.c_str(), O_RDONLY);
+	if (in < 0) {
+		return false;
+	}
+	struct stat sourceStat;
+	if (fstat(in, &sourceStat) != 0) {
+		close(in);
+		return false;
+	}
+	int out = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (out < 0) {
+		close(in);
+		return false;
+	}
+	bool copied = false;
+#ifdef FICLONE
+	copied = ioctl(out, FICLONE, in) == 0;
+#endif
+	off_t remaining = sourceStat.st_size;
+	while (!copied && remaining > 0) {
+		ssize_t count = -1;
+#ifdef SYS_copy_file_range
+		count = syscall(SYS_copy_file_range, in, NULL, out, NULL, (size_t)remaining, 0);
+#endif
+		if (count < 0) {
+			// Older kernels can't copy across filesystems
+			count = sendfile(out, in, NULL, (size_t)remaining);
+		}
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			break;
+		}
+		remaining -= count;
+	}
+	copied = copied || remaining == 0;
+	close(in);
+	close(out);
+	if (copied) {
+		return true;
+	}
+#endif
+	std::error_code error;
+	return std::experimental::filesystem::copy_file(source, destination, std::experimental::filesystem::copy_options::overwrite_existing, error);
+}
+
+/**
+ * Whether the bytes of this image are in memory, or are being read into it.
+ */
+bool GLTF::Image::isInMemory() {
+	std::lock_guard<std::mutex> lock(_loadingMutex);
+	return cacheKey.empty() || _loading.valid();
+}
+
+/**
+ * Hashes the bytes of this image with 64-bit FNV-1a. Images that haven't been loaded are hashed
+ * straight from their file without being kept in memory.
+ */
+unsigned long long GLTF::Image::getContentHash() {
+	if (_hasContentHash) {
+		return _contentHash;
+	}
+	bool inMemory = isInMemory();
+	unsigned char* data = inMemory ? getData() : NULL;
+	ImageBytes bytes(data, inMemory ? _byteLength : 0, inMemory ? "" : cacheKey);
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned char* chunk = new unsigned char[IMAGE_CHUNK_LENGTH];
+	size_t count;
+	while ((count = bytes.read(chunk, IMAGE_CHUNK_LENGTH)) > 0) {
+		for (size_t i = 0; i < count; i++) {
+			hash ^= chunk[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+	delete[] chunk;
+	_contentHash = hash;
+	_hasContentHash = true;
+	return hash;
+}
+
+/**
+ * Compares the bytes of two images. Images whose file can't be read are never equal.
+ */
+bool GLTF::Image::contentEquals(GLTF::Image* other) {
+	if (other == this) {
+		return true;
+	}
+	bool inMemory = isInMemory();
+	bool otherInMemory = other->isInMemory();
+	unsigned char* data = inMemory ? getData() : NULL;
+	unsigned char* otherData = otherInMemory ? other->getData() : NULL;
+	ImageBytes bytes(data, inMemory ? _byteLength : 0, inMemory ? "" : cacheKey);
+	ImageBytes otherBytes(otherData, otherInMemory ? other->_byteLength : 0, otherInMemory ? "" : other->cacheKey);
+	if (!bytes.isValid() || !otherBytes.isValid()) {
+		return false;
+	}
+	unsigned char* chunk = new unsigned char[IMAGE_CHUNK_LENGTH];
+	unsigned char* otherChunk = new unsigned char[IMAGE_CHUNK_LENGTH];
+	bool equals = true;
+	while (equals) {
+		size_t count = bytes.read(chunk, IMAGE_CHUNK_LENGTH);
+		size_t otherCount = otherBytes.read(otherChunk, IMAGE_CHUNK_LENGTH);
+		equals = count == otherCount && std::memcmp(chunk, otherChunk, count) == 0;
+		if (count == 0) {
+			break;
+		}
+	}
+	delete[] chunk;
+	delete[] otherChunk;
+	return equals;
+}
+
+/**
+ * Writes the bytes of this image to a file. Images that haven't been loaded are copied from their
+ * source file without being read into memory.
+ *
+ * @param destination The path to write to
+ * @return `false` if the image could not be written
+ */
+bool GLTF::Image::write(path destination) {
+	if (!isInMemory()) {
+		std::error_code error;
+		if (std::experimental::filesystem::equivalent(path(cacheKey), destination, error)) {
+			// The image is already in place
+			return true;
+		}
+		return copyFile(cacheKey, destination.string());
+	}
+	unsigned char* data = getData();
+	if (data == NULL) {
+		return false;
+	}
+	FILE* file = fopen(destination.string().c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	size_t written = fwrite(data, sizeof(unsigned char), _byteLength, file);
+	fclose(file);
+	return written == _byteLength;
+}
+
+/**
+ * Replaces the bytes of this image with re-encoded data in the same format. The image takes
+ * ownership of the data, which must be allocated with malloc, and is written from memory from now on.
+ */
+void GLTF::Image::replaceData(unsigned char* data, size_t byteLength) {
+	ensureLoaded();
+	if (_ownsData) {
+		free(_data);
+	}
+	setData(data, byteLength, _fileExtension);
+	_ownsData = true;
+	_hasContentHash = false;
 }
 
 uint16_t endianSwap16(uint16_t x){
@@ -75,6 +363,10 @@ uint32_t endianSwap32(uint32_t x) {
  * Based on code from: https://github.com/image-size/image-size.
  */
 std::pair<int, int> GLTF::Image::getDimensions() {
+	ensureLoaded();
+	unsigned char* data = _data;
+	size_t byteLength = _byteLength;
+	std::string mimeType = _mimeType;
 	int width = -1;
 	int height = -1;
 	if (mimeType == "image/png") {
@@ -114,13 +406,13 @@ std::string GLTF::Image::typeName() {
 }
 
 void GLTF::Image::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
-	if (options->embeddedTextures && data != NULL) {
+	// Only embedded images need their data, so images written separately are never read here
+	if (options->embeddedTextures && getData() != NULL) {
 		if (!options->binary) {
 			jsonWriter->Key("uri");
-			std::string embeddedUri = "data:" + mimeType + ";base64," + Base64::encode(data, byteLength);
-			jsonWriter->String(embeddedUri.c_str());
+			jsonWriter->DataUri(_mimeType.c_str(), _data, _byteLength);
 		}
 		else {
 			if (options->version == "1.0") {
@@ -131,7 +423,7 @@ void GLTF::Image::writeJSON(void* writer, GLTF::Options* options) {
 				jsonWriter->Key("bufferView");
 				jsonWriter->String(bufferView->getStringId().c_str());
 				jsonWriter->Key("mimeType");
-				jsonWriter->String(mimeType.c_str());
+				jsonWriter->String(_mimeType.c_str());
 				jsonWriter->Key("width");
 				jsonWriter->Int(getDimensions().first);
 				jsonWriter->Key("height");
@@ -143,7 +435,7 @@ void GLTF::Image::writeJSON(void* writer, GLTF::Options* options) {
 				jsonWriter->Key("bufferView");
 				jsonWriter->Int(bufferView->id);
 				jsonWriter->Key("mimeType");
-				jsonWriter->String(mimeType.c_str());
+				jsonWriter->String(_mimeType.c_str());
 			}
 		}
 	}
@@ -0,0 +1,14 @@
+#include "GLTFInstancingExtension.h"
+
+#include "GLTFJSONWriter.h"
+
+void GLTF::InstancingExtension::writeJSON(void* writer, GLTF::Options* options) {
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
+	jsonWriter->Key("attributes");
+	jsonWriter->StartObject();
+	for (const auto& attribute : attributes) {
+		jsonWriter->Key(attribute.first.c_str());
+		jsonWriter->Int(attribute.second->id);
+	}
+	jsonWriter->EndObject();
+}
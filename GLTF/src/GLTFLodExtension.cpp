@@ -0,0 +1,22 @@
+#include "GLTFLodExtension.h"
+
+#include "GLTFJSONWriter.h"
+
+void GLTF::LodExtension::ScreenCoverage::writeJSONValue(void* writer, GLTF::Options* options) {
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
+	jsonWriter->StartArray();
+	for (float value : coverage) {
+		jsonWriter->Double(value);
+	}
+	jsonWriter->EndArray();
+}
+
+void GLTF::LodExtension::writeJSON(void* writer, GLTF::Options* options) {
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
+	jsonWriter->Key("ids");
+	jsonWriter->StartArray();
+	for (GLTF::Node* node : nodes) {
+		jsonWriter->Int(node->id);
+	}
+	jsonWriter->EndArray();
+}
@@ -1,8 +1,9 @@
 #include "GLTFMaterial.h"
 #include "GLTFNode.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
+
+#include <algorithm>
 
 GLTF::Material::Material() {
 	this->values = new GLTF::Material::Values();
@@ -13,12 +14,46 @@ bool GLTF::Material::hasTexture() {
 	return this->values->diffuseTexture != NULL;
 }
 
+/**
+ * Compares two optional arrays of material factors by value.
+ */
+static bool factorsEqual(const float* a, const float* b, int count) {
+	if (a == NULL || b == NULL) {
+		return a == b;
+	}
+	return std::equal(a, a + count, b);
+}
+
+bool GLTF::Material::Values::equals(GLTF::Material::Values* values) {
+	return factorsEqual(ambient, values->ambient, 4) && ambientTexture == values->ambientTexture &&
+		factorsEqual(diffuse, values->diffuse, 4) && diffuseTexture == values->diffuseTexture &&
+		factorsEqual(emission, values->emission, 4) && emissionTexture == values->emissionTexture &&
+		factorsEqual(specular, values->specular, 4) && specularTexture == values->specularTexture &&
+		factorsEqual(shininess, values->shininess, 1) && factorsEqual(transparency, values->transparency, 1) &&
+		bumpTexture == values->bumpTexture;
+}
+
+bool GLTF::Material::equals(GLTF::Material* material) {
+	if (material == this) {
+		return true;
+	}
+	// Extensions and extras can't be compared, so materials that have them are only equal to themselves
+	if (type != material->type || technique != material->technique || doubleSided != material->doubleSided ||
+		extensions.size() > 0 || extras.size() > 0 || material->extensions.size() > 0 || material->extras.size() > 0) {
+		return false;
+	}
+	if (values == NULL || material->values == NULL) {
+		return values == material->values;
+	}
+	return values->equals(material->values);
+}
+
 std::string GLTF::Material::typeName() {
 	return "material";
 }
 
 void GLTF::Material::Values::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (ambient != NULL || ambientTexture != NULL) {
 		jsonWriter->Key("ambient");
 		if (ambientTexture != NULL && options->version == "1.0") {
@@ -119,7 +154,7 @@ void GLTF::Material::Values::writeJSON(void* writer, GLTF::Options* options) {
 }
 
 void GLTF::Material::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (this->values) {
 		jsonWriter->Key("values");
 		jsonWriter->StartObject();
@@ -138,8 +173,22 @@ void GLTF::Material::writeJSON(void* writer, GLTF::Options* options) {
 	GLTF::Object::writeJSON(writer, options);
 }
 
+bool GLTF::MaterialPBR::Texture::equals(GLTF::MaterialPBR::Texture* texture) {
+	return this->texture == texture->texture && scale == texture->scale && texCoord == texture->texCoord;
+}
+
+/**
+ * Compares two optional PBR texture references by value.
+ */
+static bool texturesEqual(GLTF::MaterialPBR::Texture* a, GLTF::MaterialPBR::Texture* b) {
+	if (a == NULL || b == NULL) {
+		return a == b;
+	}
+	return a->equals(b);
+}
+
 void GLTF::MaterialPBR::Texture::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = static_cast<rapidjson::Writer<rapidjson::StringBuffer>*>(writer);
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (scale != 1) {
 		jsonWriter->Key("scale");
 		jsonWriter->Double(scale);
@@ -156,7 +205,7 @@ void GLTF::MaterialPBR::Texture::writeJSON(void* writer, GLTF::Options* options)
 }
 
 void GLTF::MaterialPBR::MetallicRoughness::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (baseColorFactor) {
 		jsonWriter->Key("baseColorFactor");
 		jsonWriter->StartArray();
@@ -189,7 +238,7 @@ void GLTF::MaterialPBR::MetallicRoughness::writeJSON(void* writer, GLTF::Options
 }
 
 void GLTF::MaterialPBR::SpecularGlossiness::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (diffuseFactor) {
 		jsonWriter->Key("diffuseFactor");
 		jsonWriter->StartArray();
@@ -226,7 +275,7 @@ void GLTF::MaterialPBR::SpecularGlossiness::writeJSON(void* writer, GLTF::Option
 }
 
 void GLTF::MaterialPBR::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (metallicRoughness) {
 		jsonWriter->Key("pbrMetallicRoughness");
 		jsonWriter->StartObject();
@@ -292,7 +341,7 @@ std::string GLTF::MaterialCommon::Light::typeName() {
 }
 
 void GLTF::MaterialCommon::Light::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (type != MaterialCommon::Light::UNKOWN) {
 		switch (type) {
 		case MaterialCommon::Light::DIRECTIONAL:
@@ -336,6 +385,14 @@ GLTF::MaterialCommon::MaterialCommon() {
 	this->type = GLTF::Material::MATERIAL_COMMON;
 }
 
+bool GLTF::MaterialCommon::equals(GLTF::Material* material) {
+	if (!GLTF::Material::equals(material)) {
+		return false;
+	}
+	GLTF::MaterialCommon* other = (GLTF::MaterialCommon*)material;
+	return technique == other->technique && jointCount == other->jointCount && transparent == other->transparent;
+}
+
 const char* GLTF::MaterialCommon::getTechniqueName() {
 	switch (this->technique) {
 	case BLINN:
@@ -856,6 +913,42 @@ GLTF::MaterialPBR::MaterialPBR() {
 	this->specularGlossiness = new GLTF::MaterialPBR::SpecularGlossiness();
 }
 
+bool GLTF::MaterialPBR::equals(GLTF::Material* material) {
+	if (!GLTF::Material::equals(material)) {
+		return false;
+	}
+	if (material == this) {
+		return true;
+	}
+	GLTF::MaterialPBR* other = (GLTF::MaterialPBR*)material;
+	if (doubleSided != other->doubleSided || alphaMode != other->alphaMode ||
+		!(alphaCutoff == other->alphaCutoff || (std::isnan(alphaCutoff) && std::isnan(other->alphaCutoff))) ||
+		!texturesEqual(normalTexture, other->normalTexture) || !texturesEqual(occlusionTexture, other->occlusionTexture) ||
+		!factorsEqual(emissiveFactor, other->emissiveFactor, 3) || !texturesEqual(emissiveTexture, other->emissiveTexture)) {
+		return false;
+	}
+	if (metallicRoughness == NULL || other->metallicRoughness == NULL) {
+		if (metallicRoughness != other->metallicRoughness) {
+			return false;
+		}
+	}
+	else if (!factorsEqual(metallicRoughness->baseColorFactor, other->metallicRoughness->baseColorFactor, 4) ||
+		!texturesEqual(metallicRoughness->baseColorTexture, other->metallicRoughness->baseColorTexture) ||
+		metallicRoughness->metallicFactor != other->metallicRoughness->metallicFactor ||
+		metallicRoughness->roughnessFactor != other->metallicRoughness->roughnessFactor ||
+		!texturesEqual(metallicRoughness->metallicRoughnessTexture, other->metallicRoughness->metallicRoughnessTexture)) {
+		return false;
+	}
+	if (specularGlossiness == NULL || other->specularGlossiness == NULL) {
+		return specularGlossiness == other->specularGlossiness;
+	}
+	return factorsEqual(specularGlossiness->diffuseFactor, other->specularGlossiness->diffuseFactor, 4) &&
+		texturesEqual(specularGlossiness->diffuseTexture, other->specularGlossiness->diffuseTexture) &&
+		factorsEqual(specularGlossiness->specularFactor, other->specularGlossiness->specularFactor, 3) &&
+		texturesEqual(specularGlossiness->specularGlossinessTexture, other->specularGlossiness->specularGlossinessTexture) &&
+		factorsEqual(specularGlossiness->glossinessFactor, other->specularGlossiness->glossinessFactor, 1);
+}
+
 GLTF::MaterialPBR* GLTF::MaterialCommon::getMaterialPBR(GLTF::Options* options) {
 	GLTF::MaterialPBR* material = new GLTF::MaterialPBR();
 	material->metallicRoughness->metallicFactor = 0;
@@ -923,7 +1016,7 @@ GLTF::MaterialPBR* GLTF::MaterialCommon::getMaterialPBR(GLTF::Options* options)
 }
 
 void GLTF::MaterialCommon::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("extensions");
 	jsonWriter->StartObject();
 	jsonWriter->Key("KHR_materials_common");
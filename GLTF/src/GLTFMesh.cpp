@@ -1,7 +1,6 @@
 #include "GLTFMesh.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Mesh::typeName() {
 	return "mesh";
@@ -24,7 +23,7 @@ GLTF::Object* GLTF::Mesh::clone(GLTF::Object* clone) {
 }
 
 void GLTF::Mesh::writeJSON(void* writer, GLTF::Options* options) {
-	auto* jsonWriter = static_cast<rapidjson::Writer<rapidjson::StringBuffer>*>(writer);
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("primitives");
 	jsonWriter->StartArray();
 	for (GLTF::Primitive* primitive : this->primitives) {
@@ -2,8 +2,7 @@
 
 #include <cmath>
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 GLTF::Node::TransformMatrix::TransformMatrix() {
 	this->type = GLTF::Node::Transform::MATRIX;
@@ -246,7 +245,7 @@ GLTF::Object* GLTF::Node::clone(GLTF::Object* clone) {
 }
 
 void GLTF::Node::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	
 	if (mesh != NULL) {
 		if (options->version == "1.0") {
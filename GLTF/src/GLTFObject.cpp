@@ -1,8 +1,7 @@
 #include "GLTFObject.h"
 #include "GLTFExtension.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Object::getStringId() {
 	if (stringId == "") {
@@ -28,7 +27,7 @@ GLTF::Object* GLTF::Object::clone(GLTF::Object* clone) {
 }
 
 void GLTF::Object::writeJSON(void* writer, GLTF::Options* options) {
-  rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+  GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
   if (this->name.length() > 0) {
     jsonWriter->Key("name");
     jsonWriter->String(this->name.c_str());
@@ -49,10 +48,15 @@ void GLTF::Object::writeJSON(void* writer, GLTF::Options* options) {
     jsonWriter->StartObject();
     for (const auto extra : this->extras) {
       jsonWriter->Key(extra.first.c_str());
-      jsonWriter->StartObject();
-      extra.second->writeJSON(writer, options);
-      jsonWriter->EndObject();
+      extra.second->writeJSONValue(writer, options);
     }
     jsonWriter->EndObject();
   }
 }
+
+void GLTF::Object::writeJSONValue(void* writer, GLTF::Options* options) {
+  GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
+  jsonWriter->StartObject();
+  this->writeJSON(writer, options);
+  jsonWriter->EndObject();
+}
@@ -1,7 +1,6 @@
 #include "GLTFPrimitive.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 GLTF::Object* GLTF::Primitive::clone(GLTF::Object* clone) {
 	GLTF::Primitive* primitive = dynamic_cast<GLTF::Primitive*>(clone);
@@ -23,7 +22,7 @@ GLTF::Object* GLTF::Primitive::clone(GLTF::Object* clone) {
 }
 
 void GLTF::Primitive::writeJSON(void* writer, Options* options) {
-	auto* jsonWriter = static_cast<rapidjson::Writer<rapidjson::StringBuffer>*>(writer);
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("attributes");
 	jsonWriter->StartObject();
 	for (const auto& attribute : this->attributes) {
@@ -79,7 +78,7 @@ GLTF::Primitive::Target* GLTF::Primitive::Target::clone(Object* clone) {
 }
 
 void GLTF::Primitive::Target::writeJSON(void* writer, Options* options) {
-	auto* jsonWriter = static_cast<rapidjson::Writer<rapidjson::StringBuffer>*>(writer);
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->StartObject();
 	for (const auto& attribute : this->attributes) {
 		jsonWriter->Key(attribute.first.c_str());
@@ -1,14 +1,13 @@
 #include "GLTFProgram.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Program::typeName() {
 	return "program";
 }
 
 void GLTF::Program::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	jsonWriter->Key("attributes");
 	jsonWriter->StartArray();
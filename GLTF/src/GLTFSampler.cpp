@@ -1,14 +1,13 @@
 #include "GLTFSampler.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Sampler::typeName() {
 	return "sampler";
 }
 
 void GLTF::Sampler::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("magFilter");
 	jsonWriter->Int((int)magFilter);
 	jsonWriter->Key("minFilter");
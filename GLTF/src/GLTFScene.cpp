@@ -1,14 +1,13 @@
 #include "GLTFScene.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Scene::typeName() {
 	return "scene";
 }
 
 void GLTF::Scene::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	jsonWriter->Key("nodes");
 	jsonWriter->StartArray();
 	for (GLTF::Node* node : this->nodes) {
@@ -0,0 +1,82 @@
+#include "GLTFSegmentWriter.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static const char SPACE_PADDING[] = "   ";
+static const char ZERO_PADDING[] = { 0, 0, 0 };
+
+void GLTF::SegmentWriter::append(const void* data, size_t length) {
+	if (length == 0) {
+		return;
+	}
+	_segments.push_back(std::make_pair(data, length));
+	_length += length;
+}
+
+void GLTF::SegmentWriter::append(GLTF::SegmentWriter* segments) {
+	_segments.insert(_segments.end(), segments->_segments.begin(), segments->_segments.end());
+	_length += segments->_length;
+}
+
+void GLTF::SegmentWriter::appendPadding(size_t length, char value) {
+	append(value == ' ' ? SPACE_PADDING : ZERO_PADDING, length);
+}
+
+size_t GLTF::SegmentWriter::length() {
+	return _length;
+}
+
+bool GLTF::SegmentWriter::write(FILE* file) {
+#ifdef _WIN32
+	for (const std::pair<const void*, size_t>& segment : _segments) {
+		if (fwrite(segment.first, sizeof(unsigned char), segment.second, file) != segment.second) {
+			return false;
+		}
+	}
+	return true;
+#else
+	// Anything already buffered by stdio has to reach the file before writing to its descriptor
+	if (fflush(file) != 0) {
+		return false;
+	}
+	int fd = fileno(file);
+	std::vector<struct iovec> iov(_segments.size());
+	for (size_t i = 0; i < _segments.size(); i++) {
+		iov[i].iov_base = const_cast<void*>(_segments[i].first);
+		iov[i].iov_len = _segments[i].second;
+	}
+	size_t index = 0;
+	while (index < iov.size()) {
+		int count = (int)std::min(iov.size() - index, (size_t)IOV_MAX);
+		ssize_t written = writev(fd, &iov[index], count);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		// Skip past whatever was written, which may end partway through a segment
+		size_t remaining = (size_t)written;
+		while (index < iov.size() && remaining >= iov[index].iov_len) {
+			remaining -= iov[index].iov_len;
+			index++;
+		}
+		if (remaining > 0) {
+			iov[index].iov_base = (unsigned char*)iov[index].iov_base + remaining;
+			iov[index].iov_len -= remaining;
+		}
+	}
+	return true;
+#endif
+}
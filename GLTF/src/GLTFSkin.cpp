@@ -1,15 +1,14 @@
 #include "GLTFSkin.h"
 #include "GLTFNode.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Skin::typeName() {
 	return "skin";
 }
 
 void GLTF::Skin::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 
 	if (inverseBindMatrices != NULL) {
 		jsonWriter->Key("inverseBindMatrices");
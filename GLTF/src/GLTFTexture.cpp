@@ -1,14 +1,13 @@
 #include "GLTFTexture.h"
 
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/writer.h"
+#include "GLTFJSONWriter.h"
 
 std::string GLTF::Texture::typeName() {
 	return "texture";
 }
 
 void GLTF::Texture::writeJSON(void* writer, GLTF::Options* options) {
-	rapidjson::Writer<rapidjson::StringBuffer>* jsonWriter = (rapidjson::Writer<rapidjson::StringBuffer>*)writer;
+	GLTF::JSONWriter* jsonWriter = (GLTF::JSONWriter*)writer;
 	if (options->version == "1.0") {
 		jsonWriter->Key("format");
 		jsonWriter->Int((int)GLTF::Constants::WebGL::RGBA);
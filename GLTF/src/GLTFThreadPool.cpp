@@ -0,0 +1,40 @@
+#include "GLTFThreadPool.h"
+
+GLTF::ThreadPool::ThreadPool(int threadCount) {
+	for (int i = 0; i < threadCount; i++) {
+		_workers.push_back(std::thread(&GLTF::ThreadPool::work, this));
+	}
+}
+
+GLTF::ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+int GLTF::ThreadPool::size() {
+	return _workers.size();
+}
+
+void GLTF::ThreadPool::work() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() {
+				return _stopping || !_tasks.empty();
+			});
+			if (_tasks.empty()) {
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
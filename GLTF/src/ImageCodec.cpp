@@ -0,0 +1,1488 @@
+#include "ImageCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// The coefficient at each position of the zig-zag order of an 8x8 block
+const int ZIGZAG[64] = {
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Images larger than this are rejected rather than risking an allocation that can't succeed
+const uint64_t MAX_PIXEL_COUNT = 1ULL << 30;
+
+static uint32_t readUint32BE(const unsigned char* data) {
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint16_t readUint16BE(const unsigned char* data) {
+	return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static void writeUint32BE(std::vector<unsigned char>* out, uint32_t value) {
+	out->push_back((unsigned char)(value >> 24));
+	out->push_back((unsigned char)(value >> 16));
+	out->push_back((unsigned char)(value >> 8));
+	out->push_back((unsigned char)value);
+}
+
+static void writeUint16BE(std::vector<unsigned char>* out, uint16_t value) {
+	out->push_back((unsigned char)(value >> 8));
+	out->push_back((unsigned char)value);
+}
+
+/**
+ * Reads a deflate stream least significant bit first. Reading past the end yields zero bits and
+ * marks the reader as overflowed.
+ */
+class InflateBitReader {
+public:
+	InflateBitReader(const unsigned char* data, size_t length) : _data(data), _length(length) {}
+
+	bool overflowed = false;
+
+	uint32_t peek(int count) {
+		while (_bitCount < count) {
+			if (_position < _length) {
+				_bitBuffer |= (uint64_t)_data[_position++] << _bitCount;
+			}
+			else {
+				_missingBits += 8;
+			}
+			_bitCount += 8;
+		}
+		return (uint32_t)(_bitBuffer & ((1ULL << count) - 1));
+	}
+
+	void consume(int count) {
+		_bitBuffer >>= count;
+		_bitCount -= count;
+		if (_bitCount < _missingBits) {
+			overflowed = true;
+		}
+	}
+
+	uint32_t bits(int count) {
+		if (count == 0) {
+			return 0;
+		}
+		uint32_t value = peek(count);
+		consume(count);
+		return value;
+	}
+
+	void alignToByte() {
+		consume(_bitCount & 7);
+	}
+
+private:
+	const unsigned char* _data;
+	size_t _length;
+	size_t _position = 0;
+	uint64_t _bitBuffer = 0;
+	int _bitCount = 0;
+	int _missingBits = 0;
+};
+
+/**
+ * A canonical Huffman code decoded with a single lookup table indexed by the next bits of the
+ * stream, least significant bit first.
+ */
+class InflateHuffman {
+public:
+	int maxLength = 0;
+	// Each entry holds the symbol in the low 16 bits and the code length above them, or 0 for an invalid code
+	std::vector<uint32_t> table;
+
+	bool build(const unsigned char* lengths, int count) {
+		int lengthCounts[16] = { 0 };
+		maxLength = 0;
+		for (int i = 0; i < count; i++) {
+			lengthCounts[lengths[i]]++;
+			maxLength = std::max(maxLength, (int)lengths[i]);
+		}
+		lengthCounts[0] = 0;
+		if (maxLength == 0) {
+			table.assign(1, 0);
+			return true;
+		}
+		int nextCode[16] = { 0 };
+		int code = 0;
+		int available = 1;
+		for (int length = 1; length <= 15; length++) {
+			code = (code + lengthCounts[length - 1]) << 1;
+			nextCode[length] = code;
+			available = (available << 1) - lengthCounts[length];
+			if (available < 0) {
+				// Over-subscribed
+				return false;
+			}
+		}
+		table.assign((size_t)1 << maxLength, 0);
+		for (int symbol = 0; symbol < count; symbol++) {
+			int length = lengths[symbol];
+			if (length == 0) {
+				continue;
+			}
+			int symbolCode = nextCode[length]++;
+			int reversed = 0;
+			for (int i = 0; i < length; i++) {
+				reversed |= ((symbolCode >> i) & 1) << (length - 1 - i);
+			}
+			uint32_t entry = ((uint32_t)length << 16) | (uint32_t)symbol;
+			for (int fill = reversed; fill < (1 << maxLength); fill += 1 << length) {
+				table[fill] = entry;
+			}
+		}
+		return true;
+	}
+
+	int decode(InflateBitReader* reader) const {
+		uint32_t entry = table[reader->peek(maxLength)];
+		if (entry == 0) {
+			return -1;
+		}
+		reader->consume(entry >> 16);
+		return entry & 0xFFFF;
+	}
+};
+
+/**
+ * Decompresses a raw deflate stream.
+ */
+static bool inflate(const unsigned char* data, size_t length, std::vector<unsigned char>* out) {
+	InflateBitReader reader(data, length);
+	InflateHuffman literals;
+	InflateHuffman distances;
+	bool final = false;
+	while (!final) {
+		final = reader.bits(1) == 1;
+		int type = reader.bits(2);
+		if (type == 0) {
+			reader.alignToByte();
+			uint32_t storedLength = reader.bits(16);
+			uint32_t storedLengthComplement = reader.bits(16);
+			if ((storedLength ^ 0xFFFF) != storedLengthComplement) {
+				return false;
+			}
+			for (uint32_t i = 0; i < storedLength; i++) {
+				out->push_back((unsigned char)reader.bits(8));
+			}
+		}
+		else if (type == 1 || type == 2) {
+			unsigned char lengths[320];
+			int literalCount = 288;
+			int distanceCount = 30;
+			if (type == 1) {
+				for (int i = 0; i < 288; i++) {
+					lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+				}
+				for (int i = 0; i < 30; i++) {
+					lengths[288 + i] = 5;
+				}
+			}
+			else {
+				literalCount = reader.bits(5) + 257;
+				distanceCount = reader.bits(5) + 1;
+				int codeLengthCount = reader.bits(4) + 4;
+				static const int CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+				unsigned char codeLengthLengths[19] = { 0 };
+				for (int i = 0; i < codeLengthCount; i++) {
+					codeLengthLengths[CODE_LENGTH_ORDER[i]] = (unsigned char)reader.bits(3);
+				}
+				InflateHuffman codeLengths;
+				if (!codeLengths.build(codeLengthLengths, 19)) {
+					return false;
+				}
+				int index = 0;
+				while (index < literalCount + distanceCount) {
+					int symbol = codeLengths.decode(&reader);
+					if (symbol < 0) {
+						return false;
+					}
+					if (symbol < 16) {
+						lengths[index++] = (unsigned char)symbol;
+						continue;
+					}
+					int repeat;
+					unsigned char value = 0;
+					if (symbol == 16) {
+						if (index == 0) {
+							return false;
+						}
+						value = lengths[index - 1];
+						repeat = 3 + reader.bits(2);
+					}
+					else if (symbol == 17) {
+						repeat = 3 + reader.bits(3);
+					}
+					else {
+						repeat = 11 + reader.bits(7);
+					}
+					if (index + repeat > literalCount + distanceCount) {
+						return false;
+					}
+					while (repeat-- > 0) {
+						lengths[index++] = value;
+					}
+				}
+			}
+			if (!literals.build(lengths, literalCount) || !distances.build(lengths + literalCount, distanceCount)) {
+				return false;
+			}
+			while (true) {
+				int symbol = literals.decode(&reader);
+				if (symbol < 0 || reader.overflowed) {
+					return false;
+				}
+				if (symbol < 256) {
+					out->push_back((unsigned char)symbol);
+					continue;
+				}
+				if (symbol == 256) {
+					break;
+				}
+				symbol -= 257;
+				if (symbol >= 29) {
+					return false;
+				}
+				size_t matchLength = LENGTH_BASE[symbol] + reader.bits(LENGTH_EXTRA[symbol]);
+				int distanceSymbol = distances.decode(&reader);
+				if (distanceSymbol < 0 || distanceSymbol >= 30) {
+					return false;
+				}
+				size_t distance = DISTANCE_BASE[distanceSymbol] + reader.bits(DISTANCE_EXTRA[distanceSymbol]);
+				if (distance > out->size()) {
+					return false;
+				}
+				size_t start = out->size() - distance;
+				for (size_t i = 0; i < matchLength; i++) {
+					out->push_back((*out)[start + i]);
+				}
+			}
+		}
+		else {
+			return false;
+		}
+		if (reader.overflowed) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Writes a deflate stream least significant bit first.
+ */
+class DeflateBitWriter {
+public:
+	std::vector<unsigned char>* out;
+
+	DeflateBitWriter(std::vector<unsigned char>* out) : out(out) {}
+
+	void bits(uint32_t value, int count) {
+		_bitBuffer |= (uint64_t)value << _bitCount;
+		_bitCount += count;
+		while (_bitCount >= 8) {
+			out->push_back((unsigned char)_bitBuffer);
+			_bitBuffer >>= 8;
+			_bitCount -= 8;
+		}
+	}
+
+	// Huffman codes are packed starting from their most significant bit
+	void code(uint32_t code, int length) {
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++) {
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+		}
+		bits(reversed, length);
+	}
+
+	void flush() {
+		if (_bitCount > 0) {
+			out->push_back((unsigned char)_bitBuffer);
+		}
+		_bitBuffer = 0;
+		_bitCount = 0;
+	}
+
+private:
+	uint64_t _bitBuffer = 0;
+	int _bitCount = 0;
+};
+
+static void writeFixedLiteral(DeflateBitWriter* writer, int symbol) {
+	if (symbol < 144) {
+		writer->code(0x30 + symbol, 8);
+	}
+	else if (symbol < 256) {
+		writer->code(0x190 + symbol - 144, 9);
+	}
+	else if (symbol < 280) {
+		writer->code(symbol - 256, 7);
+	}
+	else {
+		writer->code(0xC0 + symbol - 280, 8);
+	}
+}
+
+/**
+ * Compresses data into a single deflate block with the fixed Huffman codes, finding matches with
+ * hash chains over a 32 KB window.
+ */
+static void deflate(const unsigned char* data, size_t length, std::vector<unsigned char>* out) {
+	const int HASH_BITS = 15;
+	const size_t WINDOW_SIZE = 32768;
+	const int MAX_CHAIN = 64;
+	std::vector<int64_t> head((size_t)1 << HASH_BITS, -1);
+	std::vector<int64_t> previous(WINDOW_SIZE, -1);
+	auto hash = [data](size_t position) {
+		uint32_t value = ((uint32_t)data[position] << 16) | ((uint32_t)data[position + 1] << 8) | data[position + 2];
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	};
+
+	DeflateBitWriter writer(out);
+	writer.bits(1, 1);
+	writer.bits(1, 2);
+	size_t position = 0;
+	while (position < length) {
+		size_t bestLength = 0;
+		size_t bestDistance = 0;
+		if (position + 3 <= length) {
+			uint32_t positionHash = hash(position);
+			int64_t candidate = head[positionHash];
+			size_t maxLength = std::min((size_t)258, length - position);
+			for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 && position - (size_t)candidate <= WINDOW_SIZE; chain++) {
+				const unsigned char* a = data + candidate;
+				const unsigned char* b = data + position;
+				if (a[bestLength] == b[bestLength]) {
+					size_t matchLength = 0;
+					while (matchLength < maxLength && a[matchLength] == b[matchLength]) {
+						matchLength++;
+					}
+					if (matchLength > bestLength) {
+						bestLength = matchLength;
+						bestDistance = position - (size_t)candidate;
+						if (matchLength == maxLength) {
+							break;
+						}
+					}
+				}
+				int64_t next = previous[(size_t)candidate & (WINDOW_SIZE - 1)];
+				if (next >= candidate) {
+					break;
+				}
+				candidate = next;
+			}
+		}
+		size_t advance = bestLength >= 3 ? bestLength : 1;
+		if (bestLength >= 3) {
+			int lengthSymbol = 28;
+			while (LENGTH_BASE[lengthSymbol] > (int)bestLength) {
+				lengthSymbol--;
+			}
+			writeFixedLiteral(&writer, 257 + lengthSymbol);
+			writer.bits((uint32_t)(bestLength - LENGTH_BASE[lengthSymbol]), LENGTH_EXTRA[lengthSymbol]);
+			int distanceSymbol = 29;
+			while (DISTANCE_BASE[distanceSymbol] > (int)bestDistance) {
+				distanceSymbol--;
+			}
+			writer.code(distanceSymbol, 5);
+			writer.bits((uint32_t)(bestDistance - DISTANCE_BASE[distanceSymbol]), DISTANCE_EXTRA[distanceSymbol]);
+		}
+		else {
+			writeFixedLiteral(&writer, data[position]);
+		}
+		for (size_t i = 0; i < advance; i++, position++) {
+			if (position + 3 <= length) {
+				uint32_t positionHash = hash(position);
+				previous[position & (WINDOW_SIZE - 1)] = head[positionHash];
+				head[positionHash] = (int64_t)position;
+			}
+		}
+	}
+	writeFixedLiteral(&writer, 256);
+	writer.flush();
+}
+
+static uint32_t adler32(const unsigned char* data, size_t length) {
+	uint32_t a = 1;
+	uint32_t b = 0;
+	while (length > 0) {
+		size_t block = std::min(length, (size_t)5552);
+		length -= block;
+		while (block-- > 0) {
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+// Function local statics of these are initialized once even when images are coded on several threads
+struct CRCTable {
+	uint32_t values[256];
+
+	CRCTable() {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t value = i;
+			for (int j = 0; j < 8; j++) {
+				value = value & 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+			}
+			values[i] = value;
+		}
+	}
+};
+
+static uint32_t crc32(const unsigned char* data, size_t length, uint32_t crc = 0) {
+	static const CRCTable table;
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++) {
+		crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static unsigned char paeth(int a, int b, int c) {
+	int p = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) {
+		return (unsigned char)a;
+	}
+	return (unsigned char)(pb <= pc ? b : c);
+}
+
+bool ImageCodec::decodePNG(const unsigned char* data, size_t length, ImageCodec::Pixels* pixels) {
+	static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if (length < 8 || std::memcmp(data, SIGNATURE, 8) != 0) {
+		return false;
+	}
+	uint32_t width = 0;
+	uint32_t height = 0;
+	int bitDepth = 0;
+	int colorType = -1;
+	int interlace = 0;
+	unsigned char palette[256][4];
+	int paletteSize = 0;
+	bool hasColorKey = false;
+	uint16_t colorKey[3] = { 0, 0, 0 };
+	std::vector<unsigned char> compressed;
+	size_t offset = 8;
+	while (offset + 12 <= length) {
+		uint32_t chunkLength = readUint32BE(data + offset);
+		const unsigned char* type = data + offset + 4;
+		const unsigned char* chunk = data + offset + 8;
+		if (chunkLength > length - offset - 12) {
+			return false;
+		}
+		if (std::memcmp(type, "IHDR", 4) == 0 && chunkLength >= 13) {
+			width = readUint32BE(chunk);
+			height = readUint32BE(chunk + 4);
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			interlace = chunk[12];
+			for (int i = 0; i < 256; i++) {
+				palette[i][0] = palette[i][1] = palette[i][2] = 0;
+				palette[i][3] = 255;
+			}
+		}
+		else if (std::memcmp(type, "PLTE", 4) == 0) {
+			paletteSize = std::min(256, (int)chunkLength / 3);
+			for (int i = 0; i < paletteSize; i++) {
+				palette[i][0] = chunk[i * 3];
+				palette[i][1] = chunk[i * 3 + 1];
+				palette[i][2] = chunk[i * 3 + 2];
+			}
+		}
+		else if (std::memcmp(type, "tRNS", 4) == 0) {
+			if (colorType == 3) {
+				for (uint32_t i = 0; i < chunkLength && i < 256; i++) {
+					palette[i][3] = chunk[i];
+				}
+			}
+			else if (colorType == 0 && chunkLength >= 2) {
+				hasColorKey = true;
+				colorKey[0] = readUint16BE(chunk);
+			}
+			else if (colorType == 2 && chunkLength >= 6) {
+				hasColorKey = true;
+				for (int i = 0; i < 3; i++) {
+					colorKey[i] = readUint16BE(chunk + i * 2);
+				}
+			}
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0) {
+			compressed.insert(compressed.end(), chunk, chunk + chunkLength);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0) {
+			break;
+		}
+		offset += 12 + chunkLength;
+	}
+
+	int channels;
+	switch (colorType) {
+	case 0:
+		channels = 1;
+		break;
+	case 2:
+		channels = 3;
+		break;
+	case 3:
+		channels = 1;
+		break;
+	case 4:
+		channels = 2;
+		break;
+	case 6:
+		channels = 4;
+		break;
+	default:
+		return false;
+	}
+	bool validDepth = bitDepth == 8 || bitDepth == 16 || ((colorType == 0 || colorType == 3) && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4));
+	if (!validDepth || (colorType == 3 && bitDepth == 16) || interlace > 1 || width == 0 || height == 0 || (uint64_t)width * height > MAX_PIXEL_COUNT) {
+		return false;
+	}
+	if (compressed.size() < 2 || (compressed[0] & 0x0F) != 8 || (compressed[1] & 0x20) != 0) {
+		return false;
+	}
+	std::vector<unsigned char> raw;
+	if (!inflate(compressed.data() + 2, compressed.size() - 2, &raw)) {
+		return false;
+	}
+
+	pixels->width = (int)width;
+	pixels->height = (int)height;
+	pixels->rgba.assign((size_t)width * height * 4, 0);
+	static const int PASS_X[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	static const int PASS_Y[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	static const int PASS_DX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	static const int PASS_DY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+	int passCount = interlace == 1 ? 7 : 1;
+	size_t bitsPerPixel = (size_t)channels * bitDepth;
+	size_t bytesPerPixel = std::max((size_t)1, bitsPerPixel / 8);
+	int maxSample = (1 << bitDepth) - 1;
+	size_t rawOffset = 0;
+	for (int pass = 0; pass < passCount; pass++) {
+		size_t startX = interlace == 1 ? PASS_X[pass] : 0;
+		size_t startY = interlace == 1 ? PASS_Y[pass] : 0;
+		size_t stepX = interlace == 1 ? PASS_DX[pass] : 1;
+		size_t stepY = interlace == 1 ? PASS_DY[pass] : 1;
+		if (startX >= width || startY >= height) {
+			continue;
+		}
+		size_t passWidth = (width - startX + stepX - 1) / stepX;
+		size_t passHeight = (height - startY + stepY - 1) / stepY;
+		size_t rowBytes = (passWidth * bitsPerPixel + 7) / 8;
+		if (raw.size() - rawOffset < passHeight * (rowBytes + 1)) {
+			return false;
+		}
+		std::vector<unsigned char> previousRow(rowBytes, 0);
+		for (size_t y = 0; y < passHeight; y++) {
+			unsigned char filter = raw[rawOffset];
+			unsigned char* row = &raw[rawOffset + 1];
+			rawOffset += rowBytes + 1;
+			for (size_t i = 0; i < rowBytes; i++) {
+				int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+				int up = previousRow[i];
+				int upLeft = i >= bytesPerPixel ? previousRow[i - bytesPerPixel] : 0;
+				switch (filter) {
+				case 0:
+					break;
+				case 1:
+					row[i] += left;
+					break;
+				case 2:
+					row[i] += up;
+					break;
+				case 3:
+					row[i] += (left + up) >> 1;
+					break;
+				case 4:
+					row[i] += paeth(left, up, upLeft);
+					break;
+				default:
+					return false;
+				}
+			}
+			std::memcpy(previousRow.data(), row, rowBytes);
+
+			for (size_t x = 0; x < passWidth; x++) {
+				uint16_t samples[4] = { 0, 0, 0, 0 };
+				for (int c = 0; c < channels; c++) {
+					if (bitDepth == 8) {
+						samples[c] = row[x * channels + c];
+					}
+					else if (bitDepth == 16) {
+						samples[c] = readUint16BE(row + (x * channels + c) * 2);
+					}
+					else {
+						size_t bit = x * bitDepth;
+						samples[c] = (row[bit / 8] >> (8 - bitDepth - bit % 8)) & maxSample;
+					}
+				}
+				auto toByte = [bitDepth, maxSample](uint16_t sample) {
+					if (bitDepth == 16) {
+						return (unsigned char)(sample >> 8);
+					}
+					return (unsigned char)(sample * 255 / maxSample);
+				};
+				unsigned char* pixel = &pixels->rgba[((startY + y * stepY) * width + startX + x * stepX) * 4];
+				if (colorType == 3) {
+					if (samples[0] >= paletteSize) {
+						return false;
+					}
+					std::memcpy(pixel, palette[samples[0]], 4);
+				}
+				else if (colorType == 0 || colorType == 4) {
+					pixel[0] = pixel[1] = pixel[2] = toByte(samples[0]);
+					pixel[3] = colorType == 4 ? toByte(samples[1]) : (hasColorKey && samples[0] == colorKey[0] ? 0 : 255);
+				}
+				else {
+					pixel[0] = toByte(samples[0]);
+					pixel[1] = toByte(samples[1]);
+					pixel[2] = toByte(samples[2]);
+					if (colorType == 6) {
+						pixel[3] = toByte(samples[3]);
+					}
+					else {
+						bool transparent = hasColorKey && samples[0] == colorKey[0] && samples[1] == colorKey[1] && samples[2] == colorKey[2];
+						pixel[3] = transparent ? 0 : 255;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void writePNGChunk(std::vector<unsigned char>* out, const char* type, const std::vector<unsigned char>& chunk) {
+	writeUint32BE(out, (uint32_t)chunk.size());
+	size_t typeOffset = out->size();
+	out->insert(out->end(), type, type + 4);
+	out->insert(out->end(), chunk.begin(), chunk.end());
+	writeUint32BE(out, crc32(out->data() + typeOffset, chunk.size() + 4));
+}
+
+std::vector<unsigned char> ImageCodec::encodePNG(const ImageCodec::Pixels& pixels) {
+	size_t pixelCount = (size_t)pixels.width * pixels.height;
+	bool opaque = true;
+	for (size_t i = 0; i < pixelCount && opaque; i++) {
+		opaque = pixels.rgba[i * 4 + 3] == 255;
+	}
+	int channels = opaque ? 3 : 4;
+	size_t rowBytes = (size_t)pixels.width * channels;
+
+	// Each row uses the filter that gives the smallest sum of absolute differences
+	std::vector<unsigned char> filtered;
+	filtered.reserve((rowBytes + 1) * pixels.height);
+	std::vector<unsigned char> previousRow(rowBytes, 0);
+	std::vector<unsigned char> row(rowBytes);
+	std::vector<unsigned char> candidate(rowBytes);
+	std::vector<unsigned char> best(rowBytes);
+	for (int y = 0; y < pixels.height; y++) {
+		const unsigned char* source = &pixels.rgba[(size_t)y * pixels.width * 4];
+		for (int x = 0; x < pixels.width; x++) {
+			std::memcpy(&row[(size_t)x * channels], source + (size_t)x * 4, channels);
+		}
+		uint64_t bestScore = UINT64_MAX;
+		unsigned char bestFilter = 0;
+		for (unsigned char filter = 0; filter < 5; filter++) {
+			uint64_t score = 0;
+			for (size_t i = 0; i < rowBytes; i++) {
+				int left = i >= (size_t)channels ? row[i - channels] : 0;
+				int up = previousRow[i];
+				int upLeft = i >= (size_t)channels ? previousRow[i - channels] : 0;
+				int predicted = 0;
+				switch (filter) {
+				case 1:
+					predicted = left;
+					break;
+				case 2:
+					predicted = up;
+					break;
+				case 3:
+					predicted = (left + up) >> 1;
+					break;
+				case 4:
+					predicted = paeth(left, up, upLeft);
+					break;
+				}
+				candidate[i] = (unsigned char)(row[i] - predicted);
+				score += std::abs((int)(signed char)candidate[i]);
+			}
+			if (score < bestScore) {
+				bestScore = score;
+				bestFilter = filter;
+				best.swap(candidate);
+			}
+		}
+		filtered.push_back(bestFilter);
+		filtered.insert(filtered.end(), best.begin(), best.end());
+		previousRow.swap(row);
+		row.resize(rowBytes);
+	}
+
+	std::vector<unsigned char> compressed;
+	compressed.push_back(0x78);
+	compressed.push_back(0x01);
+	deflate(filtered.data(), filtered.size(), &compressed);
+	writeUint32BE(&compressed, adler32(filtered.data(), filtered.size()));
+
+	std::vector<unsigned char> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> header;
+	writeUint32BE(&header, (uint32_t)pixels.width);
+	writeUint32BE(&header, (uint32_t)pixels.height);
+	header.push_back(8);
+	header.push_back(opaque ? 2 : 6);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writePNGChunk(&out, "IHDR", header);
+	writePNGChunk(&out, "IDAT", compressed);
+	writePNGChunk(&out, "IEND", std::vector<unsigned char>());
+	return out;
+}
+
+/**
+ * A JPEG Huffman table, decoded with a lookup table for codes of up to 9 bits and the canonical
+ * code ranges for longer ones.
+ */
+struct JPEGHuffman {
+	unsigned char lookupLength[512];
+	unsigned char lookupValue[512];
+	int maxCode[18];
+	int valueOffset[17];
+	unsigned char values[256];
+	bool defined = false;
+
+	bool build(const unsigned char* counts, const unsigned char* symbols, int symbolCount) {
+		std::memset(lookupLength, 0, sizeof(lookupLength));
+		std::memcpy(values, symbols, symbolCount);
+		int code = 0;
+		int index = 0;
+		for (int length = 1; length <= 16; length++) {
+			valueOffset[length] = index - code;
+			for (int i = 0; i < counts[length - 1]; i++, index++, code++) {
+				if (length <= 9) {
+					int shift = 9 - length;
+					for (int fill = 0; fill < (1 << shift); fill++) {
+						lookupLength[(code << shift) | fill] = (unsigned char)length;
+						lookupValue[(code << shift) | fill] = symbols[index];
+					}
+				}
+			}
+			maxCode[length] = counts[length - 1] > 0 ? code - 1 : -1;
+			if (code > (1 << length)) {
+				return false;
+			}
+			code <<= 1;
+		}
+		maxCode[17] = INT32_MAX;
+		defined = true;
+		return true;
+	}
+};
+
+/**
+ * Reads JPEG entropy coded data most significant bit first, removing stuffed zero bytes and
+ * stopping at the next marker.
+ */
+class JPEGBitReader {
+public:
+	const unsigned char* data;
+	size_t length;
+	size_t position;
+
+	JPEGBitReader(const unsigned char* data, size_t length, size_t position) : data(data), length(length), position(position) {}
+
+	void fill() {
+		while (_bitCount <= 24) {
+			unsigned char byte = 0;
+			if (!_atMarker && position < length) {
+				byte = data[position];
+				if (byte == 0xFF) {
+					unsigned char next = position + 1 < length ? data[position + 1] : 0;
+					if (next == 0x00) {
+						position += 2;
+					}
+					else {
+						_atMarker = true;
+						byte = 0;
+					}
+				}
+				else {
+					position++;
+				}
+			}
+			_bitBuffer |= (uint32_t)byte << (24 - _bitCount);
+			_bitCount += 8;
+		}
+	}
+
+	int bits(int count) {
+		if (count == 0) {
+			return 0;
+		}
+		fill();
+		int value = (int)(_bitBuffer >> (32 - count));
+		_bitBuffer <<= count;
+		_bitCount -= count;
+		return value;
+	}
+
+	int decode(const JPEGHuffman& huffman) {
+		fill();
+		int index = (int)(_bitBuffer >> 23);
+		int length = huffman.lookupLength[index];
+		if (length > 0) {
+			_bitBuffer <<= length;
+			_bitCount -= length;
+			return huffman.lookupValue[index];
+		}
+		for (length = 10; length <= 16; length++) {
+			int code = (int)(_bitBuffer >> (32 - length));
+			if (code <= huffman.maxCode[length]) {
+				_bitBuffer <<= length;
+				_bitCount -= length;
+				return huffman.values[huffman.valueOffset[length] + code];
+			}
+		}
+		return -1;
+	}
+
+	// Sign extends a value of the given size in bits
+	int receive(int size) {
+		int value = bits(size);
+		if (size > 0 && value < (1 << (size - 1))) {
+			value -= (1 << size) - 1;
+		}
+		return value;
+	}
+
+	// Discards the rest of the current byte and skips a restart marker
+	void restart() {
+		_bitBuffer = 0;
+		_bitCount = 0;
+		_atMarker = false;
+		while (position + 1 < length && data[position] == 0xFF && data[position + 1] == 0xFF) {
+			position++;
+		}
+		if (position + 1 < length && data[position] == 0xFF && data[position + 1] >= 0xD0 && data[position + 1] <= 0xD7) {
+			position += 2;
+		}
+	}
+
+	// Moves to the marker that ends the entropy coded data
+	size_t markerPosition() {
+		while (position + 1 < length && !(data[position] == 0xFF && data[position + 1] != 0x00 && !(data[position + 1] >= 0xD0 && data[position + 1] <= 0xD7))) {
+			position++;
+		}
+		return position;
+	}
+
+private:
+	uint32_t _bitBuffer = 0;
+	int _bitCount = 0;
+	bool _atMarker = false;
+};
+
+struct JPEGComponent {
+	int id = 0;
+	int h = 1;
+	int v = 1;
+	int quantizationTable = 0;
+	int dcTable = 0;
+	int acTable = 0;
+	int predictor = 0;
+	size_t planeWidth = 0;
+	size_t planeHeight = 0;
+	std::vector<unsigned char> plane;
+};
+
+// The DCT basis, cosines[x][u] is the weight of frequency u at sample x
+struct DCTCosines {
+	float values[8][8];
+
+	DCTCosines() {
+		for (int x = 0; x < 8; x++) {
+			for (int u = 0; u < 8; u++) {
+				float scale = u == 0 ? (float)std::sqrt(0.125) : 0.5f;
+				values[x][u] = scale * (float)std::cos((2 * x + 1) * u * 3.14159265358979 / 16);
+			}
+		}
+	}
+};
+
+/**
+ * Computes the inverse DCT of a dequantized block in natural order and stores the level shifted
+ * samples.
+ */
+static void inverseDCT(const float* coefficients, unsigned char* out, size_t stride) {
+	static const DCTCosines dct;
+	const float (&cosines)[8][8] = dct.values;
+	float rows[64];
+	for (int v = 0; v < 8; v++) {
+		for (int x = 0; x < 8; x++) {
+			float sum = 0;
+			for (int u = 0; u < 8; u++) {
+				sum += cosines[x][u] * coefficients[v * 8 + u];
+			}
+			rows[v * 8 + x] = sum;
+		}
+	}
+	for (int x = 0; x < 8; x++) {
+		for (int y = 0; y < 8; y++) {
+			float sum = 0;
+			for (int v = 0; v < 8; v++) {
+				sum += cosines[y][v] * rows[v * 8 + x];
+			}
+			int value = (int)std::lround(sum + 128);
+			out[y * stride + x] = (unsigned char)std::min(255, std::max(0, value));
+		}
+	}
+}
+
+bool ImageCodec::decodeJPEG(const unsigned char* data, size_t length, ImageCodec::Pixels* pixels) {
+	if (length < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+		return false;
+	}
+	uint16_t quantizationTables[4][64];
+	JPEGHuffman dcTables[4];
+	JPEGHuffman acTables[4];
+	std::vector<JPEGComponent> components;
+	int width = 0;
+	int height = 0;
+	int hMax = 1;
+	int vMax = 1;
+	int restartInterval = 0;
+	bool adobeRGB = false;
+	bool frameRead = false;
+	size_t offset = 2;
+	while (offset + 4 <= length) {
+		if (data[offset] != 0xFF) {
+			offset++;
+			continue;
+		}
+		unsigned char marker = data[offset + 1];
+		if (marker == 0xFF) {
+			offset++;
+			continue;
+		}
+		if (marker == 0xD9) {
+			break;
+		}
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+			offset += 2;
+			continue;
+		}
+		size_t segmentLength = readUint16BE(data + offset + 2);
+		const unsigned char* segment = data + offset + 4;
+		if (segmentLength < 2 || offset + 2 + segmentLength > length) {
+			return false;
+		}
+		size_t contentLength = segmentLength - 2;
+		offset += 2 + segmentLength;
+		if (marker == 0xDB) {
+			size_t position = 0;
+			while (position < contentLength) {
+				int precision = segment[position] >> 4;
+				int table = segment[position] & 3;
+				position++;
+				if (position + 64 * (precision + 1) > contentLength) {
+					return false;
+				}
+				for (int k = 0; k < 64; k++) {
+					quantizationTables[table][k] = precision == 0 ? segment[position + k] : readUint16BE(segment + position + k * 2);
+				}
+				position += 64 * (precision + 1);
+			}
+		}
+		else if (marker == 0xC4) {
+			size_t position = 0;
+			while (position + 17 <= contentLength) {
+				int tableClass = segment[position] >> 4;
+				int table = segment[position] & 3;
+				const unsigned char* counts = segment + position + 1;
+				int symbolCount = 0;
+				for (int i = 0; i < 16; i++) {
+					symbolCount += counts[i];
+				}
+				if (symbolCount > 256 || position + 17 + symbolCount > contentLength) {
+					return false;
+				}
+				JPEGHuffman* huffman = tableClass == 0 ? &dcTables[table] : &acTables[table];
+				if (!huffman->build(counts, segment + position + 17, symbolCount)) {
+					return false;
+				}
+				position += 17 + symbolCount;
+			}
+		}
+		else if (marker == 0xC0 || marker == 0xC1) {
+			if (contentLength < 6 || segment[0] != 8) {
+				return false;
+			}
+			height = readUint16BE(segment + 1);
+			width = readUint16BE(segment + 3);
+			int componentCount = segment[5];
+			if ((componentCount != 1 && componentCount != 3) || contentLength < 6 + (size_t)componentCount * 3 || width == 0 || height == 0) {
+				return false;
+			}
+			for (int i = 0; i < componentCount; i++) {
+				JPEGComponent component;
+				component.id = segment[6 + i * 3];
+				component.h = segment[7 + i * 3] >> 4;
+				component.v = segment[7 + i * 3] & 15;
+				component.quantizationTable = segment[8 + i * 3] & 3;
+				if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4) {
+					return false;
+				}
+				hMax = std::max(hMax, component.h);
+				vMax = std::max(vMax, component.v);
+				components.push_back(component);
+			}
+			size_t mcusX = (width + 8 * hMax - 1) / (8 * hMax);
+			size_t mcusY = (height + 8 * vMax - 1) / (8 * vMax);
+			for (JPEGComponent& component : components) {
+				component.planeWidth = mcusX * component.h * 8;
+				component.planeHeight = mcusY * component.v * 8;
+				component.plane.assign(component.planeWidth * component.planeHeight, 0);
+			}
+			frameRead = true;
+		}
+		else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+			// Progressive, lossless and arithmetic coded frames
+			return false;
+		}
+		else if (marker == 0xDD && contentLength >= 2) {
+			restartInterval = readUint16BE(segment);
+		}
+		else if (marker == 0xEE && contentLength >= 12 && std::memcmp(segment, "Adobe", 5) == 0) {
+			adobeRGB = segment[11] == 0;
+		}
+		else if (marker == 0xDA) {
+			if (!frameRead || contentLength < 1) {
+				return false;
+			}
+			int scanComponentCount = segment[0];
+			if (contentLength < 4 + (size_t)scanComponentCount * 2) {
+				return false;
+			}
+			std::vector<JPEGComponent*> scanComponents;
+			for (int i = 0; i < scanComponentCount; i++) {
+				int id = segment[1 + i * 2];
+				JPEGComponent* found = NULL;
+				for (JPEGComponent& component : components) {
+					if (component.id == id) {
+						found = &component;
+					}
+				}
+				if (found == NULL) {
+					return false;
+				}
+				found->dcTable = segment[2 + i * 2] >> 4 & 3;
+				found->acTable = segment[2 + i * 2] & 3;
+				found->predictor = 0;
+				if (!dcTables[found->dcTable].defined || !acTables[found->acTable].defined) {
+					return false;
+				}
+				scanComponents.push_back(found);
+			}
+
+			// Interleaved scans code whole MCUs, a single component scan codes its blocks in raster order
+			size_t mcusX;
+			size_t mcusY;
+			if (scanComponentCount == 1) {
+				JPEGComponent* component = scanComponents[0];
+				size_t componentWidth = ((size_t)width * component->h + hMax - 1) / hMax;
+				size_t componentHeight = ((size_t)height * component->v + vMax - 1) / vMax;
+				mcusX = (componentWidth + 7) / 8;
+				mcusY = (componentHeight + 7) / 8;
+			}
+			else {
+				mcusX = (width + 8 * hMax - 1) / (8 * hMax);
+				mcusY = (height + 8 * vMax - 1) / (8 * vMax);
+			}
+			JPEGBitReader reader(data, length, offset);
+			float coefficients[64];
+			size_t mcuCount = 0;
+			for (size_t mcuY = 0; mcuY < mcusY; mcuY++) {
+				for (size_t mcuX = 0; mcuX < mcusX; mcuX++) {
+					if (restartInterval > 0 && mcuCount > 0 && mcuCount % restartInterval == 0) {
+						reader.restart();
+						for (JPEGComponent* component : scanComponents) {
+							component->predictor = 0;
+						}
+					}
+					mcuCount++;
+					for (JPEGComponent* component : scanComponents) {
+						int blocksX = scanComponentCount == 1 ? 1 : component->h;
+						int blocksY = scanComponentCount == 1 ? 1 : component->v;
+						const uint16_t* quantization = quantizationTables[component->quantizationTable];
+						for (int blockY = 0; blockY < blocksY; blockY++) {
+							for (int blockX = 0; blockX < blocksX; blockX++) {
+								std::fill(coefficients, coefficients + 64, 0.0f);
+								int size = reader.decode(dcTables[component->dcTable]);
+								if (size < 0 || size > 11) {
+									return false;
+								}
+								component->predictor += reader.receive(size);
+								coefficients[0] = (float)(component->predictor * quantization[0]);
+								for (int k = 1; k < 64;) {
+									int runSize = reader.decode(acTables[component->acTable]);
+									if (runSize < 0) {
+										return false;
+									}
+									int run = runSize >> 4;
+									size = runSize & 15;
+									if (size == 0) {
+										if (run != 15) {
+											break;
+										}
+										k += 16;
+										continue;
+									}
+									k += run;
+									if (k > 63) {
+										return false;
+									}
+									coefficients[ZIGZAG[k]] = (float)(reader.receive(size) * quantization[k]);
+									k++;
+								}
+								size_t x = scanComponentCount == 1 ? mcuX * 8 : (mcuX * component->h + blockX) * 8;
+								size_t y = scanComponentCount == 1 ? mcuY * 8 : (mcuY * component->v + blockY) * 8;
+								if (x + 8 <= component->planeWidth && y + 8 <= component->planeHeight) {
+									inverseDCT(coefficients, &component->plane[y * component->planeWidth + x], component->planeWidth);
+								}
+							}
+						}
+					}
+				}
+			}
+			offset = reader.markerPosition();
+		}
+	}
+	if (!frameRead) {
+		return false;
+	}
+
+	pixels->width = width;
+	pixels->height = height;
+	pixels->rgba.resize((size_t)width * height * 4);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			unsigned char* pixel = &pixels->rgba[((size_t)y * width + x) * 4];
+			pixel[3] = 255;
+			float samples[3];
+			for (size_t c = 0; c < components.size(); c++) {
+				const JPEGComponent& component = components[c];
+				size_t sampleX = (size_t)x * component.h / hMax;
+				size_t sampleY = (size_t)y * component.v / vMax;
+				samples[c] = component.plane[sampleY * component.planeWidth + sampleX];
+			}
+			if (components.size() == 1) {
+				pixel[0] = pixel[1] = pixel[2] = (unsigned char)samples[0];
+			}
+			else if (adobeRGB) {
+				pixel[0] = (unsigned char)samples[0];
+				pixel[1] = (unsigned char)samples[1];
+				pixel[2] = (unsigned char)samples[2];
+			}
+			else {
+				float luma = samples[0];
+				float cb = samples[1] - 128;
+				float cr = samples[2] - 128;
+				float rgb[3] = { luma + 1.402f * cr, luma - 0.344136f * cb - 0.714136f * cr, luma + 1.772f * cb };
+				for (int c = 0; c < 3; c++) {
+					pixel[c] = (unsigned char)std::min(255.0f, std::max(0.0f, std::round(rgb[c])));
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool ImageCodec::decode(const unsigned char* data, size_t length, ImageCodec::Pixels* pixels) {
+	if (length >= 8 && data[0] == 0x89 && data[1] == 'P') {
+		return decodePNG(data, length, pixels);
+	}
+	if (length >= 2 && data[0] == 0xFF && data[1] == 0xD8) {
+		return decodeJPEG(data, length, pixels);
+	}
+	return false;
+}
+
+/**
+ * Writes JPEG entropy coded data most significant bit first, stuffing a zero after each 0xFF.
+ */
+class JPEGBitWriter {
+public:
+	std::vector<unsigned char>* out;
+
+	JPEGBitWriter(std::vector<unsigned char>* out) : out(out) {}
+
+	void bits(uint32_t value, int count) {
+		_bitBuffer = (_bitBuffer << count) | (value & ((1u << count) - 1));
+		_bitCount += count;
+		while (_bitCount >= 8) {
+			unsigned char byte = (unsigned char)(_bitBuffer >> (_bitCount - 8));
+			out->push_back(byte);
+			if (byte == 0xFF) {
+				out->push_back(0);
+			}
+			_bitCount -= 8;
+		}
+	}
+
+	// Pads the last byte with one bits
+	void flush() {
+		if (_bitCount > 0) {
+			bits(0x7F, 8 - _bitCount);
+		}
+	}
+
+private:
+	uint32_t _bitBuffer = 0;
+	int _bitCount = 0;
+};
+
+struct JPEGHuffmanCodes {
+	uint16_t codes[256];
+	unsigned char lengths[256];
+
+	JPEGHuffmanCodes(const unsigned char* counts, const unsigned char* symbols) {
+		std::memset(lengths, 0, sizeof(lengths));
+		int code = 0;
+		int index = 0;
+		for (int length = 1; length <= 16; length++) {
+			for (int i = 0; i < counts[length - 1]; i++) {
+				codes[symbols[index]] = (uint16_t)code++;
+				lengths[symbols[index]] = (unsigned char)length;
+				index++;
+			}
+			code <<= 1;
+		}
+	}
+};
+
+// The example Huffman tables from Annex K of the JPEG specification
+const unsigned char DC_LUMINANCE_COUNTS[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+const unsigned char DC_CHROMINANCE_COUNTS[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+const unsigned char DC_SYMBOLS[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+const unsigned char AC_LUMINANCE_COUNTS[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D };
+const unsigned char AC_LUMINANCE_SYMBOLS[162] = {
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+	0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+	0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+	0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+const unsigned char AC_CHROMINANCE_COUNTS[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+const unsigned char AC_CHROMINANCE_SYMBOLS[162] = {
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+	0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+	0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+	0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+	0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+	0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+	0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+	0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+// The example quantization tables from Annex K of the JPEG specification, in natural order
+const int LUMINANCE_QUANTIZATION[64] = {
+	16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+	14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+	18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+	49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99
+};
+const int CHROMINANCE_QUANTIZATION[64] = {
+	17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+	24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
+};
+
+static void writeJPEGHuffmanTable(std::vector<unsigned char>* out, int tableClassAndId, const unsigned char* counts, const unsigned char* symbols) {
+	int symbolCount = 0;
+	for (int i = 0; i < 16; i++) {
+		symbolCount += counts[i];
+	}
+	out->push_back(0xFF);
+	out->push_back(0xC4);
+	writeUint16BE(out, (uint16_t)(2 + 1 + 16 + symbolCount));
+	out->push_back((unsigned char)tableClassAndId);
+	out->insert(out->end(), counts, counts + 16);
+	out->insert(out->end(), symbols, symbols + symbolCount);
+}
+
+/**
+ * Computes the forward DCT of level shifted samples, quantizes it and codes the block.
+ */
+static void encodeJPEGBlock(const float* samples, const int* quantization, const JPEGHuffmanCodes& dc, const JPEGHuffmanCodes& ac, int* predictor, JPEGBitWriter* writer) {
+	static const DCTCosines dct;
+	const float (&cosines)[8][8] = dct.values;
+	float rows[64];
+	for (int y = 0; y < 8; y++) {
+		for (int u = 0; u < 8; u++) {
+			float sum = 0;
+			for (int x = 0; x < 8; x++) {
+				sum += cosines[x][u] * samples[y * 8 + x];
+			}
+			rows[y * 8 + u] = sum;
+		}
+	}
+	int quantized[64];
+	for (int u = 0; u < 8; u++) {
+		for (int v = 0; v < 8; v++) {
+			float sum = 0;
+			for (int y = 0; y < 8; y++) {
+				sum += cosines[y][v] * rows[y * 8 + u];
+			}
+			quantized[v * 8 + u] = (int)std::lround(sum / quantization[v * 8 + u]);
+		}
+	}
+
+	auto category = [](int value) {
+		int magnitude = std::abs(value);
+		int size = 0;
+		while (magnitude > 0) {
+			magnitude >>= 1;
+			size++;
+		}
+		return size;
+	};
+	auto writeValue = [writer](int value, int size) {
+		if (size > 0) {
+			writer->bits(value < 0 ? (uint32_t)(value + (1 << size) - 1) : (uint32_t)value, size);
+		}
+	};
+
+	int difference = quantized[0] - *predictor;
+	*predictor = quantized[0];
+	int size = category(difference);
+	writer->bits(dc.codes[size], dc.lengths[size]);
+	writeValue(difference, size);
+
+	int run = 0;
+	for (int k = 1; k < 64; k++) {
+		int value = quantized[ZIGZAG[k]];
+		if (value == 0) {
+			run++;
+			continue;
+		}
+		while (run > 15) {
+			writer->bits(ac.codes[0xF0], ac.lengths[0xF0]);
+			run -= 16;
+		}
+		size = category(value);
+		int symbol = (run << 4) | size;
+		writer->bits(ac.codes[symbol], ac.lengths[symbol]);
+		writeValue(value, size);
+		run = 0;
+	}
+	if (run > 0) {
+		writer->bits(ac.codes[0x00], ac.lengths[0x00]);
+	}
+}
+
+std::vector<unsigned char> ImageCodec::encodeJPEG(const ImageCodec::Pixels& pixels, int quality) {
+	quality = std::min(100, std::max(1, quality));
+	int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+	int quantization[2][64];
+	for (int i = 0; i < 64; i++) {
+		quantization[0][i] = std::min(255, std::max(1, (LUMINANCE_QUANTIZATION[i] * scale + 50) / 100));
+		quantization[1][i] = std::min(255, std::max(1, (CHROMINANCE_QUANTIZATION[i] * scale + 50) / 100));
+	}
+
+	std::vector<unsigned char> out = { 0xFF, 0xD8 };
+	static const unsigned char JFIF[16] = { 0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1 };
+	out.insert(out.end(), JFIF, JFIF + 16);
+	out.push_back(0);
+	out.push_back(0);
+	for (int table = 0; table < 2; table++) {
+		out.push_back(0xFF);
+		out.push_back(0xDB);
+		writeUint16BE(&out, 67);
+		out.push_back((unsigned char)table);
+		for (int k = 0; k < 64; k++) {
+			out.push_back((unsigned char)quantization[table][ZIGZAG[k]]);
+		}
+	}
+	out.push_back(0xFF);
+	out.push_back(0xC0);
+	writeUint16BE(&out, 17);
+	out.push_back(8);
+	writeUint16BE(&out, (uint16_t)pixels.height);
+	writeUint16BE(&out, (uint16_t)pixels.width);
+	out.push_back(3);
+	for (int component = 0; component < 3; component++) {
+		out.push_back((unsigned char)(component + 1));
+		out.push_back(0x11);
+		out.push_back(component == 0 ? 0 : 1);
+	}
+	writeJPEGHuffmanTable(&out, 0x00, DC_LUMINANCE_COUNTS, DC_SYMBOLS);
+	writeJPEGHuffmanTable(&out, 0x10, AC_LUMINANCE_COUNTS, AC_LUMINANCE_SYMBOLS);
+	writeJPEGHuffmanTable(&out, 0x01, DC_CHROMINANCE_COUNTS, DC_SYMBOLS);
+	writeJPEGHuffmanTable(&out, 0x11, AC_CHROMINANCE_COUNTS, AC_CHROMINANCE_SYMBOLS);
+	static const unsigned char SCAN[14] = { 0xFF, 0xDA, 0, 12, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 };
+	out.insert(out.end(), SCAN, SCAN + 14);
+
+	JPEGHuffmanCodes dcLuminance(DC_LUMINANCE_COUNTS, DC_SYMBOLS);
+	JPEGHuffmanCodes acLuminance(AC_LUMINANCE_COUNTS, AC_LUMINANCE_SYMBOLS);
+	JPEGHuffmanCodes dcChrominance(DC_CHROMINANCE_COUNTS, DC_SYMBOLS);
+	JPEGHuffmanCodes acChrominance(AC_CHROMINANCE_COUNTS, AC_CHROMINANCE_SYMBOLS);
+	JPEGBitWriter writer(&out);
+	int predictors[3] = { 0, 0, 0 };
+	float blocks[3][64];
+	for (int blockY = 0; blockY < pixels.height; blockY += 8) {
+		for (int blockX = 0; blockX < pixels.width; blockX += 8) {
+			for (int y = 0; y < 8; y++) {
+				for (int x = 0; x < 8; x++) {
+					// Edge blocks repeat the last row and column
+					int sampleX = std::min(blockX + x, pixels.width - 1);
+					int sampleY = std::min(blockY + y, pixels.height - 1);
+					const unsigned char* pixel = &pixels.rgba[((size_t)sampleY * pixels.width + sampleX) * 4];
+					float r = pixel[0];
+					float g = pixel[1];
+					float b = pixel[2];
+					blocks[0][y * 8 + x] = 0.299f * r + 0.587f * g + 0.114f * b - 128;
+					blocks[1][y * 8 + x] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+					blocks[2][y * 8 + x] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+				}
+			}
+			encodeJPEGBlock(blocks[0], quantization[0], dcLuminance, acLuminance, &predictors[0], &writer);
+			encodeJPEGBlock(blocks[1], quantization[1], dcChrominance, acChrominance, &predictors[1], &writer);
+			encodeJPEGBlock(blocks[2], quantization[1], dcChrominance, acChrominance, &predictors[2], &writer);
+		}
+	}
+	writer.flush();
+	out.push_back(0xFF);
+	out.push_back(0xD9);
+	return out;
+}
@@ -0,0 +1,639 @@
+#include "MeshOptimizer.h"
+
+#include <climits>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Scoring constants from Forsyth, "Linear-Speed Vertex Cache Optimisation"
+const int CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+	VertexCacheStatistics statistics;
+	statistics.triangleCount = indexCount / 3;
+
+	// The time each vertex was added to the cache, a vertex is in the cache if it was added within the last cacheSize misses
+	std::vector<size_t> cacheTimestamps(vertexCount, 0);
+	size_t timestamp = cacheSize + 1;
+	std::vector<bool> referenced(vertexCount, false);
+	for (size_t i = 0; i < statistics.triangleCount * 3; i++) {
+		unsigned int index = indices[i];
+		if (index >= vertexCount) {
+			continue;
+		}
+		if (!referenced[index]) {
+			referenced[index] = true;
+			statistics.vertexCount++;
+		}
+		if (timestamp - cacheTimestamps[index] > cacheSize) {
+			cacheTimestamps[index] = timestamp;
+			timestamp++;
+			statistics.cacheMisses++;
+		}
+	}
+	if (statistics.triangleCount > 0) {
+		statistics.acmr = (float)statistics.cacheMisses / statistics.triangleCount;
+	}
+	if (statistics.vertexCount > 0) {
+		statistics.atvr = (float)statistics.cacheMisses / statistics.vertexCount;
+	}
+	return statistics;
+}
+
+float getVertexScore(int cachePosition, unsigned int remainingTriangles) {
+	if (remainingTriangles == 0) {
+		// No triangles left to draw
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			// The vertices of the last triangle get a fixed score so that their triangles are not always picked next
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else {
+			float scaler = 1.0f / (CACHE_SIZE - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+		}
+	}
+	// Boost vertices with few triangles left so that they are finished off
+	score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+	return score;
+}
+
+void MeshOptimizer::optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount) {
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	// Adjacency from each vertex to the triangles that have not been drawn yet
+	std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		if (indices[i] >= vertexCount) {
+			return;
+		}
+		remainingTriangles[indices[i]]++;
+	}
+	std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++) {
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingTriangles[i];
+	}
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> adjacencyCounts(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount; i++) {
+		for (size_t j = 0; j < 3; j++) {
+			unsigned int vertex = indices[i * 3 + j];
+			adjacency[adjacencyOffsets[vertex] + adjacencyCounts[vertex]] = (unsigned int)i;
+			adjacencyCounts[vertex]++;
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		vertexScores[i] = getVertexScore(-1, remainingTriangles[i]);
+	}
+	std::vector<bool> drawn(triangleCount, false);
+	std::vector<unsigned int> optimizedIndices;
+	optimizedIndices.reserve(triangleCount * 3);
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> nextCache;
+	cache.reserve(CACHE_SIZE + 3);
+	nextCache.reserve(CACHE_SIZE + 3);
+
+	size_t nextUndrawnTriangle = 0;
+	long long bestTriangle = 0;
+	while (bestTriangle >= 0) {
+		drawn[bestTriangle] = true;
+		unsigned int* triangle = indices + bestTriangle * 3;
+		nextCache.clear();
+		for (size_t j = 0; j < 3; j++) {
+			unsigned int vertex = triangle[j];
+			optimizedIndices.push_back(vertex);
+			nextCache.push_back(vertex);
+
+			// Remove the triangle from the vertex adjacency
+			unsigned int* triangles = &adjacency[adjacencyOffsets[vertex]];
+			unsigned int count = remainingTriangles[vertex];
+			for (unsigned int k = 0; k < count; k++) {
+				if (triangles[k] == bestTriangle) {
+					triangles[k] = triangles[count - 1];
+					break;
+				}
+			}
+			remainingTriangles[vertex]--;
+		}
+
+		// The vertices of the drawn triangle move to the front of the cache
+		for (unsigned int vertex : cache) {
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+		cache.swap(nextCache);
+
+		// Rescore the vertices in the cache and the triangles that use them
+		for (size_t i = 0; i < cache.size(); i++) {
+			unsigned int vertex = cache[i];
+			int cachePosition = i < (size_t)CACHE_SIZE ? (int)i : -1;
+			cachePositions[vertex] = cachePosition;
+			vertexScores[vertex] = getVertexScore(cachePosition, remainingTriangles[vertex]);
+		}
+		if (cache.size() > (size_t)CACHE_SIZE) {
+			cache.resize(CACHE_SIZE);
+		}
+
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : cache) {
+			unsigned int* triangles = &adjacency[adjacencyOffsets[vertex]];
+			for (unsigned int k = 0; k < remainingTriangles[vertex]; k++) {
+				unsigned int candidate = triangles[k];
+				unsigned int* candidateIndices = indices + candidate * 3;
+				float score = vertexScores[candidateIndices[0]] + vertexScores[candidateIndices[1]] + vertexScores[candidateIndices[2]];
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = candidate;
+				}
+			}
+		}
+
+		if (bestTriangle < 0) {
+			// Nothing in the cache has triangles left, continue with the next triangle in the original order
+			while (nextUndrawnTriangle < triangleCount && drawn[nextUndrawnTriangle]) {
+				nextUndrawnTriangle++;
+			}
+			if (nextUndrawnTriangle < triangleCount) {
+				bestTriangle = nextUndrawnTriangle;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < optimizedIndices.size(); i++) {
+		indices[i] = optimizedIndices[i];
+	}
+}
+
+std::vector<unsigned int> MeshOptimizer::computeVertexFetchRemap(const unsigned int* indices, size_t indexCount, size_t vertexCount) {
+	std::vector<unsigned int> remap(vertexCount, UINT_MAX);
+	unsigned int nextVertex = 0;
+	for (size_t i = 0; i < indexCount; i++) {
+		unsigned int index = indices[i];
+		if (index < vertexCount && remap[index] == UINT_MAX) {
+			remap[index] = nextVertex;
+			nextVertex++;
+		}
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		if (remap[i] == UINT_MAX) {
+			remap[i] = nextVertex;
+			nextVertex++;
+		}
+	}
+	return remap;
+}
+
+// Simplification
+
+enum class VertexKind {
+	MANIFOLD,
+	BORDER
+};
+
+// Boundary constraints are weighted heavily so that open borders keep their shape
+const double BORDER_WEIGHT = 10.0;
+// Attribute seams are only constrained lightly, since the surface continues across them
+const double SEAM_WEIGHT = 1.0;
+
+class Quadric {
+public:
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0 = 0, b1 = 0, b2 = 0;
+	double c = 0;
+	double weight = 0;
+
+	void addPlane(const double* normal, double distance, double planeWeight) {
+		a00 += planeWeight * normal[0] * normal[0];
+		a01 += planeWeight * normal[0] * normal[1];
+		a02 += planeWeight * normal[0] * normal[2];
+		a11 += planeWeight * normal[1] * normal[1];
+		a12 += planeWeight * normal[1] * normal[2];
+		a22 += planeWeight * normal[2] * normal[2];
+		b0 += planeWeight * normal[0] * distance;
+		b1 += planeWeight * normal[1] * distance;
+		b2 += planeWeight * normal[2] * distance;
+		c += planeWeight * distance * distance;
+		weight += planeWeight;
+	}
+
+	void add(const Quadric& quadric) {
+		a00 += quadric.a00;
+		a01 += quadric.a01;
+		a02 += quadric.a02;
+		a11 += quadric.a11;
+		a12 += quadric.a12;
+		a22 += quadric.a22;
+		b0 += quadric.b0;
+		b1 += quadric.b1;
+		b2 += quadric.b2;
+		c += quadric.c;
+		weight += quadric.weight;
+	}
+
+	// The mean squared distance from the point to the planes of the quadric
+	double getError(const double* p) const {
+		double rx = a00 * p[0] + a01 * p[1] + a02 * p[2] + 2 * b0;
+		double ry = a01 * p[0] + a11 * p[1] + a12 * p[2] + 2 * b1;
+		double rz = a02 * p[0] + a12 * p[1] + a22 * p[2] + 2 * b2;
+		double error = rx * p[0] + ry * p[1] + rz * p[2] + c;
+		if (weight <= 0) {
+			return 0;
+		}
+		return std::fabs(error) / weight;
+	}
+};
+
+class Collapse {
+public:
+	unsigned int vertex;
+	unsigned int target;
+	double error;
+};
+
+void subtract(const double* a, const double* b, double* out) {
+	out[0] = a[0] - b[0];
+	out[1] = a[1] - b[1];
+	out[2] = a[2] - b[2];
+}
+
+void cross(const double* a, const double* b, double* out) {
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+double dot(const double* a, const double* b) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+double normalize(double* v) {
+	double length = std::sqrt(dot(v, v));
+	if (length > 0) {
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+	return length;
+}
+
+void getTriangleNormal(const double* a, const double* b, const double* c, double* normal) {
+	double ab[3];
+	double ac[3];
+	subtract(b, a, ab);
+	subtract(c, a, ac);
+	cross(ab, ac, normal);
+}
+
+unsigned long long getEdgeKey(unsigned int a, unsigned int b) {
+	return ((unsigned long long)a << 32) | b;
+}
+
+// The bits of a position, so that vertices can be welded without allocating a key for each one
+struct PositionKey {
+	unsigned int bits[3];
+
+	bool operator==(const PositionKey& other) const {
+		return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+	}
+};
+
+class PositionHash {
+public:
+	size_t operator()(const PositionKey& position) const {
+		return (position.bits[0] * 73856093) ^ (position.bits[1] * 19349663) ^ (position.bits[2] * 83492791);
+	}
+};
+
+std::vector<unsigned int> MeshOptimizer::simplify(const unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError) {
+	std::vector<unsigned int> result(indices, indices + indexCount / 3 * 3);
+	*resultError = 0;
+	for (unsigned int index : result) {
+		if (index >= vertexCount) {
+			return result;
+		}
+	}
+
+	// Work in a unit cube so that errors are relative to the size of the mesh
+	std::vector<double> points(vertexCount * 3);
+	double minimum[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL };
+	double maximum[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+	for (size_t i = 0; i < vertexCount; i++) {
+		for (size_t j = 0; j < 3; j++) {
+			double value = positions[i * positionStride + j];
+			points[i * 3 + j] = value;
+			minimum[j] = std::min(minimum[j], value);
+			maximum[j] = std::max(maximum[j], value);
+		}
+	}
+	double extent = std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+	double scale = extent > 0 ? 1.0 / extent : 1.0;
+	for (size_t i = 0; i < vertexCount; i++) {
+		for (size_t j = 0; j < 3; j++) {
+			points[i * 3 + j] = (points[i * 3 + j] - minimum[j]) * scale;
+		}
+	}
+
+	// Vertices that share a position with another vertex are on an attribute seam, so the
+	// topology and the error are tracked for each position rather than for each vertex
+	std::unordered_map<PositionKey, unsigned int, PositionHash> positionIds;
+	positionIds.reserve(vertexCount);
+	std::vector<unsigned int> positionId(vertexCount);
+	std::vector<unsigned int> positionCount;
+	for (size_t i = 0; i < vertexCount; i++) {
+		PositionKey position;
+		std::memcpy(position.bits, positions + i * positionStride, sizeof(position.bits));
+		auto findPosition = positionIds.find(position);
+		if (findPosition == positionIds.end()) {
+			positionId[i] = positionCount.size();
+			positionIds[position] = positionId[i];
+			positionCount.push_back(1);
+		}
+		else {
+			positionId[i] = findPosition->second;
+			positionCount[findPosition->second]++;
+		}
+	}
+	size_t uniquePositionCount = positionCount.size();
+
+	// Vertices at each position
+	std::vector<unsigned int> positionOffsets(uniquePositionCount + 1, 0);
+	for (size_t i = 0; i < uniquePositionCount; i++) {
+		positionOffsets[i + 1] = positionOffsets[i] + positionCount[i];
+	}
+	std::vector<unsigned int> positionVertices(vertexCount);
+	std::vector<unsigned int> positionFill(positionOffsets.begin(), positionOffsets.end() - 1);
+	for (size_t i = 0; i < vertexCount; i++) {
+		positionVertices[positionFill[positionId[i]]++] = i;
+	}
+
+	// Edges without an opposite half-edge are on an open border, and edges whose opposite
+	// half-edge uses other vertices at the same positions are on an attribute seam
+	std::unordered_map<unsigned long long, unsigned int> halfEdges;
+	std::unordered_set<unsigned long long> vertexHalfEdges;
+	for (size_t i = 0; i < result.size(); i += 3) {
+		for (size_t j = 0; j < 3; j++) {
+			unsigned int a = result[i + j];
+			unsigned int b = result[i + (j + 1) % 3];
+			halfEdges[getEdgeKey(positionId[a], positionId[b])]++;
+			vertexHalfEdges.insert(getEdgeKey(a, b));
+		}
+	}
+	std::vector<VertexKind> kinds(uniquePositionCount, VertexKind::MANIFOLD);
+	std::vector<Quadric> quadrics(uniquePositionCount);
+	for (size_t i = 0; i < result.size(); i += 3) {
+		const double* p[3] = { &points[result[i] * 3], &points[result[i + 1] * 3], &points[result[i + 2] * 3] };
+		double normal[3];
+		getTriangleNormal(p[0], p[1], p[2], normal);
+		double area = normalize(normal);
+		double distance = -dot(normal, p[0]);
+		for (size_t j = 0; j < 3; j++) {
+			unsigned int a = result[i + j];
+			unsigned int b = result[i + (j + 1) % 3];
+			unsigned int positionA = positionId[a];
+			unsigned int positionB = positionId[b];
+			quadrics[positionA].addPlane(normal, distance, area);
+			if (positionA == positionB) {
+				continue;
+			}
+
+			double edgeWeight = 0;
+			if (halfEdges.find(getEdgeKey(positionB, positionA)) == halfEdges.end()) {
+				kinds[positionA] = VertexKind::BORDER;
+				kinds[positionB] = VertexKind::BORDER;
+				edgeWeight = BORDER_WEIGHT;
+			}
+			else if (vertexHalfEdges.find(getEdgeKey(b, a)) == vertexHalfEdges.end()) {
+				edgeWeight = SEAM_WEIGHT;
+			}
+			if (edgeWeight > 0) {
+				// Constrain the vertices to the plane through the edge perpendicular to the triangle
+				double edge[3];
+				subtract(&points[b * 3], &points[a * 3], edge);
+				double length = normalize(edge);
+				double edgeNormal[3];
+				cross(edge, normal, edgeNormal);
+				normalize(edgeNormal);
+				double edgeDistance = -dot(edgeNormal, &points[a * 3]);
+				quadrics[positionA].addPlane(edgeNormal, edgeDistance, length * length * edgeWeight);
+				quadrics[positionB].addPlane(edgeNormal, edgeDistance, length * length * edgeWeight);
+			}
+		}
+	}
+
+	double maxError = (double)targetError * targetError;
+	double error = 0;
+	std::vector<unsigned int> remap(vertexCount);
+	std::vector<bool> touched(uniquePositionCount);
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<Collapse> collapses;
+
+	// Every vertex at the position of `vertex` moves to a vertex at the position of `target` that
+	// it shares a triangle with, so seams collapse together and the attributes on each side stay
+	// continuous. Returns false if a vertex has no such neighbour, which would tear the seam.
+	auto findSeamTargets = [&](unsigned int vertex, unsigned int target, std::vector<unsigned int>* seamTargets) {
+		unsigned int position = positionId[vertex];
+		unsigned int targetPosition = positionId[target];
+		for (unsigned int i = positionOffsets[position]; i < positionOffsets[position + 1]; i++) {
+			unsigned int seamVertex = positionVertices[i];
+			unsigned int seamTarget = seamVertex == vertex ? target : vertexCount;
+			for (unsigned int k = adjacencyOffsets[seamVertex]; k < adjacencyOffsets[seamVertex + 1] && seamTarget == vertexCount; k++) {
+				const unsigned int* triangle = &result[adjacency[k] * 3];
+				for (size_t j = 0; j < 3; j++) {
+					if (positionId[triangle[j]] == targetPosition) {
+						seamTarget = triangle[j];
+						break;
+					}
+				}
+			}
+			if (seamTarget == vertexCount && adjacencyOffsets[seamVertex] < adjacencyOffsets[seamVertex + 1]) {
+				return false;
+			}
+			if (seamTargets != NULL) {
+				seamTargets->push_back(seamTarget);
+			}
+		}
+		return true;
+	};
+
+	std::vector<unsigned int> seamTargets;
+	while (result.size() > targetIndexCount) {
+		// Collapses change the edges, so the half-edges are found again for each pass
+		halfEdges.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t j = 0; j < 3; j++) {
+				halfEdges[getEdgeKey(positionId[result[i + j]], positionId[result[i + (j + 1) % 3]])]++;
+			}
+		}
+
+		// Triangles around each vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (unsigned int index : result) {
+			adjacencyOffsets[index + 1]++;
+		}
+		for (size_t i = 0; i < vertexCount; i++) {
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+		adjacency.resize(result.size());
+		std::vector<unsigned int> adjacencyCounts(vertexCount, 0);
+		for (size_t i = 0; i < result.size(); i++) {
+			unsigned int index = result[i];
+			adjacency[adjacencyOffsets[index] + adjacencyCounts[index]] = i / 3;
+			adjacencyCounts[index]++;
+		}
+
+		// Find the cheapest valid direction to collapse each edge in
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t j = 0; j < 3; j++) {
+				unsigned int a = result[i + j];
+				unsigned int b = result[i + (j + 1) % 3];
+				if (positionId[a] == positionId[b]) {
+					continue;
+				}
+				if (positionId[a] > positionId[b] && halfEdges.find(getEdgeKey(positionId[b], positionId[a])) != halfEdges.end()) {
+					// Interior edges are visited from both sides, only keep one of them
+					continue;
+				}
+				Collapse collapse;
+				collapse.error = HUGE_VAL;
+				unsigned int pair[2] = { a, b };
+				for (size_t k = 0; k < 2; k++) {
+					unsigned int vertex = pair[k];
+					unsigned int target = pair[1 - k];
+					unsigned int position = positionId[vertex];
+					unsigned int targetPosition = positionId[target];
+					bool borderEdge = halfEdges.find(getEdgeKey(targetPosition, position)) == halfEdges.end() || halfEdges.find(getEdgeKey(position, targetPosition)) == halfEdges.end();
+					if (kinds[position] == VertexKind::BORDER && (kinds[targetPosition] != VertexKind::BORDER || !borderEdge)) {
+						continue;
+					}
+					if (positionCount[position] > 1 && !findSeamTargets(vertex, target, NULL)) {
+						continue;
+					}
+					Quadric quadric = quadrics[position];
+					quadric.add(quadrics[targetPosition]);
+					double collapseError = quadric.getError(&points[target * 3]);
+					if (collapseError < collapse.error) {
+						collapse.vertex = vertex;
+						collapse.target = target;
+						collapse.error = collapseError;
+					}
+				}
+				if (collapse.error <= maxError) {
+					collapses.push_back(collapse);
+				}
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::stable_sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.error < b.error;
+		});
+
+		for (size_t i = 0; i < vertexCount; i++) {
+			remap[i] = i;
+		}
+		std::fill(touched.begin(), touched.end(), false);
+		size_t triangleBudget = (result.size() - targetIndexCount + 2) / 3;
+		size_t removedTriangles = 0;
+		for (const Collapse& collapse : collapses) {
+			unsigned int position = positionId[collapse.vertex];
+			unsigned int targetPosition = positionId[collapse.target];
+			if (touched[position] || touched[targetPosition]) {
+				continue;
+			}
+			seamTargets.clear();
+			findSeamTargets(collapse.vertex, collapse.target, &seamTargets);
+
+			// Moving the vertices must not flip any of the triangles that remain
+			bool flips = false;
+			size_t collapsedTriangles = 0;
+			for (unsigned int i = positionOffsets[position]; i < positionOffsets[position + 1] && !flips; i++) {
+				unsigned int vertex = positionVertices[i];
+				for (unsigned int k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1] && !flips; k++) {
+					const unsigned int* triangle = &result[adjacency[k] * 3];
+					if (positionId[triangle[0]] == targetPosition || positionId[triangle[1]] == targetPosition || positionId[triangle[2]] == targetPosition) {
+						collapsedTriangles++;
+						continue;
+					}
+					const double* before[3];
+					const double* after[3];
+					for (size_t j = 0; j < 3; j++) {
+						before[j] = &points[triangle[j] * 3];
+						after[j] = triangle[j] == vertex ? &points[collapse.target * 3] : before[j];
+					}
+					double normalBefore[3];
+					double normalAfter[3];
+					getTriangleNormal(before[0], before[1], before[2], normalBefore);
+					getTriangleNormal(after[0], after[1], after[2], normalAfter);
+					if (dot(normalBefore, normalAfter) <= 0) {
+						flips = true;
+					}
+				}
+			}
+			if (flips) {
+				continue;
+			}
+
+			for (unsigned int i = positionOffsets[position]; i < positionOffsets[position + 1]; i++) {
+				unsigned int vertex = positionVertices[i];
+				unsigned int seamTarget = seamTargets[i - positionOffsets[position]];
+				if (seamTarget != vertexCount) {
+					remap[vertex] = seamTarget;
+				}
+				for (unsigned int k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; k++) {
+					const unsigned int* triangle = &result[adjacency[k] * 3];
+					touched[positionId[triangle[0]]] = true;
+					touched[positionId[triangle[1]]] = true;
+					touched[positionId[triangle[2]]] = true;
+				}
+			}
+			quadrics[targetPosition].add(quadrics[position]);
+			error = std::max(error, collapse.error);
+			removedTriangles += collapsedTriangles;
+			if (removedTriangles >= triangleBudget) {
+				break;
+			}
+		}
+
+		// Drop the triangles that became degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			unsigned int a = remap[result[i]];
+			unsigned int b = remap[result[i + 1]];
+			unsigned int c = remap[result[i + 2]];
+			if (positionId[a] != positionId[b] && positionId[b] != positionId[c] && positionId[a] != positionId[c]) {
+				result[write] = a;
+				result[write + 1] = b;
+				result[write + 2] = c;
+				write += 3;
+			}
+		}
+		if (write == result.size()) {
+			break;
+		}
+		result.resize(write);
+	}
+	*resultError = (float)std::sqrt(error);
+	return result;
+}
@@ -0,0 +1,222 @@
+#include "TextureProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+// Entries in the table that encodes linear values back to sRGB bytes
+const int LINEAR_TO_SRGB_TABLE_SIZE = 4096;
+
+struct Weight {
+	int index;
+	float weight;
+};
+
+static int nearestPowerOfTwo(int value) {
+	int lower = 1;
+	while (lower * 2 <= value) {
+		lower *= 2;
+	}
+	return value - lower < lower * 2 - value ? lower : lower * 2;
+}
+
+std::pair<int, int> TextureProcessor::getTargetSize(int width, int height, int maxSize, bool powerOfTwo) {
+	int targetWidth = width;
+	int targetHeight = height;
+	int largest = std::max(width, height);
+	if (maxSize > 0 && largest > maxSize) {
+		double scale = (double)maxSize / largest;
+		targetWidth = std::max(1, (int)std::lround(width * scale));
+		targetHeight = std::max(1, (int)std::lround(height * scale));
+	}
+	if (powerOfTwo) {
+		targetWidth = nearestPowerOfTwo(targetWidth);
+		targetHeight = nearestPowerOfTwo(targetHeight);
+		while (maxSize > 0 && targetWidth > maxSize) {
+			targetWidth /= 2;
+		}
+		while (maxSize > 0 && targetHeight > maxSize) {
+			targetHeight /= 2;
+		}
+	}
+	return std::pair<int, int>(targetWidth, targetHeight);
+}
+
+/**
+ * Gets the source samples that contribute to each target sample along one axis, with weights that
+ * sum to one.
+ */
+static std::vector<std::vector<Weight>> getWeights(int sourceSize, int targetSize) {
+	std::vector<std::vector<Weight>> weights(targetSize);
+	double scale = (double)sourceSize / targetSize;
+	for (int i = 0; i < targetSize; i++) {
+		std::vector<Weight>& sampleWeights = weights[i];
+		if (scale > 1) {
+			// Box filter over the source samples the target sample covers
+			double start = i * scale;
+			double end = (i + 1) * scale;
+			for (int source = (int)start; source < sourceSize && source < end; source++) {
+				double coverage = std::min(end, source + 1.0) - std::max(start, (double)source);
+				if (coverage > 0) {
+					sampleWeights.push_back({ source, (float)coverage });
+				}
+			}
+		}
+		else {
+			double center = (i + 0.5) * scale - 0.5;
+			int source = (int)std::floor(center);
+			float t = (float)(center - source);
+			sampleWeights.push_back({ std::max(0, source), 1 - t });
+			sampleWeights.push_back({ std::min(sourceSize - 1, source + 1), t });
+		}
+		float total = 0;
+		for (const Weight& weight : sampleWeights) {
+			total += weight.weight;
+		}
+		for (Weight& weight : sampleWeights) {
+			weight.weight /= total;
+		}
+	}
+	return weights;
+}
+
+ImageCodec::Pixels TextureProcessor::resize(const ImageCodec::Pixels& pixels, int width, int height, bool srgb) {
+	float toLinear[256];
+	for (int i = 0; i < 256; i++) {
+		float value = i / 255.0f;
+		if (srgb) {
+			value = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+		toLinear[i] = value;
+	}
+	std::vector<unsigned char> toEncoded(LINEAR_TO_SRGB_TABLE_SIZE + 1);
+	for (int i = 0; i <= LINEAR_TO_SRGB_TABLE_SIZE; i++) {
+		float value = (float)i / LINEAR_TO_SRGB_TABLE_SIZE;
+		if (srgb) {
+			value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1 / 2.4f) - 0.055f;
+		}
+		toEncoded[i] = (unsigned char)std::lround(std::min(1.0f, std::max(0.0f, value)) * 255);
+	}
+
+	std::vector<std::vector<Weight>> columnWeights = getWeights(pixels.width, width);
+	std::vector<std::vector<Weight>> rowWeights = getWeights(pixels.height, height);
+	// Each source row is resampled horizontally once and added to every target row it contributes to
+	std::vector<std::vector<Weight>> sourceRowTargets(pixels.height);
+	for (int y = 0; y < height; y++) {
+		for (const Weight& weight : rowWeights[y]) {
+			sourceRowTargets[weight.index].push_back({ y, weight.weight });
+		}
+	}
+
+	std::vector<float> accumulated((size_t)width * height * 4, 0.0f);
+	std::vector<float> row((size_t)width * 4);
+	for (int sourceY = 0; sourceY < pixels.height; sourceY++) {
+		if (sourceRowTargets[sourceY].empty()) {
+			continue;
+		}
+		const unsigned char* sourceRow = &pixels.rgba[(size_t)sourceY * pixels.width * 4];
+		for (int x = 0; x < width; x++) {
+			float sum[4] = { 0, 0, 0, 0 };
+			for (const Weight& weight : columnWeights[x]) {
+				const unsigned char* pixel = sourceRow + (size_t)weight.index * 4;
+				// Only color is weighted by alpha, data textures may store something else in it
+				float colorWeight = srgb ? weight.weight * pixel[3] / 255.0f : weight.weight;
+				sum[0] += toLinear[pixel[0]] * colorWeight;
+				sum[1] += toLinear[pixel[1]] * colorWeight;
+				sum[2] += toLinear[pixel[2]] * colorWeight;
+				sum[3] += pixel[3] / 255.0f * weight.weight;
+			}
+			std::copy(sum, sum + 4, &row[(size_t)x * 4]);
+		}
+		for (const Weight& target : sourceRowTargets[sourceY]) {
+			float* out = &accumulated[(size_t)target.index * width * 4];
+			for (size_t i = 0; i < row.size(); i++) {
+				out[i] += row[i] * target.weight;
+			}
+		}
+	}
+
+	ImageCodec::Pixels resized;
+	resized.width = width;
+	resized.height = height;
+	resized.rgba.resize((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		const float* sum = &accumulated[i * 4];
+		unsigned char* pixel = &resized.rgba[i * 4];
+		float alpha = std::min(1.0f, std::max(0.0f, sum[3]));
+		for (int c = 0; c < 3; c++) {
+			float value = sum[c];
+			if (srgb) {
+				value = alpha > 0 ? value / alpha : 0;
+			}
+			value = std::min(1.0f, std::max(0.0f, value));
+			pixel[c] = toEncoded[(size_t)std::lround(value * LINEAR_TO_SRGB_TABLE_SIZE)];
+		}
+		pixel[3] = (unsigned char)std::lround(alpha * 255);
+	}
+	return resized;
+}
+
+std::vector<std::pair<int, int>> TextureProcessor::packAtlases(const std::vector<std::pair<int, int>>& sizes, int atlasSize, int padding, std::vector<TextureProcessor::AtlasPlacement>* placements) {
+	placements->assign(sizes.size(), AtlasPlacement());
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+		if (sizes[a].second != sizes[b].second) {
+			return sizes[a].second > sizes[b].second;
+		}
+		return sizes[a].first > sizes[b].first;
+	});
+
+	std::vector<std::pair<int, int>> atlasSizes;
+	int shelfX = 0;
+	int shelfY = 0;
+	int shelfHeight = 0;
+	for (size_t index : order) {
+		int width = sizes[index].first + padding * 2;
+		int height = sizes[index].second + padding * 2;
+		if (width > atlasSize || height > atlasSize) {
+			continue;
+		}
+		if (shelfX + width > atlasSize) {
+			shelfY += shelfHeight;
+			shelfX = 0;
+			shelfHeight = 0;
+		}
+		if (atlasSizes.empty() || shelfY + height > atlasSize) {
+			atlasSizes.push_back(std::pair<int, int>(0, 0));
+			shelfX = 0;
+			shelfY = 0;
+			shelfHeight = 0;
+		}
+		AtlasPlacement& placement = (*placements)[index];
+		placement.atlas = (int)atlasSizes.size() - 1;
+		placement.x = shelfX + padding;
+		placement.y = shelfY + padding;
+		shelfX += width;
+		shelfHeight = std::max(shelfHeight, height);
+		std::pair<int, int>& atlasSizeUsed = atlasSizes.back();
+		atlasSizeUsed.first = std::max(atlasSizeUsed.first, shelfX);
+		atlasSizeUsed.second = std::max(atlasSizeUsed.second, shelfY + shelfHeight);
+	}
+	return atlasSizes;
+}
+
+void TextureProcessor::blit(const ImageCodec::Pixels& image, ImageCodec::Pixels* atlas, int x, int y, int padding) {
+	for (int row = -padding; row < image.height + padding; row++) {
+		int targetY = y + row;
+		if (targetY < 0 || targetY >= atlas->height) {
+			continue;
+		}
+		int sourceY = std::min(image.height - 1, std::max(0, row));
+		for (int column = -padding; column < image.width + padding; column++) {
+			int targetX = x + column;
+			if (targetX < 0 || targetX >= atlas->width) {
+				continue;
+			}
+			int sourceX = std::min(image.width - 1, std::max(0, column));
+			std::memcpy(&atlas->rgba[((size_t)targetY * atlas->width + targetX) * 4], &image.rgba[((size_t)sourceY * image.width + sourceX) * 4], 4);
+		}
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Base64.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class Base64Test : public ::testing::Test {
+  };
+}
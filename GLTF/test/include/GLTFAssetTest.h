@@ -0,0 +1,7 @@
+#pragma once
+
+#include "gtest/gtest.h"
+
+namespace {
+  class GLTFAssetTest : public ::testing::Test {};
+}
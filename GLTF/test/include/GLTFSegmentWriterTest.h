@@ -0,0 +1,10 @@
+#pragma once
+
+#include "GLTFSegmentWriter.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class GLTFSegmentWriterTest : public ::testing::Test {
+  };
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "GLTFThreadPool.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class GLTFThreadPoolTest : public ::testing::Test {
+  };
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ImageCodec.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class ImageCodecTest : public ::testing::Test {
+  };
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "MeshOptimizer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class MeshOptimizerTest : public ::testing::Test {
+  };
+}
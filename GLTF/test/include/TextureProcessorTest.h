@@ -0,0 +1,10 @@
+#pragma once
+
+#include "TextureProcessor.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+  class TextureProcessorTest : public ::testing::Test {
+  };
+}
@@ -0,0 +1,25 @@
+#include "Base64Test.h"
+
+#include <string>
+#include <vector>
+
+TEST_F(Base64Test, Encode_Padding) {
+  EXPECT_EQ(Base64::encode((const unsigned char*)"", 0), "");
+  EXPECT_EQ(Base64::encode((const unsigned char*)"f", 1), "Zg==");
+  EXPECT_EQ(Base64::encode((const unsigned char*)"fo", 2), "Zm8=");
+  EXPECT_EQ(Base64::encode((const unsigned char*)"foo", 3), "Zm9v");
+  EXPECT_EQ(Base64::encode((const unsigned char*)"foobar", 6), "Zm9vYmFy");
+}
+
+TEST_F(Base64Test, Encode_RoundTripsAllLengths) {
+  // Long enough to cover the vectorized loops and every length of scalar tail
+  for (size_t length = 0; length < 200; length++) {
+    std::vector<unsigned char> data(length);
+    for (size_t i = 0; i < length; i++) {
+      data[i] = (unsigned char)(i * 97 + length);
+    }
+    std::string base64 = Base64::encode(data.data(), length);
+    ASSERT_EQ(base64.length(), Base64::encodedLength(length));
+    ASSERT_EQ(Base64::decode(base64), std::string(data.begin(), data.end()));
+  }
+}
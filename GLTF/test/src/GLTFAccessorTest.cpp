@@ -66,3 +66,81 @@ TEST(GLTFAccessorTest, CreateOnBuffer) {
     EXPECT_EQ(component[2], (i + 4) * 3 + 3);
   }
 }
+
+TEST(GLTFAccessorTest, NormalizedBytesMinMax) {
+  signed char normals[6] = {-127, 0, 127, 64, -64, 0};
+  GLTF::Accessor* accessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3,
+    GLTF::Constants::WebGL::BYTE,
+    (unsigned char*)normals, 2,
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  accessor->normalized = true;
+
+  float* min = accessor->min;
+  ASSERT_TRUE(min != NULL);
+  EXPECT_EQ(min[0], -127.0);
+  EXPECT_EQ(min[1], -64.0);
+  EXPECT_EQ(min[2], 0.0);
+
+  float* max = accessor->max;
+  ASSERT_TRUE(max != NULL);
+  EXPECT_EQ(max[0], 64.0);
+  EXPECT_EQ(max[1], 0.0);
+  EXPECT_EQ(max[2], 127.0);
+
+  float component[3] = {-1.0, -128.0, 5.0};
+  accessor->writeComponentAtIndex(1, component);
+  accessor->getComponentAtIndex(1, component);
+  EXPECT_EQ(component[0], -1.0);
+  EXPECT_EQ(component[1], -128.0);
+  EXPECT_EQ(component[2], 5.0);
+  delete accessor;
+}
+
+TEST(GLTFAccessorTest, Equals) {
+  float points[6] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  float otherPoints[6] = {1.0, 2.0, 3.0, 4.0, 5.0, 7.0};
+  GLTF::Accessor* accessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3,
+    GLTF::Constants::WebGL::FLOAT,
+    (unsigned char*)points, 2,
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  GLTF::Accessor* same = new GLTF::Accessor(GLTF::Accessor::Type::VEC3,
+    GLTF::Constants::WebGL::FLOAT,
+    (unsigned char*)points, 2,
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  GLTF::Accessor* different = new GLTF::Accessor(GLTF::Accessor::Type::VEC3,
+    GLTF::Constants::WebGL::FLOAT,
+    (unsigned char*)otherPoints, 2,
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  GLTF::Accessor* differentType = new GLTF::Accessor(GLTF::Accessor::Type::VEC2,
+    GLTF::Constants::WebGL::FLOAT,
+    (unsigned char*)points, 3,
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  EXPECT_TRUE(accessor->equals(same));
+  EXPECT_FALSE(accessor->equals(different));
+  EXPECT_FALSE(accessor->equals(differentType));
+  delete accessor;
+  delete same;
+  delete different;
+  delete differentType;
+}
+
+TEST(GLTFAccessorTest, AdoptsVectorData) {
+  std::vector<float> points = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  const float* data = points.data();
+  GLTF::Accessor* accessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3,
+    GLTF::Constants::WebGL::FLOAT,
+    std::move(points),
+    GLTF::Constants::WebGL::ARRAY_BUFFER
+  );
+  EXPECT_EQ(accessor->count, 2);
+  EXPECT_EQ((const float*)accessor->bufferView->buffer->data, data);
+  EXPECT_EQ(accessor->bufferView->byteLength, 24);
+  EXPECT_EQ(accessor->bufferView->target, GLTF::Constants::WebGL::ARRAY_BUFFER);
+  EXPECT_EQ(accessor->max[2], 6.0);
+  delete accessor;
+}
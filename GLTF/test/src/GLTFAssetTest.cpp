@@ -0,0 +1,894 @@
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+#include "GLTFAsset.h"
+#include "GLTFAssetTest.h"
+#include "GLTFInstancingExtension.h"
+#include "GLTFJSONWriter.h"
+#include "GLTFLodExtension.h"
+#include "ImageCodec.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+GLTF::Accessor* createAttribute(GLTF::Accessor::Type type, std::vector<float> values) {
+  return new GLTF::Accessor(type, GLTF::Constants::WebGL::FLOAT, std::move(values), GLTF::Constants::WebGL::ARRAY_BUFFER);
+}
+
+GLTF::Accessor* createIndices(std::vector<unsigned short> indices) {
+  return new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_SHORT, std::move(indices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+}
+
+// A triangle with its own accessors, moved along x by offset
+GLTF::Primitive* createTriangle(float offset, GLTF::Material* material) {
+  GLTF::Primitive* primitive = new GLTF::Primitive();
+  primitive->mode = GLTF::Primitive::Mode::TRIANGLES;
+  primitive->attributes["POSITION"] = createAttribute(GLTF::Accessor::Type::VEC3, { offset, 0, 0, offset + 1, 0, 0, offset, 1, 0 });
+  primitive->indices = createIndices({ 0, 1, 2 });
+  primitive->material = material;
+  return primitive;
+}
+
+GLTF::Node* addMeshNode(GLTF::Asset* asset, GLTF::Primitive* primitive) {
+  GLTF::Node* node = new GLTF::Node();
+  node->mesh = new GLTF::Mesh();
+  node->mesh->primitives.push_back(primitive);
+  asset->getDefaultScene()->nodes.push_back(node);
+  return node;
+}
+
+TEST_F(GLTFAssetTest, GenerateLevelsOfDetail_SimplifiesSeamedMeshes) {
+  // A flat grid where each column of quads is its own texture island, so every vertex inside the grid is on a seam
+  unsigned short size = 16;
+  std::vector<float> positions;
+  std::vector<float> texCoords;
+  std::vector<unsigned short> indices;
+  for (unsigned short x = 0; x < size; x++) {
+    unsigned short first = positions.size() / 3;
+    for (unsigned short y = 0; y <= size; y++) {
+      positions.insert(positions.end(), { (float)x, (float)y, 0, (float)x + 1, (float)y, 0 });
+      texCoords.insert(texCoords.end(), { 0, (float)y / size, 1, (float)y / size });
+    }
+    for (unsigned short y = 0; y < size; y++) {
+      unsigned short a = first + y * 2;
+      indices.insert(indices.end(), { a, (unsigned short)(a + 1), (unsigned short)(a + 2), (unsigned short)(a + 1), (unsigned short)(a + 3), (unsigned short)(a + 2) });
+    }
+  }
+  GLTF::Primitive* primitive = new GLTF::Primitive();
+  primitive->mode = GLTF::Primitive::Mode::TRIANGLES;
+  primitive->attributes["POSITION"] = createAttribute(GLTF::Accessor::Type::VEC3, positions);
+  primitive->attributes["TEXCOORD_0"] = createAttribute(GLTF::Accessor::Type::VEC2, texCoords);
+  primitive->indices = createIndices(indices);
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  GLTF::Options options;
+  options.lodLevels = 2;
+  asset->generateLevelsOfDetail(&options);
+
+  auto findLod = node->extensions.find("MSFT_lod");
+  ASSERT_TRUE(findLod != node->extensions.end());
+  GLTF::LodExtension* lodExtension = (GLTF::LodExtension*)findLod->second;
+  ASSERT_EQ(lodExtension->nodes.size(), 2);
+  int previousCount = primitive->indices->count;
+  for (GLTF::Node* lodNode : lodExtension->nodes) {
+    ASSERT_EQ(lodNode->mesh->primitives.size(), 1);
+    GLTF::Primitive* lodPrimitive = lodNode->mesh->primitives[0];
+    EXPECT_EQ(lodPrimitive->attributes["TEXCOORD_0"], primitive->attributes["TEXCOORD_0"]);
+    EXPECT_LT(lodPrimitive->indices->count, previousCount);
+    previousCount = lodPrimitive->indices->count;
+  }
+
+  rapidjson::StringBuffer s;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  GLTF::JSONWriterAdapter<rapidjson::Writer<rapidjson::StringBuffer>, rapidjson::StringBuffer> jsonWriter(&writer, &s);
+  jsonWriter.StartObject();
+  asset->writeJSON(&jsonWriter, &options);
+  jsonWriter.EndObject();
+  std::string json = s.GetString();
+  std::string ids = "\"MSFT_lod\":{\"ids\":[" + std::to_string(lodExtension->nodes[0]->id) + "," + std::to_string(lodExtension->nodes[1]->id) + "]}";
+  EXPECT_NE(json.find(ids), std::string::npos);
+  EXPECT_NE(json.find("\"MSFT_screencoverage\":["), std::string::npos);
+  EXPECT_NE(json.find("\"extensionsUsed\":[\"MSFT_lod\"]"), std::string::npos);
+  EXPECT_NE(lodExtension->nodes[0]->id, lodExtension->nodes[1]->id);
+  EXPECT_NE(lodExtension->nodes[0]->id, node->id);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, QuantizeAttributes_ChoosesComponentTypesPerSemantic) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  std::vector<float> positions = { 1, 1, 1, 3, 1, 1, 1, 5, 1 };
+  primitive->attributes["POSITION"] = createAttribute(GLTF::Accessor::Type::VEC3, positions);
+  primitive->attributes["NORMAL"] = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 0, 1, 0, 0, 1, 0, 0, -1 });
+  primitive->attributes["TANGENT"] = createAttribute(GLTF::Accessor::Type::VEC4, { 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, -1 });
+  primitive->attributes["TEXCOORD_0"] = createAttribute(GLTF::Accessor::Type::VEC2, { 0, 0, 1, 0, 0, 1 });
+  primitive->attributes["COLOR_0"] = createAttribute(GLTF::Accessor::Type::VEC4, { 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 1, 1 });
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  GLTF::Mesh* mesh = node->mesh;
+  GLTF::Options options;
+  asset->quantizeAttributes(&options);
+
+  std::map<std::string, GLTF::Constants::WebGL> componentTypes = {
+    { "POSITION", GLTF::Constants::WebGL::SHORT },
+    { "NORMAL", GLTF::Constants::WebGL::BYTE },
+    { "TANGENT", GLTF::Constants::WebGL::BYTE },
+    { "TEXCOORD_0", GLTF::Constants::WebGL::UNSIGNED_SHORT },
+    { "COLOR_0", GLTF::Constants::WebGL::UNSIGNED_BYTE }
+  };
+  for (const auto& componentType : componentTypes) {
+    GLTF::Accessor* accessor = primitive->attributes[componentType.first];
+    EXPECT_EQ(accessor->componentType, componentType.second) << componentType.first;
+    EXPECT_TRUE(accessor->normalized) << componentType.first;
+  }
+  EXPECT_EQ(asset->extensionsRequired.count("KHR_mesh_quantization"), 1);
+
+  // Bounds are in the quantized domain, positions use 14 bits around the center of the mesh
+  GLTF::Accessor* position = primitive->attributes["POSITION"];
+  EXPECT_EQ(std::vector<float>(position->min, position->min + 3), std::vector<float>({ -4096, -8191, 0 }));
+  EXPECT_EQ(std::vector<float>(position->max, position->max + 3), std::vector<float>({ 4096, 8191, 0 }));
+  GLTF::Accessor* normal = primitive->attributes["NORMAL"];
+  EXPECT_EQ(normal->min[2], -127);
+  EXPECT_EQ(normal->max[2], 127);
+  GLTF::Accessor* tangent = primitive->attributes["TANGENT"];
+  EXPECT_EQ(tangent->min[3], -127);
+  EXPECT_EQ(tangent->max[3], 127);
+  GLTF::Accessor* texCoord = primitive->attributes["TEXCOORD_0"];
+  EXPECT_EQ(texCoord->max[0], 65535);
+  EXPECT_EQ(texCoord->min[0], 0);
+  GLTF::Accessor* color = primitive->attributes["COLOR_0"];
+  EXPECT_EQ(color->max[0], 255);
+  EXPECT_EQ(color->min[0], 0);
+
+  // The mesh moves to a child node whose transform undoes the quantization
+  EXPECT_EQ(node->mesh, (GLTF::Mesh*)NULL);
+  ASSERT_EQ(node->children.size(), 1);
+  GLTF::Node* meshNode = node->children[0];
+  EXPECT_EQ(meshNode->mesh, mesh);
+  ASSERT_EQ(meshNode->transform->type, GLTF::Node::Transform::TRS);
+  GLTF::Node::TransformTRS* transform = (GLTF::Node::TransformTRS*)meshNode->transform;
+  EXPECT_EQ(std::vector<float>(transform->translation, transform->translation + 3), std::vector<float>({ 2, 3, 1 }));
+  EXPECT_EQ(std::vector<float>(transform->rotation, transform->rotation + 4), std::vector<float>({ 0, 0, 0, 1 }));
+  for (size_t i = 0; i < 3; i++) {
+    float component[3];
+    position->getComponentAtIndex(i, component);
+    for (size_t j = 0; j < 3; j++) {
+      float decoded = component[j] / 32767.0f * transform->scale[j] + transform->translation[j];
+      EXPECT_NEAR(decoded, positions[i * 3 + j], 2.0f / 8191);
+    }
+  }
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, QuantizeAttributes_SharesTransformAcrossLevelsOfDetail) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  // A lower level of detail keeps the positions of its level but also has geometry further away
+  GLTF::Primitive* lodPrimitive = new GLTF::Primitive();
+  lodPrimitive->mode = GLTF::Primitive::Mode::TRIANGLES;
+  lodPrimitive->attributes["POSITION"] = primitive->attributes["POSITION"];
+  lodPrimitive->indices = createIndices({ 0, 1, 2 });
+  GLTF::Node* lodNode = addMeshNode(asset, lodPrimitive);
+  lodNode->mesh->primitives.push_back(createTriangle(9, primitive->material));
+  GLTF::Options options;
+  asset->quantizeAttributes(&options);
+
+  EXPECT_EQ(primitive->attributes["POSITION"], lodPrimitive->attributes["POSITION"]);
+  ASSERT_EQ(node->children.size(), 1);
+  ASSERT_EQ(lodNode->children.size(), 1);
+  GLTF::Node::TransformTRS* transform = (GLTF::Node::TransformTRS*)node->children[0]->transform;
+  GLTF::Node::TransformTRS* lodTransform = (GLTF::Node::TransformTRS*)lodNode->children[0]->transform;
+  EXPECT_EQ(std::vector<float>(transform->translation, transform->translation + 3), std::vector<float>({ 5, 0.5, 0 }));
+  EXPECT_EQ(std::vector<float>(transform->translation, transform->translation + 3), std::vector<float>(lodTransform->translation, lodTransform->translation + 3));
+  EXPECT_EQ(std::vector<float>(transform->scale, transform->scale + 3), std::vector<float>(lodTransform->scale, lodTransform->scale + 3));
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, RemoveDuplicateMeshes_SharesIdenticalMeshes) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Material* material = new GLTF::MaterialCommon();
+  GLTF::Node* nodeOne = addMeshNode(asset, createTriangle(0, material));
+  GLTF::Node* nodeTwo = addMeshNode(asset, createTriangle(0, material));
+  GLTF::Node* nodeThree = addMeshNode(asset, createTriangle(5, material));
+  asset->removeDuplicateMeshes();
+
+  EXPECT_EQ(nodeOne->mesh, nodeTwo->mesh);
+  EXPECT_NE(nodeOne->mesh, nodeThree->mesh);
+  EXPECT_EQ(asset->getAllMeshes().size(), 2);
+  EXPECT_EQ(asset->getAllPrimitives().size(), 2);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, RemoveDuplicateMeshes_SharesGeometryAcrossMaterials) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Node* nodeOne = addMeshNode(asset, createTriangle(0, new GLTF::MaterialCommon()));
+  GLTF::Node* nodeTwo = addMeshNode(asset, createTriangle(0, new GLTF::MaterialCommon()));
+  asset->removeDuplicateMeshes();
+
+  ASSERT_NE(nodeOne->mesh, nodeTwo->mesh);
+  GLTF::Primitive* primitiveOne = nodeOne->mesh->primitives[0];
+  GLTF::Primitive* primitiveTwo = nodeTwo->mesh->primitives[0];
+  EXPECT_NE(primitiveOne->material, primitiveTwo->material);
+  EXPECT_EQ(primitiveOne->indices, primitiveTwo->indices);
+  EXPECT_EQ(primitiveOne->attributes["POSITION"], primitiveTwo->attributes["POSITION"]);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, RemoveDuplicateMeshes_KeepsPrimitivesWithExtensions) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Material* material = new GLTF::MaterialCommon();
+  GLTF::Primitive* primitiveOne = createTriangle(0, material);
+  GLTF::Primitive* primitiveTwo = createTriangle(0, material);
+  // The same number of extensions, but each with different compressed data
+  primitiveOne->extensions["KHR_draco_mesh_compression"] = new GLTF::Extension();
+  primitiveTwo->extensions["KHR_draco_mesh_compression"] = new GLTF::Extension();
+  GLTF::Node* nodeOne = addMeshNode(asset, primitiveOne);
+  GLTF::Node* nodeTwo = addMeshNode(asset, primitiveTwo);
+  GLTF::Node* nodeThree = addMeshNode(asset, createTriangle(0, material));
+  asset->removeDuplicateMeshes();
+
+  EXPECT_NE(nodeOne->mesh, nodeTwo->mesh);
+  EXPECT_NE(nodeOne->mesh, nodeThree->mesh);
+  EXPECT_EQ(nodeOne->mesh->primitives[0], primitiveOne);
+  EXPECT_EQ(nodeTwo->mesh->primitives[0], primitiveTwo);
+  EXPECT_NE(primitiveOne->attributes["POSITION"], primitiveTwo->attributes["POSITION"]);
+  EXPECT_EQ(asset->getAllPrimitives().size(), 3);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, RemoveDuplicateAccessors_SharesIdenticalData) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Node* nodeOne = addMeshNode(asset, createTriangle(0, new GLTF::MaterialCommon()));
+  GLTF::Node* nodeTwo = addMeshNode(asset, createTriangle(0, new GLTF::MaterialCommon()));
+  GLTF::Node* nodeThree = addMeshNode(asset, createTriangle(5, new GLTF::MaterialCommon()));
+  GLTF::Animation* animation = new GLTF::Animation();
+  for (float value : { 1.0f, 2.0f }) {
+    GLTF::Animation::Channel* channel = new GLTF::Animation::Channel();
+    channel->sampler = new GLTF::Animation::Sampler();
+    channel->sampler->input = createAttribute(GLTF::Accessor::Type::SCALAR, { 0, 1 });
+    channel->sampler->output = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 0, 0, value, value, value });
+    channel->target = new GLTF::Animation::Channel::Target();
+    channel->target->node = nodeOne;
+    channel->target->path = GLTF::Animation::Path::TRANSLATION;
+    animation->channels.push_back(channel);
+  }
+  asset->animations.push_back(animation);
+  size_t accessorCount = asset->getAllAccessors().size();
+  asset->removeDuplicateAccessors();
+
+  GLTF::Primitive* primitiveOne = nodeOne->mesh->primitives[0];
+  GLTF::Primitive* primitiveTwo = nodeTwo->mesh->primitives[0];
+  GLTF::Primitive* primitiveThree = nodeThree->mesh->primitives[0];
+  EXPECT_EQ(primitiveOne->attributes["POSITION"], primitiveTwo->attributes["POSITION"]);
+  EXPECT_NE(primitiveOne->attributes["POSITION"], primitiveThree->attributes["POSITION"]);
+  EXPECT_EQ(primitiveOne->indices, primitiveTwo->indices);
+  EXPECT_EQ(primitiveOne->indices, primitiveThree->indices);
+  EXPECT_EQ(animation->channels[0]->sampler->input, animation->channels[1]->sampler->input);
+  EXPECT_NE(animation->channels[0]->sampler->output, animation->channels[1]->sampler->output);
+  // One position, two indices and one animation input are removed
+  EXPECT_EQ(asset->getAllAccessors().size(), accessorCount - 4);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, InstanceMeshes_MergesSiblingsSharingAMesh) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Mesh* mesh = new GLTF::Mesh();
+  mesh->primitives.push_back(createTriangle(0, new GLTF::MaterialCommon()));
+  std::vector<GLTF::Node*>& sceneNodes = asset->getDefaultScene()->nodes;
+  for (int i = 0; i < 4; i++) {
+    GLTF::Node* node = new GLTF::Node();
+    node->mesh = mesh;
+    GLTF::Node::TransformTRS* transform = new GLTF::Node::TransformTRS();
+    for (int j = 0; j < 3; j++) {
+      transform->translation[j] = j == 0 ? (float)i : 0;
+      transform->rotation[j] = 0;
+      transform->scale[j] = 1;
+    }
+    transform->rotation[3] = 1;
+    node->transform = transform;
+    sceneNodes.push_back(node);
+  }
+  // A scaled matrix decomposes into an instance scale
+  GLTF::Node::TransformMatrix* matrix = new GLTF::Node::TransformMatrix();
+  matrix->matrix[0] = 2;
+  matrix->matrix[12] = 2;
+  sceneNodes[2]->transform = matrix;
+  // Animated nodes have to stay separate
+  GLTF::Node* animatedNode = sceneNodes[3];
+  GLTF::Animation* animation = new GLTF::Animation();
+  GLTF::Animation::Channel* channel = new GLTF::Animation::Channel();
+  channel->sampler = new GLTF::Animation::Sampler();
+  channel->sampler->input = createAttribute(GLTF::Accessor::Type::SCALAR, { 0, 1 });
+  channel->sampler->output = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 0, 0, 1, 1, 1 });
+  channel->target = new GLTF::Animation::Channel::Target();
+  channel->target->node = animatedNode;
+  channel->target->path = GLTF::Animation::Path::TRANSLATION;
+  animation->channels.push_back(channel);
+  asset->animations.push_back(animation);
+  asset->instanceMeshes();
+
+  ASSERT_EQ(sceneNodes.size(), 2);
+  EXPECT_EQ(sceneNodes[1], animatedNode);
+  GLTF::Node* instancedNode = sceneNodes[0];
+  EXPECT_EQ(instancedNode->mesh, mesh);
+  EXPECT_TRUE(instancedNode->transform == NULL);
+  ASSERT_EQ(instancedNode->extensions.count("EXT_mesh_gpu_instancing"), 1);
+  GLTF::InstancingExtension* extension = (GLTF::InstancingExtension*)instancedNode->extensions["EXT_mesh_gpu_instancing"];
+  EXPECT_EQ(extension->attributes.count("ROTATION"), 0);
+  ASSERT_EQ(extension->attributes.count("TRANSLATION"), 1);
+  ASSERT_EQ(extension->attributes.count("SCALE"), 1);
+  GLTF::Accessor* translations = extension->attributes["TRANSLATION"];
+  GLTF::Accessor* scales = extension->attributes["SCALE"];
+  ASSERT_EQ(translations->count, 3);
+  ASSERT_EQ(scales->count, 3);
+  float translation[3];
+  float scale[3];
+  for (int i = 0; i < 3; i++) {
+    translations->getComponentAtIndex(i, translation);
+    scales->getComponentAtIndex(i, scale);
+    EXPECT_FLOAT_EQ(translation[0], (float)i);
+    EXPECT_FLOAT_EQ(scale[0], i == 2 ? 2.0f : 1.0f);
+    EXPECT_FLOAT_EQ(scale[1], 1.0f);
+  }
+  EXPECT_EQ(asset->extensionsRequired.count("EXT_mesh_gpu_instancing"), 1);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, QuantizeAttributes_DequantizesInstances) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  GLTF::InstancingExtension* extension = new GLTF::InstancingExtension();
+  extension->attributes["TRANSLATION"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::vector<float>({ 0, 0, 0, 10, 0, 0 }), (GLTF::Constants::WebGL)-1);
+  extension->attributes["SCALE"] = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::vector<float>({ 1, 1, 1, 2, 2, 2 }), (GLTF::Constants::WebGL)-1);
+  node->extensions["EXT_mesh_gpu_instancing"] = extension;
+  GLTF::Options options;
+  asset->quantizeAttributes(&options);
+
+  // Instance transforms apply before the node, so the dequantization goes into each instance
+  EXPECT_NE(node->mesh, (GLTF::Mesh*)NULL);
+  EXPECT_EQ(node->children.size(), 0);
+  EXPECT_EQ(extension->attributes.count("ROTATION"), 0);
+  float dequantizationScale = 0.5f * 32767.0f / 8191;
+  float translation[3];
+  float scale[3];
+  extension->attributes["TRANSLATION"]->getComponentAtIndex(0, translation);
+  extension->attributes["SCALE"]->getComponentAtIndex(0, scale);
+  EXPECT_FLOAT_EQ(translation[0], 0.5f);
+  EXPECT_FLOAT_EQ(translation[1], 0.5f);
+  EXPECT_FLOAT_EQ(scale[0], dequantizationScale);
+  extension->attributes["TRANSLATION"]->getComponentAtIndex(1, translation);
+  extension->attributes["SCALE"]->getComponentAtIndex(1, scale);
+  EXPECT_FLOAT_EQ(translation[0], 11.0f);
+  EXPECT_FLOAT_EQ(translation[1], 1.0f);
+  EXPECT_FLOAT_EQ(scale[0], 2 * dequantizationScale);
+  delete asset;
+}
+
+GLTF::Node::TransformMatrix* createTranslation(float x, float y, float z) {
+  GLTF::Node::TransformMatrix* transform = new GLTF::Node::TransformMatrix();
+  transform->matrix[12] = x;
+  transform->matrix[13] = y;
+  transform->matrix[14] = z;
+  return transform;
+}
+
+TEST_F(GLTFAssetTest, BatchPrimitives_MergesStaticPrimitivesInSceneSpace) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Material* material = new GLTF::MaterialCommon();
+  GLTF::Node* parent = new GLTF::Node();
+  parent->transform = createTranslation(0, 10, 0);
+  asset->getDefaultScene()->nodes.push_back(parent);
+  GLTF::Node* nodeOne = addMeshNode(asset, createTriangle(0, material));
+  GLTF::Node* nodeTwo = new GLTF::Node();
+  nodeTwo->mesh = new GLTF::Mesh();
+  nodeTwo->mesh->primitives.push_back(createTriangle(0, material));
+  nodeTwo->transform = createTranslation(5, 0, 0);
+  parent->children.push_back(nodeTwo);
+  GLTF::Options options;
+  asset->batchPrimitives(&options);
+
+  EXPECT_TRUE(nodeOne->mesh == NULL);
+  EXPECT_TRUE(nodeTwo->mesh == NULL);
+  std::vector<GLTF::Mesh*> meshes = asset->getAllMeshes();
+  ASSERT_EQ(meshes.size(), 1);
+  ASSERT_EQ(meshes[0]->primitives.size(), 1);
+  GLTF::Primitive* primitive = meshes[0]->primitives[0];
+  EXPECT_EQ(primitive->material, material);
+  GLTF::Accessor* positions = primitive->attributes["POSITION"];
+  ASSERT_EQ(positions->count, 6);
+  ASSERT_EQ(primitive->indices->count, 6);
+  EXPECT_EQ(primitive->indices->componentType, GLTF::Constants::WebGL::UNSIGNED_SHORT);
+
+  // Both triangles are drawn where their nodes placed them, whichever order they were visited in
+  std::vector<std::pair<float, float>> points;
+  float position[3];
+  for (size_t i = 0; i < positions->count; i++) {
+    positions->getComponentAtIndex(i, position);
+    points.push_back(std::make_pair(position[0], position[1]));
+  }
+  std::sort(points.begin(), points.end());
+  std::vector<std::pair<float, float>> expected = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 5, 10 }, { 5, 11 }, { 6, 10 } };
+  EXPECT_EQ(points, expected);
+  float index;
+  for (size_t i = 0; i < primitive->indices->count; i++) {
+    primitive->indices->getComponentAtIndex(i, &index);
+    EXPECT_EQ(index, (float)i);
+  }
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, BatchPrimitives_UsesIndicesThatFitTheVertexCount) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Material* shortMaterial = new GLTF::MaterialCommon();
+  GLTF::Material* intMaterial = new GLTF::MaterialCommon();
+  for (size_t vertexCount : { 65535, 65536 }) {
+    GLTF::Primitive* primitive = new GLTF::Primitive();
+    primitive->mode = GLTF::Primitive::Mode::POINTS;
+    primitive->attributes["POSITION"] = createAttribute(GLTF::Accessor::Type::VEC3, std::vector<float>(vertexCount * 3, 0.0f));
+    primitive->material = vertexCount == 65535 ? shortMaterial : intMaterial;
+    addMeshNode(asset, primitive);
+  }
+  GLTF::Options options;
+  options.batchMaxVertices = 100000;
+  asset->batchPrimitives(&options);
+
+  std::vector<GLTF::Mesh*> meshes = asset->getAllMeshes();
+  ASSERT_EQ(meshes.size(), 1);
+  ASSERT_EQ(meshes[0]->primitives.size(), 2);
+  for (GLTF::Primitive* primitive : meshes[0]->primitives) {
+    ASSERT_TRUE(primitive->indices != NULL);
+    if (primitive->material == shortMaterial) {
+      EXPECT_EQ(primitive->indices->componentType, GLTF::Constants::WebGL::UNSIGNED_SHORT);
+      EXPECT_EQ(primitive->indices->count, 65535);
+    }
+    else {
+      EXPECT_EQ(primitive->indices->componentType, GLTF::Constants::WebGL::UNSIGNED_INT);
+      EXPECT_EQ(primitive->indices->count, 65536);
+    }
+  }
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, BatchPrimitives_SplitsAtMaxVertices) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Material* material = new GLTF::MaterialCommon();
+  for (int i = 0; i < 3; i++) {
+    addMeshNode(asset, createTriangle((float)i, material));
+  }
+  GLTF::Options options;
+  options.batchMaxVertices = 6;
+  asset->batchPrimitives(&options);
+
+  std::vector<GLTF::Mesh*> meshes = asset->getAllMeshes();
+  ASSERT_EQ(meshes.size(), 1);
+  ASSERT_EQ(meshes[0]->primitives.size(), 2);
+  EXPECT_EQ(meshes[0]->primitives[0]->attributes["POSITION"]->count, 6);
+  EXPECT_EQ(meshes[0]->primitives[1]->attributes["POSITION"]->count, 3);
+  EXPECT_EQ(meshes[0]->primitives[1]->indices->count, 3);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, FlattenNodes_BakesStaticMeshes) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Node* parent = new GLTF::Node();
+  parent->transform = createTranslation(0, 10, 0);
+  asset->getDefaultScene()->nodes.push_back(parent);
+  GLTF::Node* node = new GLTF::Node();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  node->mesh = new GLTF::Mesh();
+  node->mesh->primitives.push_back(primitive);
+  node->transform = createTranslation(5, 0, 0);
+  parent->children.push_back(node);
+  asset->flattenNodes();
+
+  std::vector<GLTF::Node*>& sceneNodes = asset->getDefaultScene()->nodes;
+  ASSERT_EQ(sceneNodes.size(), 1);
+  EXPECT_EQ(sceneNodes[0], node);
+  EXPECT_TRUE(node->transform == NULL);
+  EXPECT_TRUE(node->children.empty());
+  GLTF::Accessor* positions = node->mesh->primitives[0]->attributes["POSITION"];
+  EXPECT_NE(positions, primitive->attributes["POSITION"]);
+  float position[3];
+  positions->getComponentAtIndex(2, position);
+  EXPECT_FLOAT_EQ(position[0], 5);
+  EXPECT_FLOAT_EQ(position[1], 11);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, FlattenNodes_KeepsMeshOfNodesWithLightsUnbaked) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Node* parent = new GLTF::Node();
+  parent->transform = createTranslation(0, 10, 0);
+  asset->getDefaultScene()->nodes.push_back(parent);
+  GLTF::Node* node = new GLTF::Node();
+  GLTF::Mesh* mesh = new GLTF::Mesh();
+  mesh->primitives.push_back(createTriangle(0, new GLTF::MaterialCommon()));
+  node->mesh = mesh;
+  node->light = new GLTF::MaterialCommon::Light();
+  node->transform = createTranslation(5, 0, 0);
+  parent->children.push_back(node);
+  asset->flattenNodes();
+
+  // The light needs the transform, so the mesh must not have it baked in as well
+  std::vector<GLTF::Node*>& sceneNodes = asset->getDefaultScene()->nodes;
+  ASSERT_EQ(sceneNodes.size(), 1);
+  EXPECT_EQ(sceneNodes[0], node);
+  EXPECT_EQ(node->mesh, mesh);
+  ASSERT_TRUE(node->transform != NULL);
+  ASSERT_EQ(node->transform->type, GLTF::Node::Transform::MATRIX);
+  float* matrix = ((GLTF::Node::TransformMatrix*)node->transform)->matrix;
+  EXPECT_FLOAT_EQ(matrix[12], 5);
+  EXPECT_FLOAT_EQ(matrix[13], 10);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, FlattenNodes_ReversesWindingOfMirroredMeshes) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  primitive->attributes["NORMAL"] = createAttribute(GLTF::Accessor::Type::VEC3, { 1, 0, 0, 1, 0, 0, 1, 0, 0 });
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  GLTF::Node::TransformMatrix* mirror = new GLTF::Node::TransformMatrix();
+  mirror->matrix[0] = -1;
+  node->transform = mirror;
+  asset->flattenNodes();
+
+  EXPECT_TRUE(node->transform == NULL);
+  GLTF::Primitive* baked = node->mesh->primitives[0];
+  float index[3];
+  for (int i = 0; i < 3; i++) {
+    baked->indices->getComponentAtIndex(i, &index[i]);
+  }
+  EXPECT_EQ(index[0], 0);
+  EXPECT_EQ(index[1], 2);
+  EXPECT_EQ(index[2], 1);
+  float position[3];
+  baked->attributes["POSITION"]->getComponentAtIndex(1, position);
+  EXPECT_FLOAT_EQ(position[0], -1);
+  float normal[3];
+  baked->attributes["NORMAL"]->getComponentAtIndex(0, normal);
+  EXPECT_FLOAT_EQ(normal[0], -1);
+  // The original mesh is left untouched
+  primitive->indices->getComponentAtIndex(1, &index[1]);
+  EXPECT_EQ(index[1], 1);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, FlattenNodes_FlipsTangentHandednessOfMirroredMeshes) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  primitive->attributes["TANGENT"] = createAttribute(GLTF::Accessor::Type::VEC4, { 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, -1 });
+  GLTF::Node* node = addMeshNode(asset, primitive);
+  GLTF::Node::TransformMatrix* transform = new GLTF::Node::TransformMatrix();
+  transform->matrix[5] = -2;
+  node->transform = transform;
+  asset->flattenNodes();
+
+  EXPECT_TRUE(node->transform == NULL);
+  GLTF::Accessor* tangents = node->mesh->primitives[0]->attributes["TANGENT"];
+  EXPECT_NE(tangents, primitive->attributes["TANGENT"]);
+  float tangent[4];
+  for (int i = 0; i < 3; i++) {
+    tangents->getComponentAtIndex(i, tangent);
+    EXPECT_FLOAT_EQ(tangent[0], 0);
+    EXPECT_FLOAT_EQ(tangent[1], -1);
+    EXPECT_FLOAT_EQ(tangent[2], 0);
+    EXPECT_FLOAT_EQ(tangent[3], i == 2 ? 1 : -1);
+  }
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, PackAccessors_InterleavesVertexAttributes) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+  primitive->attributes["NORMAL"] = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 0, 1, 0, 0, 1, 0, 0, 1 });
+  primitive->attributes["TEXCOORD_0"] = createAttribute(GLTF::Accessor::Type::VEC2, { 0, 0, 1, 0, 0, 1 });
+  addMeshNode(asset, primitive);
+  GLTF::Options options;
+  options.interleave = true;
+  std::vector<GLTF::Buffer*> buffers = asset->packAccessors(&options);
+
+  ASSERT_EQ(buffers.size(), 1);
+  // 3 vertices of 32 bytes, then 3 unsigned short indices
+  EXPECT_EQ(buffers[0]->byteLength, 3 * 32 + 3 * 2);
+  GLTF::Accessor* normal = primitive->attributes["NORMAL"];
+  GLTF::Accessor* position = primitive->attributes["POSITION"];
+  GLTF::Accessor* texCoord = primitive->attributes["TEXCOORD_0"];
+  GLTF::BufferView* bufferView = position->bufferView;
+  EXPECT_EQ(normal->bufferView, bufferView);
+  EXPECT_EQ(texCoord->bufferView, bufferView);
+  EXPECT_EQ(bufferView->byteStride, 32);
+  EXPECT_EQ(bufferView->byteOffset, 0);
+  EXPECT_EQ(bufferView->byteLength, 96);
+  EXPECT_EQ(bufferView->target, GLTF::Constants::WebGL::ARRAY_BUFFER);
+  EXPECT_EQ(normal->byteOffset, 0);
+  EXPECT_EQ(position->byteOffset, 12);
+  EXPECT_EQ(texCoord->byteOffset, 24);
+
+  GLTF::BufferView* indicesBufferView = primitive->indices->bufferView;
+  EXPECT_NE(indicesBufferView, bufferView);
+  EXPECT_EQ(indicesBufferView->byteStride, 0);
+  EXPECT_EQ(indicesBufferView->byteOffset, 96);
+  EXPECT_EQ(indicesBufferView->target, GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+
+  // The data can still be read back through the interleaved layout
+  float component[3];
+  position->getComponentAtIndex(1, component);
+  EXPECT_EQ(component[0], 1);
+  normal->getComponentAtIndex(2, component);
+  EXPECT_EQ(component[2], 1);
+  texCoord->getComponentAtIndex(2, component);
+  EXPECT_EQ(component[1], 1);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, PackAccessors_LeavesSharedAttributesPacked) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::Primitive* primitiveOne = createTriangle(0, new GLTF::MaterialCommon());
+  primitiveOne->attributes["NORMAL"] = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 0, 1, 0, 0, 1, 0, 0, 1 });
+  GLTF::Primitive* primitiveTwo = new GLTF::Primitive();
+  primitiveTwo->attributes["POSITION"] = primitiveOne->attributes["POSITION"];
+  primitiveTwo->attributes["NORMAL"] = createAttribute(GLTF::Accessor::Type::VEC3, { 0, 1, 0, 0, 1, 0, 0, 1, 0 });
+  primitiveTwo->indices = primitiveOne->indices;
+  addMeshNode(asset, primitiveOne);
+  addMeshNode(asset, primitiveTwo);
+  GLTF::Options options;
+  options.interleave = true;
+  asset->packAccessors(&options);
+
+  // The position is used with two different normals, so none of them can be interleaved
+  GLTF::Accessor* position = primitiveOne->attributes["POSITION"];
+  GLTF::BufferView* bufferView = position->bufferView;
+  EXPECT_EQ(bufferView->byteStride, 12);
+  EXPECT_EQ(primitiveOne->attributes["NORMAL"]->bufferView, bufferView);
+  EXPECT_EQ(primitiveTwo->attributes["NORMAL"]->bufferView, bufferView);
+  EXPECT_EQ(bufferView->byteLength, 3 * 36);
+  std::set<size_t> byteOffsets;
+  for (GLTF::Primitive* primitive : { primitiveOne, primitiveTwo }) {
+    for (const auto& attribute : primitive->attributes) {
+      byteOffsets.insert(attribute.second->byteOffset);
+    }
+  }
+  EXPECT_EQ(byteOffsets, std::set<size_t>({ 0, 36, 72 }));
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, PackAccessors_SplitsBuffersAtMaxBufferSize) {
+  // Three 1.2 MB position accessors, no two of which fit in a 2 MB buffer
+  const size_t vertexCount = 100000;
+  GLTF::Asset* asset = new GLTF::Asset();
+  std::vector<GLTF::Primitive*> primitives;
+  for (size_t i = 0; i < 3; i++) {
+    GLTF::Primitive* primitive = createTriangle(0, new GLTF::MaterialCommon());
+    primitive->attributes["POSITION"] = createAttribute(GLTF::Accessor::Type::VEC3, std::vector<float>(vertexCount * 3, (float)i));
+    addMeshNode(asset, primitive);
+    primitives.push_back(primitive);
+  }
+  GLTF::Options options;
+  options.maxBufferSize = 2;
+  std::vector<GLTF::Buffer*> buffers = asset->packAccessors(&options);
+
+  ASSERT_EQ(buffers.size(), 3);
+  for (GLTF::Buffer* buffer : buffers) {
+    EXPECT_LE(buffer->byteLength, (size_t)2 * 1024 * 1024);
+  }
+  std::set<GLTF::Buffer*> positionBuffers;
+  for (size_t i = 0; i < primitives.size(); i++) {
+    for (GLTF::Accessor* accessor : { primitives[i]->attributes["POSITION"], primitives[i]->indices }) {
+      GLTF::BufferView* bufferView = accessor->bufferView;
+      ASSERT_NE(std::find(buffers.begin(), buffers.end(), bufferView->buffer), buffers.end());
+      EXPECT_LE(bufferView->byteOffset + bufferView->byteLength, bufferView->buffer->byteLength);
+    }
+    GLTF::Accessor* position = primitives[i]->attributes["POSITION"];
+    positionBuffers.insert(position->bufferView->buffer);
+    float component[3];
+    position->getComponentAtIndex(vertexCount - 1, component);
+    EXPECT_EQ(component[2], (float)i);
+  }
+  EXPECT_EQ(positionBuffers.size(), 3);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, WriteJSON_IndexesGeneratedShaders) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::MaterialCommon* material = new GLTF::MaterialCommon();
+  material->technique = GLTF::MaterialCommon::Technique::BLINN;
+  addMeshNode(asset, createTriangle(0, material));
+  GLTF::Options options;
+  options.version = "1.0";
+  options.glsl = true;
+  asset->packAccessors(&options);
+  EXPECT_EQ(asset->getAllShaders().size(), 0);
+
+  rapidjson::StringBuffer s;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  GLTF::JSONWriterAdapter<rapidjson::Writer<rapidjson::StringBuffer>, rapidjson::StringBuffer> jsonWriter(&writer, &s);
+  jsonWriter.StartObject();
+  asset->writeJSON(&jsonWriter, &options);
+  jsonWriter.EndObject();
+
+  // The material was converted while writing, the index has to pick up its technique and shaders
+  std::vector<GLTF::Material*> materials = asset->getAllMaterials();
+  ASSERT_EQ(materials.size(), 1);
+  EXPECT_NE(materials[0], material);
+  EXPECT_EQ(asset->getAllTechniques().size(), 1);
+  EXPECT_EQ(asset->getAllPrograms().size(), 1);
+  EXPECT_EQ(asset->getAllShaders().size(), 2);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, InvalidateIndex_ReflectsGraphEdits) {
+  GLTF::Asset* asset = new GLTF::Asset();
+  GLTF::MaterialCommon* material = new GLTF::MaterialCommon();
+  addMeshNode(asset, createTriangle(0, material));
+  EXPECT_EQ(asset->getAllNodes().size(), 1);
+  EXPECT_EQ(asset->getAllImages().size(), 0);
+
+  GLTF::Texture* texture = new GLTF::Texture();
+  texture->source = new GLTF::Image("texture.png");
+  material->values->diffuseTexture = texture;
+  addMeshNode(asset, createTriangle(1, material));
+  asset->invalidateIndex();
+  EXPECT_EQ(asset->getAllNodes().size(), 2);
+  EXPECT_EQ(asset->getAllTextures().size(), 1);
+  std::vector<GLTF::Image*> images = asset->getAllImages();
+  ASSERT_EQ(images.size(), 1);
+  EXPECT_EQ(images[0], texture->source);
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, RemoveDuplicateImages_SharesIdenticalContents) {
+  unsigned char bytes[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 1, 2, 3, 4 };
+  unsigned char copiedBytes[sizeof(bytes)];
+  std::copy(bytes, bytes + sizeof(bytes), copiedBytes);
+  unsigned char otherBytes[sizeof(bytes)];
+  std::copy(bytes, bytes + sizeof(bytes), otherBytes);
+  otherBytes[sizeof(bytes) - 1] = 5;
+
+  GLTF::Asset* asset = new GLTF::Asset();
+  std::vector<GLTF::Texture*> textures;
+  for (GLTF::Image* image : {
+    new GLTF::Image("a.png", bytes, sizeof(bytes), "png"),
+    new GLTF::Image("textures/b.png", copiedBytes, sizeof(bytes), "png"),
+    new GLTF::Image("c.png", otherBytes, sizeof(bytes), "png")
+  }) {
+    GLTF::MaterialCommon* material = new GLTF::MaterialCommon();
+    GLTF::Texture* texture = new GLTF::Texture();
+    texture->source = image;
+    material->values->diffuseTexture = texture;
+    addMeshNode(asset, createTriangle((float)textures.size(), material));
+    textures.push_back(texture);
+  }
+  GLTF::ThreadPool threadPool(2);
+  asset->removeDuplicateImages(&threadPool);
+
+  // The same bytes under another uri are shared, different bytes are kept
+  EXPECT_EQ(textures[0]->source, textures[1]->source);
+  EXPECT_NE(textures[0]->source, textures[2]->source);
+  std::vector<GLTF::Image*> images = asset->getAllImages();
+  ASSERT_EQ(images.size(), 2);
+  EXPECT_NE(std::find(images.begin(), images.end(), textures[0]->source), images.end());
+  EXPECT_NE(std::find(images.begin(), images.end(), textures[2]->source), images.end());
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, ProcessTextures_ResizesImagesInTheirOwnFormat) {
+  ImageCodec::Pixels pixels;
+  pixels.width = 8;
+  pixels.height = 4;
+  pixels.rgba.assign(8 * 4 * 4, 255);
+  std::vector<unsigned char> png = ImageCodec::encodePNG(pixels);
+  std::vector<unsigned char> jpeg = ImageCodec::encodeJPEG(pixels, 90);
+
+  GLTF::Asset* asset = new GLTF::Asset();
+  std::vector<GLTF::Image*> images = {
+    new GLTF::Image("texture.png", png.data(), png.size(), "png"),
+    new GLTF::Image("texture.jpg", jpeg.data(), jpeg.size(), "jpg")
+  };
+  for (GLTF::Image* image : images) {
+    GLTF::MaterialCommon* material = new GLTF::MaterialCommon();
+    GLTF::Texture* texture = new GLTF::Texture();
+    texture->source = image;
+    material->values->diffuseTexture = texture;
+    addMeshNode(asset, createTriangle(0, material));
+  }
+  GLTF::Options options;
+  options.maxTextureSize = 2;
+  GLTF::ThreadPool threadPool(2);
+  asset->processTextures(&options, &threadPool);
+
+  EXPECT_EQ(asset->getAllImages().size(), 2);
+  for (GLTF::Image* image : images) {
+    ImageCodec::Pixels resized;
+    ASSERT_TRUE(ImageCodec::decode(image->getData(), image->getByteLength(), &resized));
+    EXPECT_EQ(resized.width, 2);
+    EXPECT_EQ(resized.height, 1);
+  }
+  EXPECT_EQ(images[0]->getMimeType(), "image/png");
+  EXPECT_EQ(images[1]->getMimeType(), "image/jpeg");
+  delete asset;
+}
+
+TEST_F(GLTFAssetTest, AtlasTextures_RemapsTexCoordsAndMergesMaterials) {
+  std::vector<std::vector<unsigned char>> pngs;
+  for (int size : { 4, 4, 4, 8 }) {
+    ImageCodec::Pixels pixels;
+    pixels.width = size;
+    pixels.height = size;
+    pixels.rgba.assign(size * size * 4, (unsigned char)(pngs.size() * 60));
+    pngs.push_back(ImageCodec::encodePNG(pixels));
+  }
+  // Two textures that fit in an atlas, one that repeats and one that is too large
+  std::vector<std::vector<float>> texCoords = {
+    { 0, 0, 1, 0, 0, 1 },
+    { 0, 0, 1, 0, 0, 1 },
+    { 0, 0, 2, 0, 0, 2 },
+    { 0, 0, 1, 0, 0, 1 }
+  };
+  GLTF::Asset* asset = new GLTF::Asset();
+  std::vector<GLTF::Primitive*> primitives;
+  std::vector<GLTF::Texture*> textures;
+  std::vector<GLTF::Accessor*> originalTexCoords;
+  for (size_t i = 0; i < pngs.size(); i++) {
+    GLTF::MaterialCommon* material = new GLTF::MaterialCommon();
+    GLTF::Texture* texture = new GLTF::Texture();
+    texture->source = new GLTF::Image("texture" + std::to_string(i) + ".png", pngs[i].data(), pngs[i].size(), "png");
+    material->values->diffuseTexture = texture;
+    GLTF::Primitive* primitive = createTriangle((float)i, material);
+    primitive->attributes["TEXCOORD_0"] = createAttribute(GLTF::Accessor::Type::VEC2, texCoords[i]);
+    addMeshNode(asset, primitive);
+    primitives.push_back(primitive);
+    textures.push_back(texture);
+    originalTexCoords.push_back(primitive->attributes["TEXCOORD_0"]);
+  }
+  GLTF::Options options;
+  options.name = "test";
+  options.atlasTextures = true;
+  options.atlasMaxTextureSize = 4;
+  GLTF::ThreadPool threadPool(2);
+  asset->atlasTextures(&options, &threadPool);
+
+  // The packed materials no longer differ and are merged
+  GLTF::Material* atlasMaterial = primitives[0]->material;
+  EXPECT_EQ(primitives[1]->material, atlasMaterial);
+  GLTF::Texture* atlasTexture = atlasMaterial->values->diffuseTexture;
+  ASSERT_NE(atlasTexture, textures[0]);
+  ASSERT_NE(atlasTexture->source, (GLTF::Image*)NULL);
+  EXPECT_EQ(atlasTexture->source->uri, "test_atlas0.png");
+  ImageCodec::Pixels atlasPixels;
+  ASSERT_TRUE(ImageCodec::decode(atlasTexture->source->getData(), atlasTexture->source->getByteLength(), &atlasPixels));
+
+  // Texture coordinates are moved into each image's own region of the atlas
+  std::vector<float> offsets;
+  for (size_t i = 0; i < 2; i++) {
+    GLTF::Accessor* texCoord = primitives[i]->attributes["TEXCOORD_0"];
+    EXPECT_NE(texCoord, originalTexCoords[i]);
+    float origin[2];
+    float right[2];
+    float top[2];
+    texCoord->getComponentAtIndex(0, origin);
+    texCoord->getComponentAtIndex(1, right);
+    texCoord->getComponentAtIndex(2, top);
+    EXPECT_FLOAT_EQ(right[0] - origin[0], 4.0f / atlasPixels.width);
+    EXPECT_FLOAT_EQ(right[1], origin[1]);
+    EXPECT_FLOAT_EQ(top[1] - origin[1], 4.0f / atlasPixels.height);
+    EXPECT_FLOAT_EQ(top[0], origin[0]);
+    EXPECT_GE(origin[0], 0);
+    EXPECT_GE(origin[1], 0);
+    EXPECT_LE(right[0], 1);
+    EXPECT_LE(top[1], 1);
+    offsets.push_back(origin[0]);
+    offsets.push_back(origin[1]);
+  }
+  EXPECT_FALSE(offsets[0] == offsets[2] && offsets[1] == offsets[3]);
+
+  // The repeating and the large texture keep their material and texture coordinates
+  for (size_t i = 2; i < 4; i++) {
+    EXPECT_NE(primitives[i]->material, atlasMaterial);
+    EXPECT_EQ(primitives[i]->material->values->diffuseTexture, textures[i]);
+    EXPECT_EQ(primitives[i]->attributes["TEXCOORD_0"], originalTexCoords[i]);
+  }
+  delete asset;
+}
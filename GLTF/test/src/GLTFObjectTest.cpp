@@ -4,6 +4,8 @@
 #include "rapidjson/stringbuffer.h"
 
 #include "GLTFExtension.h"
+#include "GLTFJSONWriter.h"
+#include "GLTFLodExtension.h"
 #include "GLTFObject.h"
 
 GLTFObjectTest::GLTFObjectTest() {
@@ -17,9 +19,10 @@ GLTFObjectTest::~GLTFObjectTest() {
 rapidjson::StringBuffer writeObject(GLTF::Object* object, GLTF::Options* options) {
   rapidjson::StringBuffer s;
   rapidjson::Writer<rapidjson::StringBuffer> writer(s);
-  writer.StartObject();
-  object->writeJSON(&writer, options);
-  writer.EndObject();
+  GLTF::JSONWriterAdapter<rapidjson::Writer<rapidjson::StringBuffer>, rapidjson::StringBuffer> jsonWriter(&writer, &s);
+  jsonWriter.StartObject();
+  object->writeJSON(&jsonWriter, options);
+  jsonWriter.EndObject();
   return s;
 }
 
@@ -54,6 +57,19 @@ TEST_F(GLTFObjectTest, WriteJSON_WithExtra) {
   free(object);
 }
 
+TEST_F(GLTFObjectTest, WriteJSON_WithArrayExtra) {
+  GLTF::Object* object = new GLTF::Object();
+  GLTF::LodExtension::ScreenCoverage* extra = new GLTF::LodExtension::ScreenCoverage();
+  extra->coverage.push_back(0.5);
+  extra->coverage.push_back(0);
+  object->extras["MSFT_screencoverage"] = extra;
+  rapidjson::StringBuffer s = writeObject(object, this->options);
+
+  EXPECT_STREQ(s.GetString(), "{\"extras\":{\"MSFT_screencoverage\":[0.5,0.0]}}");
+
+  free(object);
+}
+
 TEST_F(GLTFObjectTest, WriteJSON_WithExtension) {
   GLTF::Object* object = new GLTF::Object();
   GLTF::Extension* extension = new GLTF::Extension();
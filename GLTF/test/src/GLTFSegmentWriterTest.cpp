@@ -0,0 +1,51 @@
+#include "GLTFSegmentWriterTest.h"
+
+#include <string>
+#include <vector>
+
+std::string readFile(FILE* file) {
+  std::string contents;
+  rewind(file);
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, sizeof(char), sizeof(buffer), file)) > 0) {
+    contents.append(buffer, read);
+  }
+  return contents;
+}
+
+TEST_F(GLTFSegmentWriterTest, Write_ConcatenatesSegments) {
+  GLTF::SegmentWriter segments;
+  segments.append("ab", 2);
+  segments.appendPadding(2, ' ');
+  segments.append("", 0);
+  segments.append("cde", 3);
+  segments.appendPadding(1, '\0');
+  EXPECT_EQ(segments.length(), (size_t)8);
+
+  FILE* file = tmpfile();
+  ASSERT_TRUE(file != NULL);
+  fwrite("x", sizeof(char), 1, file);
+  EXPECT_TRUE(segments.write(file));
+  EXPECT_EQ(readFile(file), std::string("xab  cde\0", 9));
+  fclose(file);
+}
+
+TEST_F(GLTFSegmentWriterTest, Write_ManySegments) {
+  // More segments than a single writev call accepts
+  std::vector<char> bytes(5000);
+  GLTF::SegmentWriter segments;
+  GLTF::SegmentWriter nested;
+  for (size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = (char)('a' + i % 26);
+    nested.append(&bytes[i], 1);
+  }
+  segments.append(&nested);
+  EXPECT_EQ(segments.length(), bytes.size());
+
+  FILE* file = tmpfile();
+  ASSERT_TRUE(file != NULL);
+  EXPECT_TRUE(segments.write(file));
+  EXPECT_EQ(readFile(file), std::string(bytes.begin(), bytes.end()));
+  fclose(file);
+}
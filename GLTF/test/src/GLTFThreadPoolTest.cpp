@@ -0,0 +1,40 @@
+#include "GLTFThreadPoolTest.h"
+
+#include <atomic>
+
+TEST_F(GLTFThreadPoolTest, Enqueue_NoThreadsRunsInline) {
+  GLTF::ThreadPool pool(0);
+  int value = 0;
+  std::future<void> result = pool.enqueue([&value]() {
+    value = 1;
+  });
+  EXPECT_EQ(value, 1);
+  result.get();
+}
+
+TEST_F(GLTFThreadPoolTest, Enqueue_ReturnsResultsInOrder) {
+  GLTF::ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4);
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; i++) {
+    results.push_back(pool.enqueue([i]() {
+      return i * i;
+    }));
+  }
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST_F(GLTFThreadPoolTest, Destructor_RunsQueuedTasks) {
+  std::atomic<int> count(0);
+  {
+    GLTF::ThreadPool pool(2);
+    for (int i = 0; i < 50; i++) {
+      pool.enqueue([&count]() {
+        count++;
+      });
+    }
+  }
+  EXPECT_EQ(count.load(), 50);
+}
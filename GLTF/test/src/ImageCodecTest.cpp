@@ -0,0 +1,78 @@
+#include "ImageCodecTest.h"
+
+#include <cstdlib>
+#include <vector>
+
+ImageCodec::Pixels createGradient(int width, int height, bool opaque) {
+  ImageCodec::Pixels pixels;
+  pixels.width = width;
+  pixels.height = height;
+  pixels.rgba.resize(width * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      unsigned char* pixel = &pixels.rgba[(y * width + x) * 4];
+      pixel[0] = (unsigned char)(x * 255 / (width - 1));
+      pixel[1] = (unsigned char)(y * 255 / (height - 1));
+      pixel[2] = (unsigned char)((x + y) * 4);
+      pixel[3] = opaque ? 255 : (unsigned char)(x * 16 + y);
+    }
+  }
+  return pixels;
+}
+
+TEST_F(ImageCodecTest, DecodePNG_PaletteWithTransparency) {
+  // A 2x2 image with 2-bit palette indices, written by another encoder
+  const unsigned char png[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x02, 0x03, 0x00, 0x00, 0x00, 0x0F, 0xD8, 0xE5,
+    0xB7, 0x00, 0x00, 0x00, 0x0C, 0x50, 0x4C, 0x54, 0x45, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00,
+    0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFB, 0x00, 0x60, 0xF6, 0x00, 0x00, 0x00, 0x03, 0x74, 0x52, 0x4E,
+    0x53, 0xFF, 0xFF, 0x80, 0x3A, 0x72, 0x8E, 0x61, 0x00, 0x00, 0x00, 0x0C, 0x49, 0x44, 0x41, 0x54,
+    0x78, 0xDA, 0x63, 0x10, 0x60, 0xD8, 0x00, 0x00, 0x00, 0xE4, 0x00, 0xC1, 0x19, 0x55, 0x3B, 0xFB,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82
+  };
+  ImageCodec::Pixels pixels;
+  ASSERT_TRUE(ImageCodec::decode(png, sizeof(png), &pixels));
+  ASSERT_EQ(pixels.width, 2);
+  ASSERT_EQ(pixels.height, 2);
+  std::vector<unsigned char> expected = {
+    255, 0, 0, 255, 0, 255, 0, 255,
+    0, 0, 255, 128, 255, 255, 255, 255
+  };
+  EXPECT_EQ(pixels.rgba, expected);
+}
+
+TEST_F(ImageCodecTest, EncodePNG_RoundTrip) {
+  for (bool opaque : { true, false }) {
+    ImageCodec::Pixels pixels = createGradient(37, 21, opaque);
+    std::vector<unsigned char> png = ImageCodec::encodePNG(pixels);
+    ImageCodec::Pixels decoded;
+    ASSERT_TRUE(ImageCodec::decodePNG(png.data(), png.size(), &decoded));
+    EXPECT_EQ(decoded.width, 37);
+    EXPECT_EQ(decoded.height, 21);
+    EXPECT_EQ(decoded.rgba, pixels.rgba);
+  }
+}
+
+TEST_F(ImageCodecTest, EncodeJPEG_RoundTrip) {
+  ImageCodec::Pixels pixels = createGradient(29, 19, true);
+  std::vector<unsigned char> jpeg = ImageCodec::encodeJPEG(pixels, 90);
+  ImageCodec::Pixels decoded;
+  ASSERT_TRUE(ImageCodec::decodeJPEG(jpeg.data(), jpeg.size(), &decoded));
+  ASSERT_EQ(decoded.width, 29);
+  ASSERT_EQ(decoded.height, 19);
+  // A smooth gradient survives high quality compression almost unchanged
+  for (size_t i = 0; i < pixels.rgba.size(); i++) {
+    ASSERT_LE(std::abs(decoded.rgba[i] - pixels.rgba[i]), 8);
+  }
+}
+
+TEST_F(ImageCodecTest, Decode_RejectsInvalidData) {
+  ImageCodec::Pixels pixels;
+  const unsigned char text[] = "not an image";
+  EXPECT_FALSE(ImageCodec::decode(text, sizeof(text), &pixels));
+
+  std::vector<unsigned char> png = ImageCodec::encodePNG(createGradient(8, 8, true));
+  png.resize(png.size() / 2);
+  EXPECT_FALSE(ImageCodec::decode(png.data(), png.size(), &pixels));
+}
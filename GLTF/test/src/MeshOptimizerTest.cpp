@@ -0,0 +1,158 @@
+#include "MeshOptimizerTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+std::vector<unsigned int> createGrid(unsigned int size) {
+  // Rows of quads emitted column by column, which thrashes a small cache
+  std::vector<unsigned int> indices;
+  for (unsigned int x = 0; x < size; x++) {
+    for (unsigned int y = 0; y < size; y++) {
+      unsigned int a = y * (size + 1) + x;
+      unsigned int b = a + 1;
+      unsigned int c = a + size + 1;
+      unsigned int d = c + 1;
+      indices.push_back(a);
+      indices.push_back(b);
+      indices.push_back(c);
+      indices.push_back(b);
+      indices.push_back(d);
+      indices.push_back(c);
+    }
+  }
+  return indices;
+}
+
+std::vector<std::vector<unsigned int>> getSortedTriangles(const std::vector<unsigned int>& indices) {
+  std::vector<std::vector<unsigned int>> triangles;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    // Rotate each triangle so its smallest index comes first, which keeps the winding
+    std::vector<unsigned int> triangle(indices.begin() + i, indices.begin() + i + 3);
+    std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+TEST_F(MeshOptimizerTest, AnalyzeVertexCache_Triangle) {
+  unsigned int indices[6] = { 0, 1, 2, 2, 1, 0 };
+  MeshOptimizer::VertexCacheStatistics statistics = MeshOptimizer::analyzeVertexCache(indices, 6, 3);
+  EXPECT_EQ(statistics.triangleCount, 2);
+  EXPECT_EQ(statistics.vertexCount, 3);
+  EXPECT_EQ(statistics.cacheMisses, 3);
+  EXPECT_FLOAT_EQ(statistics.acmr, 1.5);
+  EXPECT_FLOAT_EQ(statistics.atvr, 1.0);
+}
+
+TEST_F(MeshOptimizerTest, OptimizeVertexCache_KeepsTriangles) {
+  unsigned int size = 64;
+  std::vector<unsigned int> indices = createGrid(size);
+  std::vector<unsigned int> optimized = indices;
+  size_t vertexCount = (size + 1) * (size + 1);
+  MeshOptimizer::optimizeVertexCache(&optimized[0], optimized.size(), vertexCount);
+  EXPECT_TRUE(getSortedTriangles(indices) == getSortedTriangles(optimized));
+}
+
+TEST_F(MeshOptimizerTest, OptimizeVertexCache_ReducesCacheMisses) {
+  unsigned int size = 64;
+  std::vector<unsigned int> indices = createGrid(size);
+  size_t vertexCount = (size + 1) * (size + 1);
+  MeshOptimizer::VertexCacheStatistics before = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount);
+  MeshOptimizer::optimizeVertexCache(&indices[0], indices.size(), vertexCount);
+  MeshOptimizer::VertexCacheStatistics after = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount);
+  EXPECT_LT(after.acmr, before.acmr);
+  EXPECT_LT(after.atvr, 1.5);
+}
+
+TEST_F(MeshOptimizerTest, ComputeVertexFetchRemap_FirstUseOrder) {
+  unsigned int indices[6] = { 3, 1, 4, 4, 1, 0 };
+  std::vector<unsigned int> remap = MeshOptimizer::computeVertexFetchRemap(indices, 6, 6);
+  ASSERT_EQ(remap.size(), 6);
+  EXPECT_EQ(remap[3], 0);
+  EXPECT_EQ(remap[1], 1);
+  EXPECT_EQ(remap[4], 2);
+  EXPECT_EQ(remap[0], 3);
+  // Unused vertices go last in their original order
+  EXPECT_EQ(remap[2], 4);
+  EXPECT_EQ(remap[5], 5);
+}
+
+std::vector<float> createGridPositions(unsigned int size, bool flat) {
+  std::vector<float> positions;
+  for (unsigned int y = 0; y <= size; y++) {
+    for (unsigned int x = 0; x <= size; x++) {
+      positions.push_back((float)x);
+      positions.push_back((float)y);
+      positions.push_back(flat ? 0.0f : (float)std::sin(x * 0.3) * 2.0f);
+    }
+  }
+  return positions;
+}
+
+TEST_F(MeshOptimizerTest, Simplify_FlatGrid) {
+  unsigned int size = 32;
+  std::vector<unsigned int> indices = createGrid(size);
+  std::vector<float> positions = createGridPositions(size, true);
+  float error;
+  std::vector<unsigned int> simplified = MeshOptimizer::simplify(&indices[0], indices.size(), &positions[0], positions.size() / 3, 3, indices.size() / 4, 0.01f, &error);
+  EXPECT_LE(simplified.size(), indices.size() / 4);
+  EXPECT_EQ(simplified.size() % 3, 0);
+  EXPECT_LT(error, 0.001f);
+  for (unsigned int index : simplified) {
+    EXPECT_LT(index, positions.size() / 3);
+  }
+}
+
+TEST_F(MeshOptimizerTest, Simplify_StopsAtTargetError) {
+  unsigned int size = 32;
+  std::vector<unsigned int> indices = createGrid(size);
+  std::vector<float> positions = createGridPositions(size, false);
+  float error;
+  std::vector<unsigned int> simplified = MeshOptimizer::simplify(&indices[0], indices.size(), &positions[0], positions.size() / 3, 3, 0, 0.01f, &error);
+  EXPECT_LT(simplified.size(), indices.size());
+  EXPECT_GT(simplified.size(), 0);
+  EXPECT_LE(error, 0.01f);
+}
+
+TEST_F(MeshOptimizerTest, Simplify_CollapsesSeamsTogether) {
+  unsigned int size = 32;
+  unsigned int seam = size / 2;
+  std::vector<unsigned int> indices = createGrid(size);
+  std::vector<float> positions = createGridPositions(size, true);
+  // The right half has its own copies of the vertices on the middle column, as it would with a texture seam
+  unsigned int gridVertexCount = (size + 1) * (size + 1);
+  for (unsigned int y = 0; y <= size; y++) {
+    unsigned int vertex = y * (size + 1) + seam;
+    positions.insert(positions.end(), positions.begin() + vertex * 3, positions.begin() + vertex * 3 + 3);
+  }
+  for (size_t i = seam * size * 6; i < indices.size(); i++) {
+    if (indices[i] % (size + 1) == seam) {
+      indices[i] = gridVertexCount + indices[i] / (size + 1);
+    }
+  }
+
+  float error;
+  std::vector<unsigned int> simplified = MeshOptimizer::simplify(&indices[0], indices.size(), &positions[0], positions.size() / 3, 3, indices.size() / 4, 0.01f, &error);
+  EXPECT_LE(simplified.size(), indices.size() / 4);
+  std::set<unsigned int> seamVertices;
+  for (size_t i = 0; i < simplified.size(); i += 3) {
+    bool left = false;
+    bool right = false;
+    for (size_t j = 0; j < 3; j++) {
+      unsigned int index = simplified[i + j];
+      if (index >= gridVertexCount) {
+        right = true;
+        seamVertices.insert(index);
+      }
+      else if (index % (size + 1) <= seam) {
+        left = true;
+      }
+    }
+    // Triangles on the right of the seam keep using the copies
+    EXPECT_FALSE(left && right);
+  }
+  EXPECT_LT(seamVertices.size(), size + 1);
+}
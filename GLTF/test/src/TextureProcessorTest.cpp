@@ -0,0 +1,86 @@
+#include "TextureProcessorTest.h"
+
+#include <cstring>
+#include <vector>
+
+ImageCodec::Pixels createSolid(int width, int height, unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+  ImageCodec::Pixels pixels;
+  pixels.width = width;
+  pixels.height = height;
+  for (int i = 0; i < width * height; i++) {
+    pixels.rgba.push_back(r);
+    pixels.rgba.push_back(g);
+    pixels.rgba.push_back(b);
+    pixels.rgba.push_back(a);
+  }
+  return pixels;
+}
+
+TEST_F(TextureProcessorTest, GetTargetSize_MaxSize) {
+  EXPECT_EQ(TextureProcessor::getTargetSize(8192, 4096, 2048, false), std::make_pair(2048, 1024));
+  EXPECT_EQ(TextureProcessor::getTargetSize(1000, 500, 2048, false), std::make_pair(1000, 500));
+  EXPECT_EQ(TextureProcessor::getTargetSize(1000, 500, 0, false), std::make_pair(1000, 500));
+}
+
+TEST_F(TextureProcessorTest, GetTargetSize_PowerOfTwo) {
+  EXPECT_EQ(TextureProcessor::getTargetSize(1000, 300, 0, true), std::make_pair(1024, 256));
+  // Rounding up never goes over the maximum size
+  EXPECT_EQ(TextureProcessor::getTargetSize(4000, 1000, 2000, true), std::make_pair(1024, 512));
+}
+
+TEST_F(TextureProcessorTest, Resize_AveragesCoveredPixels) {
+  ImageCodec::Pixels pixels = createSolid(4, 2, 0, 0, 0, 255);
+  // Left half white, right half black
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 2; x++) {
+      std::memset(&pixels.rgba[(y * 4 + x) * 4], 255, 3);
+    }
+  }
+  ImageCodec::Pixels linear = TextureProcessor::resize(pixels, 1, 1, false);
+  EXPECT_EQ(linear.rgba, std::vector<unsigned char>({ 128, 128, 128, 255 }));
+  // Half white in linear light is lighter than 50% in sRGB
+  ImageCodec::Pixels srgb = TextureProcessor::resize(pixels, 1, 1, true);
+  EXPECT_EQ(srgb.rgba, std::vector<unsigned char>({ 188, 188, 188, 255 }));
+}
+
+TEST_F(TextureProcessorTest, Resize_IgnoresColorOfTransparentPixels) {
+  ImageCodec::Pixels pixels = createSolid(2, 1, 255, 0, 0, 255);
+  std::memcpy(&pixels.rgba[4], "\x00\xff\x00\x00", 4);
+  ImageCodec::Pixels resized = TextureProcessor::resize(pixels, 1, 1, true);
+  EXPECT_EQ(resized.rgba, std::vector<unsigned char>({ 255, 0, 0, 128 }));
+}
+
+TEST_F(TextureProcessorTest, PackAtlases_Shelves) {
+  std::vector<std::pair<int, int>> sizes = { { 4, 2 }, { 6, 6 }, { 8, 4 }, { 20, 20 } };
+  std::vector<TextureProcessor::AtlasPlacement> placements;
+  std::vector<std::pair<int, int>> atlasSizes = TextureProcessor::packAtlases(sizes, 16, 1, &placements);
+  ASSERT_EQ(atlasSizes.size(), 1);
+  EXPECT_EQ(atlasSizes[0], std::make_pair(16, 14));
+
+  // The tallest image starts the first shelf and the next one doesn't fit beside it, but the last does
+  EXPECT_EQ(placements[1].atlas, 0);
+  EXPECT_EQ(placements[1].x, 1);
+  EXPECT_EQ(placements[1].y, 1);
+  EXPECT_EQ(placements[2].x, 1);
+  EXPECT_EQ(placements[2].y, 9);
+  EXPECT_EQ(placements[0].x, 11);
+  EXPECT_EQ(placements[0].y, 9);
+  // Too large for the atlas
+  EXPECT_EQ(placements[3].atlas, -1);
+}
+
+TEST_F(TextureProcessorTest, Blit_ExtrudesEdges) {
+  ImageCodec::Pixels image = createSolid(2, 1, 10, 20, 30, 255);
+  image.rgba[4] = 40;
+  ImageCodec::Pixels atlas = createSolid(6, 5, 0, 0, 0, 0);
+  TextureProcessor::blit(image, &atlas, 2, 2, 2);
+  auto red = [&atlas](int x, int y) {
+    return atlas.rgba[(y * atlas.width + x) * 4];
+  };
+  for (int y = 0; y < 5; y++) {
+    EXPECT_EQ(red(0, y), 10);
+    EXPECT_EQ(red(2, y), 10);
+    EXPECT_EQ(red(3, y), 40);
+    EXPECT_EQ(red(5, y), 40);
+  }
+}
@@ -1,5 +1,7 @@
 #include "GLTFAccessorTest.h"
 #include "GLTFObjectTest.h"
+#include "GLTFThreadPoolTest.h"
+#include "MeshOptimizerTest.h"
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
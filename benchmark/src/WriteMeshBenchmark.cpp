@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+
+#include "COLLADA2GLTFWriter.h"
+#include "COLLADABU.h"
+#include "COLLADAFW.h"
+
+/**
+ * Builds a grid of quads laid out like a COLLADA polylist, with shared positions and texture
+ * coordinates and a normal per face, so that most corners weld into shared vertices.
+ */
+COLLADAFW::Mesh* createGridMesh(unsigned int size) {
+	COLLADAFW::Mesh* mesh = new COLLADAFW::Mesh(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 0, 0));
+	COLLADAFW::MeshVertexData& positions = mesh->getPositions();
+	COLLADAFW::MeshVertexData& normals = mesh->getNormals();
+	COLLADAFW::MeshVertexData& uvCoords = mesh->getUVCoords();
+	positions.setType(COLLADAFW::FloatOrDoubleArray::DATA_TYPE_FLOAT);
+	normals.setType(COLLADAFW::FloatOrDoubleArray::DATA_TYPE_FLOAT);
+	uvCoords.setType(COLLADAFW::FloatOrDoubleArray::DATA_TYPE_FLOAT);
+	for (unsigned int y = 0; y <= size; y++) {
+		for (unsigned int x = 0; x <= size; x++) {
+			positions.getFloatValues()->append((float)x);
+			positions.getFloatValues()->append((float)y);
+			positions.getFloatValues()->append(0.0f);
+			uvCoords.getFloatValues()->append((float)x / size);
+			uvCoords.getFloatValues()->append((float)y / size);
+		}
+	}
+	for (unsigned int i = 0; i < 6; i++) {
+		normals.getFloatValues()->append(i % 3 == 0 ? 1.0f : 0.0f);
+		normals.getFloatValues()->append(i % 3 == 1 ? 1.0f : 0.0f);
+		normals.getFloatValues()->append(i % 3 == 2 ? 1.0f : 0.0f);
+	}
+
+	COLLADAFW::Polylist* polylist = new COLLADAFW::Polylist(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::POLYLIST, 0, 0));
+	COLLADAFW::IndexList* uvCoordIndices = new COLLADAFW::IndexList();
+	for (unsigned int y = 0; y < size; y++) {
+		for (unsigned int x = 0; x < size; x++) {
+			unsigned int corners[4] = { y * (size + 1) + x, y * (size + 1) + x + 1, (y + 1) * (size + 1) + x + 1, (y + 1) * (size + 1) + x };
+			for (unsigned int corner : corners) {
+				polylist->getPositionIndices().append(corner);
+				polylist->getNormalIndices().append((x + y) % 6);
+				uvCoordIndices->getIndices().append(corner);
+			}
+			polylist->getGroupedVerticesVertexCountArray().append(4);
+		}
+	}
+	polylist->getUVCoordIndicesArray().append(uvCoordIndices);
+	polylist->setFaceCount(size * size);
+	mesh->getMeshPrimitives().append(polylist);
+	return mesh;
+}
+
+/**
+ * Times Writer::writeGeometry, which welds and triangulates the corners of each primitive, on
+ * grids of increasing size.
+ */
+int main() {
+	const unsigned int sizes[3] = { 100, 200, 400 };
+	for (unsigned int size : sizes) {
+		COLLADAFW::Mesh* mesh = createGridMesh(size);
+		GLTF::Asset* asset = new GLTF::Asset();
+		COLLADA2GLTF::Options* options = new COLLADA2GLTF::Options();
+		COLLADASaxFWL::Loader* loader = new COLLADASaxFWL::Loader();
+		COLLADA2GLTF::ExtrasHandler* extrasHandler = new COLLADA2GLTF::ExtrasHandler(loader);
+		COLLADA2GLTF::Writer* writer = new COLLADA2GLTF::Writer(asset, options, extrasHandler);
+
+		std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+		if (!writer->writeGeometry(mesh)) {
+			std::cout << "ERROR: Unable to write a " << size << "x" << size << " grid" << std::endl;
+			return -1;
+		}
+		std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		std::cout << "Wrote " << size * size << " quads (" << size * size * 4 << " corners) in " << time.count() * 1000 << "ms" << std::endl;
+
+		delete writer;
+		delete extrasHandler;
+		delete loader;
+		delete options;
+		delete asset;
+		delete mesh;
+	}
+	return 0;
+}
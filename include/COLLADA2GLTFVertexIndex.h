@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace COLLADA2GLTF {
+	/**
+	 * An open-addressing hash table used to weld the corners of a primitive into glTF vertices.
+	 *
+	 * Each vertex is identified by a fixed-length key of unsigned integers, one per attribute
+	 * semantic. Keys are stored contiguously in insertion order and the table only holds the
+	 * vertex indices, so a lookup never allocates.
+	 */
+	class VertexIndex {
+	public:
+		VertexIndex(size_t keyLength, size_t expectedVertexCount);
+
+		/**
+		 * Finds the vertex with the given key, adding it as the next vertex if it does not exist yet.
+		 *
+		 * @param key An array of `keyLength` unsigned integers identifying the vertex
+		 * @param inserted Set to `true` if the vertex was added by this call
+		 * @return The index of the vertex
+		 */
+		unsigned int findOrInsert(const unsigned int* key, bool* inserted);
+		size_t size();
+
+	private:
+		size_t _keyLength;
+		size_t _size = 0;
+		size_t _mask;
+		std::vector<unsigned int> _slots;
+		std::vector<unsigned int> _keys;
+
+		size_t hashKey(const unsigned int* key);
+		void grow();
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "COLLADAFW.h"
+#include "GLTFAccessor.h"
+
+namespace COLLADA2GLTF {
+	/**
+	 * Builds the attribute data of a glTF primitive from the per-attribute indices of a COLLADA primitive.
+	 *
+	 * Each semantic occupies a slot in a flat array with its component count, source stride and source
+	 * values resolved up front, so appending a vertex does no string work or map lookups.
+	 */
+	class VertexStreams {
+	public:
+		class Stream {
+		public:
+			std::string semantic;
+			GLTF::Accessor::Type type;
+			unsigned int numberOfComponents;
+			unsigned int stride;
+			bool flipY = false;
+			bool position = false;
+			const unsigned int* indices;
+			const COLLADAFW::MeshVertexData* data;
+			const float* floatValues = NULL;
+			const double* doubleValues = NULL;
+			std::vector<float> values;
+
+			float getValue(size_t index) const;
+		};
+
+		std::vector<Stream> streams;
+
+		/**
+		 * @param vertexCount The number of COLLADA indices per semantic, used as an upper bound on the number of vertices
+		 * @param positionScale The scale applied to POSITION values
+		 */
+		VertexStreams(size_t vertexCount, float positionScale);
+
+		void addStream(const std::string& semantic, const unsigned int* indices, const COLLADAFW::MeshVertexData* data);
+
+		/**
+		 * Orders the streams by semantic and reserves their buffers. Must be called once after all streams are added.
+		 */
+		void finalize();
+
+		/**
+		 * Appends the vertex referenced by the given COLLADA corner to every stream.
+		 */
+		void appendVertex(size_t corner);
+
+	private:
+		size_t _vertexCount;
+		float _positionScale;
+	};
+}
@@ -6,8 +6,10 @@
 #include "COLLADABU.h"
 #include "COLLADAFW.h"
 #include "GLTFAsset.h"
+#include "GLTFThreadPool.h"
 #include "COLLADA2GLTFOptions.h"
 #include "COLLADA2GLTFExtrasHandler.h"
+#include "COLLADA2GLTFVertexStreams.h"
 
 #include "draco/compression/encode.h"
 
@@ -38,14 +40,18 @@ namespace COLLADA2GLTF {
 		std::map<COLLADAFW::UniqueId, GLTF::Mesh*> _skinnedMeshes;
 		std::map<COLLADAFW::UniqueId, GLTF::Image*> _images;
 		std::map<COLLADAFW::UniqueId, std::tuple<std::vector<float>, std::vector<float>>> _animationData;
+		GLTF::ThreadPool* _threadPool = NULL;
 
 		bool writeNodeToGroup(std::vector<GLTF::Node*>* group, const COLLADAFW::Node* node);
 		bool writeNodesToGroup(std::vector<GLTF::Node*>* group, const COLLADAFW::NodePointerArray& nodes);
 		GLTF::Texture* fromColladaTexture(const COLLADAFW::EffectCommon* effectCommon, COLLADAFW::SamplerID samplerId);
 		GLTF::Texture* fromColladaTexture(const COLLADAFW::EffectCommon* effectCommon, COLLADAFW::Texture texture);
+		GLTF::ThreadPool* getThreadPool();
+		bool writeMeshPrimitive(const COLLADAFW::Mesh* colladaMesh, COLLADAFW::MeshPrimitive* colladaPrimitive, GLTF::Primitive* primitive, bool shouldTriangulate, std::vector<unsigned int>* mapping);
 
 	public:
 		Writer(GLTF::Asset* asset, COLLADA2GLTF::Options* options, COLLADA2GLTF::ExtrasHandler* handler);
+		~Writer();
 
 		/** Deletes the entire scene.
 			 @param errorMessage A message containing informations about the error that occurred.
@@ -126,7 +132,7 @@ namespace COLLADA2GLTF {
 		virtual bool writeKinematicsScene(const COLLADAFW::KinematicsScene* kinematicsScene);
 
 		/** Add attributes of mesh to draco compression extension.*/
-		bool addAttributesToDracoMesh(GLTF::Primitive* primitive, const std::map<std::string, std::vector<float>>& buildAttributes, const std::vector<unsigned int>& buildIndices);
+		bool addAttributesToDracoMesh(GLTF::Primitive* primitive, const std::vector<COLLADA2GLTF::VertexStreams::Stream>& streams, const std::vector<unsigned int>& buildIndices);
 
 		/** Add joint indices and joint weights to draco compression extension.*/
 		bool addControllerDataToDracoMesh(GLTF::Primitive* primitive, unsigned short* jointArray, float* weightArray);
@@ -0,0 +1,69 @@
+#include "COLLADA2GLTFVertexIndex.h"
+
+#include <cstring>
+
+// Slots hold the vertex index + 1 so that zero can mark an empty slot
+const unsigned int EMPTY_SLOT = 0;
+
+COLLADA2GLTF::VertexIndex::VertexIndex(size_t keyLength, size_t expectedVertexCount) : _keyLength(keyLength) {
+	// Keep the load factor at or below one half for the expected number of vertices
+	size_t capacity = 16;
+	while (capacity < expectedVertexCount * 2) {
+		capacity *= 2;
+	}
+	_slots.resize(capacity, EMPTY_SLOT);
+	_mask = capacity - 1;
+	_keys.reserve(expectedVertexCount * keyLength);
+}
+
+size_t COLLADA2GLTF::VertexIndex::hashKey(const unsigned int* key) {
+	// 64-bit FNV-1a over the key components, finished with a murmur mix so the low bits are usable
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < _keyLength; i++) {
+		hash ^= key[i];
+		hash *= 1099511628211ULL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return (size_t)hash;
+}
+
+unsigned int COLLADA2GLTF::VertexIndex::findOrInsert(const unsigned int* key, bool* inserted) {
+	size_t keyByteLength = _keyLength * sizeof(unsigned int);
+	size_t slot = hashKey(key) & _mask;
+	while (_slots[slot] != EMPTY_SLOT) {
+		unsigned int index = _slots[slot] - 1;
+		if (std::memcmp(&_keys[index * _keyLength], key, keyByteLength) == 0) {
+			*inserted = false;
+			return index;
+		}
+		slot = (slot + 1) & _mask;
+	}
+	unsigned int index = (unsigned int)_size;
+	_keys.insert(_keys.end(), key, key + _keyLength);
+	_slots[slot] = index + 1;
+	_size++;
+	if (_size * 2 > _slots.size()) {
+		grow();
+	}
+	*inserted = true;
+	return index;
+}
+
+size_t COLLADA2GLTF::VertexIndex::size() {
+	return _size;
+}
+
+void COLLADA2GLTF::VertexIndex::grow() {
+	size_t capacity = _slots.size() * 2;
+	_slots.assign(capacity, EMPTY_SLOT);
+	_mask = capacity - 1;
+	for (size_t index = 0; index < _size; index++) {
+		size_t slot = hashKey(&_keys[index * _keyLength]) & _mask;
+		while (_slots[slot] != EMPTY_SLOT) {
+			slot = (slot + 1) & _mask;
+		}
+		_slots[slot] = (unsigned int)index + 1;
+	}
+}
@@ -0,0 +1,65 @@
+#include "COLLADA2GLTFVertexStreams.h"
+
+#include <algorithm>
+
+COLLADA2GLTF::VertexStreams::VertexStreams(size_t vertexCount, float positionScale) : _vertexCount(vertexCount), _positionScale(positionScale) {}
+
+float COLLADA2GLTF::VertexStreams::Stream::getValue(size_t index) const {
+	if (doubleValues != NULL) {
+		return (float)doubleValues[index];
+	}
+	return floatValues[index];
+}
+
+void COLLADA2GLTF::VertexStreams::addStream(const std::string& semantic, const unsigned int* indices, const COLLADAFW::MeshVertexData* data) {
+	Stream stream;
+	stream.semantic = semantic;
+	stream.type = GLTF::Accessor::Type::VEC3;
+	if (semantic.find("TEXCOORD") == 0) {
+		stream.type = GLTF::Accessor::Type::VEC2;
+		stream.flipY = true;
+	}
+	else if (semantic == "POSITION") {
+		stream.position = true;
+	}
+	stream.numberOfComponents = GLTF::Accessor::getNumberOfComponents(stream.type);
+	stream.stride = stream.numberOfComponents;
+	if (data->getNumInputInfos() > 0) {
+		stream.stride = data->getStride(0);
+	}
+	stream.indices = indices;
+	stream.data = data;
+	if (data->getType() == COLLADAFW::FloatOrDoubleArray::DATA_TYPE_DOUBLE) {
+		stream.doubleValues = data->getDoubleValues()->getData();
+	}
+	else {
+		stream.floatValues = data->getFloatValues()->getData();
+	}
+	streams.push_back(stream);
+}
+
+void COLLADA2GLTF::VertexStreams::finalize() {
+	// Keep the order that semantics have always been written in
+	std::sort(streams.begin(), streams.end(), [](const Stream& a, const Stream& b) {
+		return a.semantic < b.semantic;
+	});
+	for (Stream& stream : streams) {
+		stream.values.reserve(_vertexCount * stream.numberOfComponents);
+	}
+}
+
+void COLLADA2GLTF::VertexStreams::appendVertex(size_t corner) {
+	for (Stream& stream : streams) {
+		size_t offset = (size_t)stream.indices[corner] * stream.stride;
+		for (unsigned int k = 0; k < stream.numberOfComponents; k++) {
+			float value = stream.getValue(offset + k);
+			if (stream.flipY && k == 1) {
+				value = 1 - value;
+			}
+			if (stream.position) {
+				value = value * _positionScale;
+			}
+			stream.values.push_back(value);
+		}
+	}
+}
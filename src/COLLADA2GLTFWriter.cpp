@@ -1,8 +1,12 @@
 #include "COLLADA2GLTFWriter.h"
 
+#include <climits>
 #include <experimental/filesystem>
+#include <unordered_map>
 
 #include "Base64.h"
+#include "COLLADA2GLTFVertexIndex.h"
+#include "COLLADA2GLTFVertexStreams.h"
 
 using namespace std::experimental::filesystem;
 
@@ -10,6 +14,27 @@ const double PI = 3.14159;
 
 COLLADA2GLTF::Writer::Writer(GLTF::Asset* asset, COLLADA2GLTF::Options* options, COLLADA2GLTF::ExtrasHandler* extrasHandler) : _asset(asset), _options(options), _extrasHandler(extrasHandler) {}
 
+COLLADA2GLTF::Writer::~Writer() {
+	if (_threadPool != NULL) {
+		delete _threadPool;
+	}
+}
+
+/**
+ * Gets the pool used to build primitives concurrently, creating it the first time it is needed.
+ *
+ * @return The thread pool, or `NULL` if work should be done on the calling thread
+ */
+GLTF::ThreadPool* COLLADA2GLTF::Writer::getThreadPool() {
+	if (_options->threads <= 1) {
+		return NULL;
+	}
+	if (_threadPool == NULL) {
+		_threadPool = new GLTF::ThreadPool(_options->threads);
+	}
+	return _threadPool;
+}
+
 void COLLADA2GLTF::Writer::cancel(const std::string& errorMessage) {
 
 }
@@ -494,6 +519,27 @@ std::string buildAttributeId(const COLLADAFW::MeshVertexData& data, int index, i
 	return id;
 }
 
+/**
+ * Maps a COLLADA source index to an id that is shared by every source index with the same attribute id.
+ *
+ * The attribute id string is only built the first time a source index is seen, so welding corners by
+ * these ids gives the same vertices as comparing attribute id strings without doing string work per corner.
+ */
+unsigned int getAttributeIdIndex(const COLLADAFW::MeshVertexData& data, unsigned int index, int count, std::vector<unsigned int>* idIndices, std::unordered_map<std::string, unsigned int>* attributeIds) {
+	if (index >= idIndices->size()) {
+		idIndices->resize(index + 1, UINT_MAX);
+	}
+	unsigned int idIndex = idIndices->at(index);
+	if (idIndex == UINT_MAX) {
+		std::string attributeId = buildAttributeId(data, index, count);
+		idIndex = (unsigned int)attributeIds->size();
+		std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> result = attributeIds->emplace(attributeId, idIndex);
+		idIndex = result.first->second;
+		idIndices->at(index) = idIndex;
+	}
+	return idIndex;
+}
+
 /**
  * Converts and writes a <COLLADAFW::Mesh> to a <GLTF::Mesh>.
  * The produced meshes are stored in `this->_meshInstances` indexed by their <COLLADAFW::UniqueId>.
@@ -519,11 +565,11 @@ bool COLLADA2GLTF::Writer::writeMesh(const COLLADAFW::Mesh* colladaMesh) {
 	std::map<int, std::set<GLTF::Primitive*>> primitiveMaterialMapping;
 	size_t meshPrimitivesCount = meshPrimitives.getCount();
 	if (meshPrimitivesCount > 0) {
+		std::vector<GLTF::Primitive*> primitives;
+		std::vector<COLLADAFW::MeshPrimitive*> colladaPrimitives;
+		std::vector<bool> triangulate;
 		// Create primitives
 		for (size_t i = 0; i < meshPrimitivesCount; i++) {
-			std::map<std::string, std::vector<float>> buildAttributes;
-			std::map<std::string, unsigned int> attributeIndicesMapping;
-			std::vector<unsigned int> buildIndices;
 			COLLADAFW::MeshPrimitive* colladaPrimitive = meshPrimitives[i];
 			GLTF::Primitive* primitive = new GLTF::Primitive();
 
@@ -538,7 +584,6 @@ bool COLLADA2GLTF::Writer::writeMesh(const COLLADAFW::Mesh* colladaMesh) {
 				primitiveMaterialMapping[materialId] = primitiveSet;
 			}
 
-			std::vector<unsigned int> mapping;
 			bool shouldTriangulate = false;
 
 			COLLADAFW::MeshPrimitive::PrimitiveType type = colladaPrimitive->getPrimitiveType();
@@ -573,192 +618,192 @@ bool COLLADA2GLTF::Writer::writeMesh(const COLLADAFW::Mesh* colladaMesh) {
 			if (primitive->mode == GLTF::Primitive::Mode::UNKNOWN) {
 				continue;
 			}
-			size_t count = colladaPrimitive->getPositionIndices().getCount();
-			std::map<std::string, const unsigned int*> semanticIndices;
-			std::map<std::string, const COLLADAFW::MeshVertexData*> semanticData;
-			std::string semantic = "POSITION";
-			buildAttributes[semantic] = std::vector<float>();
-			semanticIndices[semantic] = colladaPrimitive->getPositionIndices().getData();
-			semanticData[semantic] = &colladaMesh->getPositions();
-			primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
-			if (colladaPrimitive->hasNormalIndices()) {
-				semantic = "NORMAL";
-				buildAttributes[semantic] = std::vector<float>();
-				semanticIndices[semantic] = colladaPrimitive->getNormalIndices().getData();
-				semanticData[semantic] = &colladaMesh->getNormals();
-				primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
-			}
-			if (colladaPrimitive->hasBinormalIndices()) {
-				semantic = "BINORMAL";
-				buildAttributes[semantic] = std::vector<float>();
-				semanticIndices[semantic] = colladaPrimitive->getBinormalIndices().getData();
-				semanticData[semantic] = &colladaMesh->getBinormals();
-				primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
-			}
-			if (colladaPrimitive->hasTangentIndices()) {
-				semantic = "TANGENT";
-				buildAttributes[semantic] = std::vector<float>();
-				semanticIndices[semantic] = colladaPrimitive->getTangentIndices().getData();
-				semanticData[semantic] = &colladaMesh->getTangents();
-				primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
+			primitives.push_back(primitive);
+			colladaPrimitives.push_back(colladaPrimitive);
+			triangulate.push_back(shouldTriangulate);
+		}
+
+		// Primitives are built independently, then added to the mesh in their COLLADA order
+		size_t primitivesCount = primitives.size();
+		std::vector<std::vector<unsigned int>> mappings(primitivesCount);
+		std::vector<std::future<bool>> results;
+		GLTF::ThreadPool* threadPool = primitivesCount > 1 ? getThreadPool() : NULL;
+		for (size_t i = 0; i < primitivesCount; i++) {
+			GLTF::Primitive* primitive = primitives[i];
+			COLLADAFW::MeshPrimitive* colladaPrimitive = colladaPrimitives[i];
+			bool shouldTriangulate = triangulate[i];
+			std::vector<unsigned int>* mapping = &mappings[i];
+			if (threadPool != NULL) {
+				results.push_back(threadPool->enqueue([this, colladaMesh, colladaPrimitive, primitive, shouldTriangulate, mapping]() {
+					return this->writeMeshPrimitive(colladaMesh, colladaPrimitive, primitive, shouldTriangulate, mapping);
+				}));
 			}
-			if (colladaPrimitive->hasUVCoordIndices()) {
-				COLLADAFW::IndexListArray& uvCoordIndicesArray = colladaPrimitive->getUVCoordIndicesArray();
-				size_t uvCoordIndicesArrayCount = uvCoordIndicesArray.getCount();
-				for (size_t j = 0; j < uvCoordIndicesArrayCount; j++) {
-					semantic = "TEXCOORD_" + std::to_string(j);
-					buildAttributes[semantic] = std::vector<float>();
-					semanticIndices[semantic] = uvCoordIndicesArray[j]->getIndices().getData();
-					semanticData[semantic] = &colladaMesh->getUVCoords();
-					primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
-				}
+			else if (!writeMeshPrimitive(colladaMesh, colladaPrimitive, primitive, shouldTriangulate, mapping)) {
+				return false;
 			}
-			if (colladaPrimitive->hasColorIndices()) {
-				COLLADAFW::IndexListArray& colorIndicesArray = colladaPrimitive->getColorIndicesArray();
-				size_t colorIndicesArrayCount = colorIndicesArray.getCount();
-				for (size_t j = 0; j < colorIndicesArrayCount; j++) {
-					semantic = "COLOR_" + std::to_string(j);
-					buildAttributes[semantic] = std::vector<float>();
-					semanticIndices[semantic] = colorIndicesArray[j]->getIndices().getData();
-					semanticData[semantic] = &colladaMesh->getColors();
-					primitive->attributes[semantic] = (GLTF::Accessor*)NULL;
-				}
+		}
+		bool success = true;
+		for (std::future<bool>& result : results) {
+			if (!result.get()) {
+				success = false;
 			}
+		}
+		if (!success) {
+			return false;
+		}
+		for (size_t i = 0; i < primitivesCount; i++) {
+			GLTF::Primitive* primitive = primitives[i];
+			mesh->primitives.push_back(primitive);
+			positionMapping[primitive] = mappings[i];
+		}
+	}
+	_meshMaterialPrimitiveMapping[uniqueId] = primitiveMaterialMapping;
+	_meshPositionMapping[uniqueId] = positionMapping;
+	_meshInstances[uniqueId] = mesh;
+	return true;
+}
 
-			unsigned int index = 0;
-			unsigned int face = 0;
-			unsigned int startFace = 0;
-			unsigned int totalVertexCount = 0;
-			unsigned int vertexCount = 0;
-			unsigned int faceVertexCount = colladaPrimitive->getGroupedVerticesVertexCount(face);
-			for (int j = 0; j < count; j++) {
-				std::string attributeId;
-				if (shouldTriangulate) {
-					// This approach is very efficient in terms of runtime, but there are more correct solutions that may be worth considering.
-					// Using a 3D variant of Fortune's Algorithm or something similar to compute a mesh with no overlapping triangles would be ideal.
-					if (vertexCount >= faceVertexCount) {
-						unsigned int end = buildIndices.size() - 1;
-						if (faceVertexCount > 3) {
-							// Make a triangle with the last two points and the first one
-							buildIndices.push_back(buildIndices[end - 1]);
-							buildIndices.push_back(buildIndices[end]);
-							buildIndices.push_back(buildIndices[startFace]);
-							totalVertexCount += 3;
-						}
-						face++;
-						faceVertexCount = colladaPrimitive->getGroupedVerticesVertexCount(face);
-						startFace = totalVertexCount;
-						vertexCount = 0;
-					}
-					else if (vertexCount >= 3) {
-						// Add the previous two points to complete the triangle
-						unsigned int end = buildIndices.size() - 1;
-						buildIndices.push_back(buildIndices[end - 1]);
-						buildIndices.push_back(buildIndices[end]);
-						totalVertexCount += 2;
-					}
-				}
-				for (const auto& entry : semanticIndices) {
-					semantic = entry.first;
-					unsigned int numberOfComponents = 3;
-					if (semantic.find("TEXCOORD") == 0) {
-						numberOfComponents = 2;
-					}
-					attributeId += buildAttributeId(*semanticData[semantic], semanticIndices[semantic][j], numberOfComponents);
-				}
-				std::map<std::string, unsigned int>::iterator search = attributeIndicesMapping.find(attributeId);
-				if (search != attributeIndicesMapping.end()) {
-					buildIndices.push_back(search->second);
-				}
-				else {
-					for (const auto& entry : buildAttributes) {
-						semantic = entry.first;
-						unsigned int numberOfComponents = 3;
-						bool flipY = false;
-						bool position = false;
-						if (semantic.find("TEXCOORD") == 0) {
-							numberOfComponents = 2;
-							flipY = true;
-						}
-						unsigned int semanticIndex = semanticIndices[semantic][j];
-						if (semantic == "POSITION") {
-							position = true;
-							mapping.push_back(semanticIndex);
-						}
-						const COLLADAFW::MeshVertexData* vertexData = semanticData[semantic];
-						unsigned int stride = numberOfComponents;
-						if (vertexData->getNumInputInfos() > 0) {
-							stride = vertexData->getStride(0);
-						}
-						for (unsigned int k = 0; k < numberOfComponents; k++) {
-							float value = getMeshVertexDataAtIndex(*vertexData, semanticIndex * stride + k);
-							if (flipY && k == 1) {
-								value = 1 - value;
-							}
-							if (position) {
-								value = value * _assetScale;
-							}
-							buildAttributes[semantic].push_back(value);
-						}
-					}
-					attributeIndicesMapping[attributeId] = index;
-					buildIndices.push_back(index);
-					index++;
+/**
+ * Builds the indices and attributes of a <GLTF::Primitive> from a <COLLADAFW::MeshPrimitive>.
+ *
+ * This only reads from the writer and the COLLADA mesh, so primitives of the same mesh can be built concurrently.
+ *
+ * @param colladaMesh The COLLADA mesh containing the primitive
+ * @param colladaPrimitive The COLLADA primitive to build
+ * @param primitive The glTF primitive to write the indices and attributes to
+ * @param shouldTriangulate `true` if the COLLADA primitive contains polygons that should be triangulated
+ * @param mapping Receives the COLLADA position index of each glTF vertex
+ * @return `true` if the operation completed succesfully, `false` if an error occured
+ */
+bool COLLADA2GLTF::Writer::writeMeshPrimitive(const COLLADAFW::Mesh* colladaMesh, COLLADAFW::MeshPrimitive* colladaPrimitive, GLTF::Primitive* primitive, bool shouldTriangulate, std::vector<unsigned int>* mapping) {
+	std::vector<unsigned int> buildIndices;
+	size_t count = colladaPrimitive->getPositionIndices().getCount();
+	COLLADA2GLTF::VertexStreams vertexStreams(count, _assetScale);
+	vertexStreams.addStream("POSITION", colladaPrimitive->getPositionIndices().getData(), &colladaMesh->getPositions());
+	if (colladaPrimitive->hasNormalIndices()) {
+		vertexStreams.addStream("NORMAL", colladaPrimitive->getNormalIndices().getData(), &colladaMesh->getNormals());
+	}
+	if (colladaPrimitive->hasBinormalIndices()) {
+		vertexStreams.addStream("BINORMAL", colladaPrimitive->getBinormalIndices().getData(), &colladaMesh->getBinormals());
+	}
+	if (colladaPrimitive->hasTangentIndices()) {
+		vertexStreams.addStream("TANGENT", colladaPrimitive->getTangentIndices().getData(), &colladaMesh->getTangents());
+	}
+	if (colladaPrimitive->hasUVCoordIndices()) {
+		COLLADAFW::IndexListArray& uvCoordIndicesArray = colladaPrimitive->getUVCoordIndicesArray();
+		size_t uvCoordIndicesArrayCount = uvCoordIndicesArray.getCount();
+		for (size_t j = 0; j < uvCoordIndicesArrayCount; j++) {
+			vertexStreams.addStream("TEXCOORD_" + std::to_string(j), uvCoordIndicesArray[j]->getIndices().getData(), &colladaMesh->getUVCoords());
+		}
+	}
+	if (colladaPrimitive->hasColorIndices()) {
+		COLLADAFW::IndexListArray& colorIndicesArray = colladaPrimitive->getColorIndicesArray();
+		size_t colorIndicesArrayCount = colorIndicesArray.getCount();
+		for (size_t j = 0; j < colorIndicesArrayCount; j++) {
+			vertexStreams.addStream("COLOR_" + std::to_string(j), colorIndicesArray[j]->getIndices().getData(), &colladaMesh->getColors());
+		}
+	}
+	vertexStreams.finalize();
+	std::vector<COLLADA2GLTF::VertexStreams::Stream>& streams = vertexStreams.streams;
+	const unsigned int* positionIndices = colladaPrimitive->getPositionIndices().getData();
+	mapping->reserve(count);
+	buildIndices.reserve(count);
+
+	// Corners are welded on the attribute ids of each semantic, which are looked up by COLLADA source index
+	size_t semanticCount = streams.size();
+	std::vector<std::vector<unsigned int>> idIndices(semanticCount);
+	std::vector<std::unordered_map<std::string, unsigned int>> attributeIds(semanticCount);
+	std::vector<unsigned int> vertexKey(semanticCount);
+	COLLADA2GLTF::VertexIndex vertexIndex(semanticCount, count);
+
+	unsigned int index = 0;
+	unsigned int face = 0;
+	unsigned int startFace = 0;
+	unsigned int totalVertexCount = 0;
+	unsigned int vertexCount = 0;
+	unsigned int faceVertexCount = colladaPrimitive->getGroupedVerticesVertexCount(face);
+	for (int j = 0; j < count; j++) {
+		if (shouldTriangulate) {
+			// This approach is very efficient in terms of runtime, but there are more correct solutions that may be worth considering.
+			// Using a 3D variant of Fortune's Algorithm or something similar to compute a mesh with no overlapping triangles would be ideal.
+			if (vertexCount >= faceVertexCount) {
+				unsigned int end = buildIndices.size() - 1;
+				if (faceVertexCount > 3) {
+					// Make a triangle with the last two points and the first one
+					buildIndices.push_back(buildIndices[end - 1]);
+					buildIndices.push_back(buildIndices[end]);
+					buildIndices.push_back(buildIndices[startFace]);
+					totalVertexCount += 3;
 				}
-				totalVertexCount++;
-				vertexCount++;
+				face++;
+				faceVertexCount = colladaPrimitive->getGroupedVerticesVertexCount(face);
+				startFace = totalVertexCount;
+				vertexCount = 0;
 			}
-			if (shouldTriangulate && faceVertexCount > 3) {
-				// Close the last polyshape
-				int end = buildIndices.size() - 1;
+			else if (vertexCount >= 3) {
+				// Add the previous two points to complete the triangle
+				unsigned int end = buildIndices.size() - 1;
 				buildIndices.push_back(buildIndices[end - 1]);
 				buildIndices.push_back(buildIndices[end]);
-				buildIndices.push_back(buildIndices[startFace]);
-			}
-			if (_options->dracoCompression ) {
-				// Currently only support triangles. 
-				if (primitive->mode == GLTF::Primitive::Mode::TRIANGLES) {
-					if (!addAttributesToDracoMesh(primitive, buildAttributes, buildIndices)) {
-						// Error adding attributes to draco mesh.
-						return false;
-					}
-				}
+				totalVertexCount += 2;
 			}
-
-			// Create indices accessor
-			GLTF::Accessor* indices = NULL;
-			if (index < 65536) {
-				// We can fit this in an UNSIGNED_SHORT
-				std::vector<unsigned short> unsignedShortIndices(buildIndices.begin(), buildIndices.end());
-				indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_SHORT, (unsigned char*)&unsignedShortIndices[0], unsignedShortIndices.size(), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
-			}
-			else {
-				// Leave as UNSIGNED_INT
-				indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_INT, (unsigned char*)&buildIndices[0], buildIndices.size(), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
-			}
-			primitive->indices = indices;
-			mesh->primitives.push_back(primitive);
-			// Create attribute accessors
-			for (const auto& entry : buildAttributes) {
-				std::string semantic = entry.first;
-				std::vector<float> attributeData = entry.second;
-				GLTF::Accessor::Type type = GLTF::Accessor::Type::VEC3;
-				if (semantic.find("TEXCOORD") == 0) {
-					type = GLTF::Accessor::Type::VEC2;
-				}
-				GLTF::Accessor* accessor = new GLTF::Accessor(type, GLTF::Constants::WebGL::FLOAT, (unsigned char*)&attributeData[0], attributeData.size() / GLTF::Accessor::getNumberOfComponents(type), GLTF::Constants::WebGL::ARRAY_BUFFER);
-				primitive->attributes[semantic] = accessor;
+		}
+		for (size_t k = 0; k < semanticCount; k++) {
+			const COLLADA2GLTF::VertexStreams::Stream& stream = streams[k];
+			vertexKey[k] = getAttributeIdIndex(*stream.data, stream.indices[j], stream.numberOfComponents, &idIndices[k], &attributeIds[k]);
+		}
+		bool inserted;
+		unsigned int vertex = vertexIndex.findOrInsert(vertexKey.data(), &inserted);
+		if (!inserted) {
+			buildIndices.push_back(vertex);
+		}
+		else {
+			vertexStreams.appendVertex(j);
+			mapping->push_back(positionIndices[j]);
+			buildIndices.push_back(index);
+			index++;
+		}
+		totalVertexCount++;
+		vertexCount++;
+	}
+	if (shouldTriangulate && faceVertexCount > 3) {
+		// Close the last polyshape
+		int end = buildIndices.size() - 1;
+		buildIndices.push_back(buildIndices[end - 1]);
+		buildIndices.push_back(buildIndices[end]);
+		buildIndices.push_back(buildIndices[startFace]);
+	}
+	if (_options->dracoCompression ) {
+		// Currently only support triangles. 
+		if (primitive->mode == GLTF::Primitive::Mode::TRIANGLES) {
+			if (!addAttributesToDracoMesh(primitive, streams, buildIndices)) {
+				// Error adding attributes to draco mesh.
+				return false;
 			}
-			positionMapping[primitive] = mapping;
 		}
 	}
-	_meshMaterialPrimitiveMapping[uniqueId] = primitiveMaterialMapping;
-	_meshPositionMapping[uniqueId] = positionMapping;
-	_meshInstances[uniqueId] = mesh;
+
+	// Create indices accessor
+	GLTF::Accessor* indices = NULL;
+	if (index < 65536) {
+		// We can fit this in an UNSIGNED_SHORT
+		std::vector<unsigned short> unsignedShortIndices(buildIndices.begin(), buildIndices.end());
+		indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_SHORT, std::move(unsignedShortIndices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+	}
+	else {
+		// Leave as UNSIGNED_INT
+		indices = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::UNSIGNED_INT, std::move(buildIndices), GLTF::Constants::WebGL::ELEMENT_ARRAY_BUFFER);
+	}
+	primitive->indices = indices;
+	// Create attribute accessors, handing over the built vertex data rather than copying it
+	for (COLLADA2GLTF::VertexStreams::Stream& stream : streams) {
+		GLTF::Accessor* accessor = new GLTF::Accessor(stream.type, GLTF::Constants::WebGL::FLOAT, std::move(stream.values), GLTF::Constants::WebGL::ARRAY_BUFFER);
+		primitive->attributes[stream.semantic] = accessor;
+	}
 	return true;
 }
 
-bool COLLADA2GLTF::Writer::addAttributesToDracoMesh(GLTF::Primitive* primitive, const std::map<std::string, std::vector<float>>& buildAttributes, const std::vector<unsigned int>& buildIndices) {
+bool COLLADA2GLTF::Writer::addAttributesToDracoMesh(GLTF::Primitive* primitive, const std::vector<COLLADA2GLTF::VertexStreams::Stream>& streams, const std::vector<unsigned int>& buildIndices) {
 	// Add extension to primitive.
 	GLTF::DracoExtension* dracoExtension = new GLTF::DracoExtension();
 	primitive->extensions["KHR_draco_mesh_compression"] = (GLTF::Extension*)dracoExtension;
@@ -777,12 +822,11 @@ bool COLLADA2GLTF::Writer::addAttributesToDracoMesh(GLTF::Primitive* primitive,
 	}
 
 	// Add attributes to Draco mesh.
-	for (const auto& entry : buildAttributes) {
+	for (const COLLADA2GLTF::VertexStreams::Stream& stream : streams) {
 		// First create Accessor without data.
-		std::string semantic = entry.first;
-		std::vector<float> attributeData = entry.second;
-		GLTF::Accessor::Type type = semantic.find("TEXCOORD") == 0 ? GLTF::Accessor::Type::VEC2 : GLTF::Accessor::Type::VEC3;
-		const int componentCount = GLTF::Accessor::getNumberOfComponents(type);
+		const std::string& semantic = stream.semantic;
+		const std::vector<float>& attributeData = stream.values;
+		const int componentCount = stream.numberOfComponents;
 		const int vertexCount = attributeData.size() / componentCount;
 
 		// Create attributes for Draco mesh.
@@ -1092,6 +1136,7 @@ bool COLLADA2GLTF::Writer::writeCamera(const COLLADAFW::Camera* colladaCamera) {
 bool COLLADA2GLTF::Writer::writeImage(const COLLADAFW::Image* colladaImage) {
 	const COLLADABU::URI imageUri = colladaImage->getImageURI();
 	path imagePath = path(_options->basePath) / imageUri.toNativePath(COLLADABU::Utils::getSystemType());
+	// The file is only read if the image is still used once the asset has been cleaned up
 	GLTF::Image* image = GLTF::Image::load(imagePath);
 	image->stringId = colladaImage->getOriginalId();
 	_images[colladaImage->getUniqueId()] = image;
@@ -1231,9 +1276,9 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 	std::set<float> timeSet = std::set<float>();
 	GLTF::Node::TransformMatrix* transformMatrix = NULL;
 	GLTF::Node::TransformTRS* transformTRS = NULL;
-	float* translation = NULL;
-	float* rotation = NULL;
-	float* scale = NULL;
+	std::vector<float> translation;
+	std::vector<float> rotation;
+	std::vector<float> scale;
 
 	if (nodeTransform) {
 		if (nodeTransform->type == GLTF::Node::Transform::MATRIX) {
@@ -1300,7 +1345,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 
 	// Generate translation, rotation, scale for each keyframe
 	if (hasTranslation) {
-		translation = new float[times.size() * 3];
+		translation.resize(times.size() * 3);
 		// We do this so that if x, y, or z are unspecified, the translation is still valid
 		// For the others, all components will be set, so we don't have to worry about it
 		for (size_t i = 0; i < times.size(); i++) {
@@ -1310,10 +1355,10 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 		}
 	}
 	if (hasRotation) {
-		rotation = new float[times.size() * 4];
+		rotation.resize(times.size() * 4);
 	}
 	if (hasScale) {
-		scale = new float[times.size() * 3];
+		scale.resize(times.size() * 3);
 	}
 	float* lastRotation = new float[4];
 	for (size_t j = 0; j < 4; j++) {
@@ -1372,7 +1417,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 			}
 			case COLLADAFW::AnimationList::POSITION_X: {
 				if (needsInterpolation) {
-					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 0, time, translation + (j * 3), _assetScale);
+					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 0, time, &translation[j * 3], _assetScale);
 				}
 				else {
 					translation[j * 3] = output[index] * _assetScale;
@@ -1381,7 +1426,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 			}
 			case COLLADAFW::AnimationList::POSITION_Y: {
 				if (needsInterpolation) {
-					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 1, time, translation + (j * 3), _assetScale);
+					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 1, time, &translation[j * 3], _assetScale);
 				}
 				else {
 					translation[j * 3 + 1] = output[index] * _assetScale;
@@ -1390,7 +1435,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 			}
 			case COLLADAFW::AnimationList::POSITION_Z: {
 				if (needsInterpolation) {
-					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 2, time, translation + (j * 3), _assetScale);
+					interpolateTranslation(nodeTransformTRS->translation, input, output, index, 2, time, &translation[j * 3], _assetScale);
 				}
 				else {
 					translation[j * 3 + 2] = output[index] * _assetScale;
@@ -1449,12 +1494,12 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 	}
 
 	GLTF::Animation* animation = new GLTF::Animation();
-	GLTF::Accessor* inputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::FLOAT, (unsigned char*)times.data(), times.size(), (GLTF::Constants::WebGL)-1);
+	GLTF::Accessor* inputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::SCALAR, GLTF::Constants::WebGL::FLOAT, std::move(times), (GLTF::Constants::WebGL)-1);
 	if (hasTranslation) {
 		GLTF::Animation::Channel* channel = new GLTF::Animation::Channel();
 		GLTF::Animation::Channel::Target* target = new GLTF::Animation::Channel::Target();
 		GLTF::Animation::Sampler* sampler = new GLTF::Animation::Sampler();
-		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, (unsigned char*)translation, times.size(), (GLTF::Constants::WebGL) - 1);
+		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(translation), (GLTF::Constants::WebGL) - 1);
 		sampler->input = inputAccessor;
 		sampler->output = outputAccessor;
 		target->node = node;
@@ -1467,7 +1512,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 		GLTF::Animation::Channel* channel = new GLTF::Animation::Channel();
 		GLTF::Animation::Channel::Target* target = new GLTF::Animation::Channel::Target();
 		GLTF::Animation::Sampler* sampler = new GLTF::Animation::Sampler();
-		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC4, GLTF::Constants::WebGL::FLOAT, (unsigned char*)rotation, times.size(), (GLTF::Constants::WebGL) - 1);
+		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC4, GLTF::Constants::WebGL::FLOAT, std::move(rotation), (GLTF::Constants::WebGL) - 1);
 		sampler->input = inputAccessor;
 		sampler->output = outputAccessor;
 		target->node = node;
@@ -1480,7 +1525,7 @@ bool COLLADA2GLTF::Writer::writeAnimationList(const COLLADAFW::AnimationList* an
 		GLTF::Animation::Channel* channel = new GLTF::Animation::Channel();
 		GLTF::Animation::Channel::Target* target = new GLTF::Animation::Channel::Target();
 		GLTF::Animation::Sampler* sampler = new GLTF::Animation::Sampler();
-		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, (unsigned char*)scale, times.size(), (GLTF::Constants::WebGL) - 1);
+		GLTF::Accessor* outputAccessor = new GLTF::Accessor(GLTF::Accessor::Type::VEC3, GLTF::Constants::WebGL::FLOAT, std::move(scale), (GLTF::Constants::WebGL) - 1);
 		sampler->input = inputAccessor;
 		sampler->output = outputAccessor;
 		target->node = node;
@@ -1508,7 +1553,7 @@ bool COLLADA2GLTF::Writer::writeSkinControllerData(const COLLADAFW::SkinControll
 	GLTF::Node::TransformMatrix* bindShapeMatrix = new GLTF::Node::TransformMatrix();
 	packColladaMatrix(skinControllerData->getBindShapeMatrix(), bindShapeMatrix);
 	GLTF::Node::TransformMatrix* inverseBindMatrix = new GLTF::Node::TransformMatrix();
-	float* inverseBindMatrices = new float[16 * matrixArrayCount];
+	std::vector<float> inverseBindMatrices(16 * matrixArrayCount);
 	for (size_t i = 0; i < matrixArrayCount; i++) {
 		packColladaMatrix(matrixArray[i], inverseBindMatrix);
 		bindShapeMatrix->premultiply(inverseBindMatrix, inverseBindMatrix);
@@ -1516,7 +1561,7 @@ bool COLLADA2GLTF::Writer::writeSkinControllerData(const COLLADAFW::SkinControll
 			inverseBindMatrices[i * 16 + j] = inverseBindMatrix->matrix[j];
 		}
 	}
-	skin->inverseBindMatrices = new GLTF::Accessor(GLTF::Accessor::Type::MAT4, GLTF::Constants::WebGL::FLOAT, (unsigned char*)inverseBindMatrices, matrixArrayCount, (GLTF::Constants::WebGL)-1);
+	skin->inverseBindMatrices = new GLTF::Accessor(GLTF::Accessor::Type::MAT4, GLTF::Constants::WebGL::FLOAT, std::move(inverseBindMatrices), (GLTF::Constants::WebGL)-1);
 
 	// Cache joint and weight data
 	// COLLADA can have different numbers of joints for a single vertex
@@ -1642,8 +1687,8 @@ bool COLLADA2GLTF::Writer::writeController(const COLLADAFW::Controller* controll
 		for (const auto& primitiveEntry : positionMapping) {
 			GLTF::Primitive* primitive = primitiveEntry.first;
 			int count = primitive->attributes["POSITION"]->count;
-			unsigned short* jointArray = new unsigned short[count * numberOfComponents];
-			float* weightArray = new float[count * numberOfComponents];
+			std::vector<unsigned short> jointArray(count * numberOfComponents);
+			std::vector<float> weightArray(count * numberOfComponents);
 
 			std::vector<unsigned int> mapping = primitiveEntry.second;
 			for (int i = 0; i < count; i++) {
@@ -1657,12 +1702,12 @@ bool COLLADA2GLTF::Writer::writeController(const COLLADAFW::Controller* controll
 			}
 
 			if (_options->dracoCompression) {
-					if (!addControllerDataToDracoMesh(primitive, jointArray, weightArray))
+					if (!addControllerDataToDracoMesh(primitive, jointArray.data(), weightArray.data()))
 						return false;
 			}
 
-			GLTF::Accessor* weightAccessor = new GLTF::Accessor(type, GLTF::Constants::WebGL::FLOAT, (unsigned char*)weightArray, count, GLTF::Constants::WebGL::ARRAY_BUFFER);
-			GLTF::Accessor* jointAccessor = new GLTF::Accessor(type, GLTF::Constants::WebGL::UNSIGNED_SHORT, (unsigned char*)jointArray, count, GLTF::Constants::WebGL::ARRAY_BUFFER);
+			GLTF::Accessor* weightAccessor = new GLTF::Accessor(type, GLTF::Constants::WebGL::FLOAT, std::move(weightArray), GLTF::Constants::WebGL::ARRAY_BUFFER);
+			GLTF::Accessor* jointAccessor = new GLTF::Accessor(type, GLTF::Constants::WebGL::UNSIGNED_SHORT, std::move(jointArray), GLTF::Constants::WebGL::ARRAY_BUFFER);
 			if (_options->version == "1.0") {
 				primitive->attributes["WEIGHT"] = weightAccessor;
 				primitive->attributes["JOINT"] = jointAccessor;
@@ -2,9 +2,10 @@
 #include "COLLADA2GLTFExtrasHandler.h"
 #include "COLLADASaxFWLLoader.h"
 
-#include "rapidjson/document.h"
+#include "GLTFJSONWriter.h"
+#include "GLTFSegmentWriter.h"
+#include "rapidjson/filewritestream.h"
 #include "rapidjson/prettywriter.h"
-#include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 
 #include "ahoy/ahoy.h"
@@ -12,7 +13,7 @@
 #include <ctime>
 #include <stdio.h>
 #include <iostream>
-#include <fstream>
+#include <map>
 #include <experimental/filesystem>
 
 using namespace ahoy;
@@ -20,6 +21,17 @@ using namespace std::experimental::filesystem;
 
 const int HEADER_LENGTH = 12;
 const int CHUNK_HEADER_LENGTH = 8;
+// Binary glTF stores its chunk and file lengths as 32-bit integers
+const size_t MAX_GLB_LENGTH = 0xFFFFFFFF;
+const size_t JSON_WRITE_BUFFER_SIZE = 65536;
+
+template <typename Writer, typename OutputStream>
+void writeAssetJSON(GLTF::Asset* asset, Writer* writer, OutputStream* stream, GLTF::Options* options) {
+	GLTF::JSONWriterAdapter<Writer, OutputStream> jsonWriter(writer, stream);
+	jsonWriter.StartObject();
+	asset->writeJSON(&jsonWriter, options);
+	jsonWriter.EndObject();
+}
 
 int main(int argc, const char **argv) {
 	GLTF::Asset* asset = new GLTF::Asset();
@@ -95,20 +107,95 @@ int main(int argc, const char **argv) {
 		->description("compress the geometries using Draco compression extension");
 
 	parser->define("qp", &options->positionQuantizationBits)
-		->description("position quantization bits used in Draco compression extension");
+		->description("position quantization bits used in Draco compression extension and mesh quantization");
 
 	parser->define("qn", &options->normalQuantizationBits)
-		->description("normal quantization bits used in Draco compression extension");
+		->description("normal quantization bits used in Draco compression extension and mesh quantization");
 
 	parser->define("qt", &options->texcoordQuantizationBits)
-		->description("texture coordinate quantization bits used in Draco compression extension");
+		->description("texture coordinate quantization bits used in Draco compression extension and mesh quantization");
 
 	parser->define("qc", &options->colorQuantizationBits)
-		->description("color quantization bits used in Draco compression extension");
+		->description("color quantization bits used in Draco compression extension and mesh quantization");
+
+	parser->define("meshQuantization", &options->meshQuantization)
+		->defaults(false)
+		->description("store mesh attributes as normalized integers using the KHR_mesh_quantization extension");
 
 	parser->define("qj", &options->jointQuantizationBits)
 		->description("joint indices and weights quantization bits used in Draco compression extension");
 
+	parser->define("removeDuplicateMeshes", &options->removeDuplicateMeshes)
+		->defaults(false)
+		->description("share identical primitives and meshes so their data is only written once");
+
+	parser->define("removeDuplicateAccessors", &options->removeDuplicateAccessors)
+		->defaults(false)
+		->description("share accessors with identical data, such as repeated animation inputs or inverse bind matrices");
+
+	parser->define("removeDuplicateImages", &options->removeDuplicateImages)
+		->defaults(false)
+		->description("share images with identical contents, so a texture stored under several names or paths is only written once");
+
+	parser->define("atlasTextures", &options->atlasTextures)
+		->defaults(false)
+		->description("pack small diffuse textures that don't repeat into shared atlases and merge the materials that become identical");
+
+	parser->define("atlasMaxTextureSize", &options->atlasMaxTextureSize)
+		->description("largest width or height of a texture that is packed into an atlas");
+
+	parser->define("atlasSize", &options->atlasSize)
+		->description("largest width or height of a texture atlas");
+
+	parser->define("maxTextureSize", &options->maxTextureSize)
+		->description("scale textures down so that neither dimension is larger than this many pixels");
+
+	parser->define("powerOfTwoTextures", &options->powerOfTwoTextures)
+		->defaults(false)
+		->description("resize textures to the nearest power of two in each dimension");
+
+	parser->define("gpuInstancing", &options->gpuInstancing)
+		->defaults(false)
+		->description("draw sibling nodes that share a mesh as instances of one node using the EXT_mesh_gpu_instancing extension");
+
+	parser->define("interleave", &options->interleave)
+		->defaults(false)
+		->description("store the vertex attributes of each primitive interleaved in a single bufferView");
+
+	parser->define("maxBufferSize", &options->maxBufferSize)
+		->description("split the binary data into separate buffers of at most this many megabytes");
+
+	parser->define("flatten", &options->flatten)
+		->defaults(false)
+		->description("bake static node transforms into vertex data and remove the nodes that are no longer needed");
+
+	parser->define("batchPrimitives", &options->batchPrimitives)
+		->defaults(false)
+		->description("merge the primitives of static nodes that share a material into fewer draw calls");
+
+	parser->define("batchMaxVertices", &options->batchMaxVertices)
+		->description("maximum number of vertices in a merged primitive");
+
+	parser->define("optimizeVertexCache", &options->optimizeVertexCache)
+		->defaults(false)
+		->description("reorder triangles to improve post-transform vertex cache hit rates");
+
+	parser->define("optimizeVertexFetch", &options->optimizeVertexFetch)
+		->defaults(false)
+		->description("renumber vertices in the order they are first used by the indices");
+
+	parser->define("lodLevels", &options->lodLevels)
+		->description("number of simplified levels of detail to generate for each mesh using the MSFT_lod extension");
+
+	parser->define("lodRatio", &options->lodRatio)
+		->description("fraction of the triangles of the previous level to keep in each level of detail");
+
+	parser->define("lodError", &options->lodError)
+		->description("largest simplification error allowed in a level of detail, as a fraction of the mesh size");
+
+	parser->define("threads", &options->threads)
+		->description("number of threads used to build mesh primitives and read images");
+
 	if (parser->parse(argc, argv)) {
 		// Resolve and sanitize paths
 		path inputPath = path(options->inputPath);
@@ -147,6 +234,10 @@ int main(int argc, const char **argv) {
 		if (separateTextures != 0) {
 			options->embeddedTextures = false;
 		}
+		if (options->maxBufferSize > 0) {
+			// Each buffer is written to its own file
+			options->embeddedBuffers = false;
+		}
 
 		if (options->version == "1.0" && !options->materialsCommon) {
 			options->glsl = true;
@@ -165,6 +256,63 @@ int main(int argc, const char **argv) {
 			return -1;
 		}
 
+		if (options->lodLevels > 0 && options->version == "1.0") {
+			std::cout << "ERROR: Cannot generate levels of detail for glTF 1.0" << std::endl;
+			return -1;
+		}
+		if (options->lodLevels > 0 && options->dracoCompression) {
+			std::cout << "ERROR: Cannot generate levels of detail with Draco compression enabled" << std::endl;
+			return -1;
+		}
+		if (options->lodLevels > 0 && (options->lodRatio <= 0 || options->lodRatio >= 1)) {
+			std::cout << "ERROR: lodRatio must be between 0 and 1" << std::endl;
+			return -1;
+		}
+		if (options->flatten && options->dracoCompression) {
+			std::cout << "ERROR: Cannot enable both flatten and dracoCompression" << std::endl;
+			return -1;
+		}
+		if (options->batchPrimitives && options->dracoCompression) {
+			std::cout << "ERROR: Cannot enable both batchPrimitives and dracoCompression" << std::endl;
+			return -1;
+		}
+		if (options->batchPrimitives && options->batchMaxVertices < 1) {
+			std::cout << "ERROR: batchMaxVertices must be at least 1" << std::endl;
+			return -1;
+		}
+		if (options->gpuInstancing && options->version == "1.0") {
+			std::cout << "ERROR: Cannot use GPU instancing for glTF 1.0" << std::endl;
+			return -1;
+		}
+		if (options->meshQuantization && options->version == "1.0") {
+			std::cout << "ERROR: Cannot quantize meshes for glTF 1.0" << std::endl;
+			return -1;
+		}
+		if (options->meshQuantization && options->dracoCompression) {
+			std::cout << "ERROR: Cannot enable both meshQuantization and dracoCompression" << std::endl;
+			return -1;
+		}
+		if (options->threads < 1) {
+			std::cout << "ERROR: threads must be at least 1" << std::endl;
+			return -1;
+		}
+		if (options->maxBufferSize < 0) {
+			std::cout << "ERROR: maxBufferSize cannot be negative" << std::endl;
+			return -1;
+		}
+		if (options->atlasTextures && options->dracoCompression) {
+			std::cout << "ERROR: Cannot enable both atlasTextures and dracoCompression" << std::endl;
+			return -1;
+		}
+		if (options->atlasTextures && (options->atlasMaxTextureSize < 1 || options->atlasSize < 1)) {
+			std::cout << "ERROR: atlasMaxTextureSize and atlasSize must be at least 1" << std::endl;
+			return -1;
+		}
+		if (options->maxTextureSize < 0) {
+			std::cout << "ERROR: maxTextureSize cannot be negative" << std::endl;
+			return -1;
+		}
+
 		// Create the output directory if it does not exist
 		path outputDirectory = outputPath.parent_path();
 		if (!std::experimental::filesystem::exists(outputDirectory)) {
@@ -188,65 +336,147 @@ int main(int argc, const char **argv) {
 		asset->removeUnusedNodes(options);
 		asset->removeUnusedSemantics();
 
+		// Only images that are still used and embedded are read, in the background while the asset is processed
+		GLTF::ThreadPool imageThreadPool(options->threads > 1 ? options->threads : 0);
+		if (options->embeddedTextures) {
+			for (GLTF::Image* image : asset->getAllImages()) {
+				image->prefetch(&imageThreadPool);
+			}
+		}
+		if (options->removeDuplicateImages) {
+			asset->removeDuplicateImages(&imageThreadPool);
+		}
+		if (options->atlasTextures) {
+			asset->atlasTextures(options, &imageThreadPool);
+		}
+		if (options->maxTextureSize > 0 || options->powerOfTwoTextures) {
+			asset->processTextures(options, &imageThreadPool);
+		}
+
+		if (options->flatten) {
+			asset->flattenNodes();
+		}
+		if (options->batchPrimitives) {
+			asset->batchPrimitives(options);
+			// Nodes that only held a batched mesh are now empty
+			asset->removeUnusedNodes(options);
+		}
+		if (options->removeDuplicateMeshes) {
+			asset->removeDuplicateMeshes();
+		}
+
+		if (options->optimizeVertexCache) {
+			MeshOptimizer::VertexCacheStatistics before;
+			MeshOptimizer::VertexCacheStatistics after;
+			asset->optimizeVertexCache(&before, &after);
+			std::cout << "Vertex cache ACMR: " << before.acmr << " -> " << after.acmr << ", ATVR: " << before.atvr << " -> " << after.atvr << std::endl;
+		}
+		if (options->optimizeVertexFetch) {
+			asset->optimizeVertexFetch();
+		}
+		if (options->lodLevels > 0) {
+			asset->generateLevelsOfDetail(options);
+		}
+		if (options->gpuInstancing) {
+			asset->instanceMeshes();
+		}
+		if (options->meshQuantization) {
+			asset->quantizeAttributes(options);
+		}
+
+		if (options->removeDuplicateAccessors) {
+			asset->removeDuplicateAccessors();
+		}
+
 		if (options->dracoCompression) {
 			asset->removeUncompressedBufferViews();
 			asset->compressPrimitives(options);
 		}
 
-		GLTF::Buffer* buffer = asset->packAccessors();
+		std::vector<GLTF::Buffer*> buffers = asset->packAccessors(options);
+		GLTF::Buffer* buffer = buffers[0];
 		if (options->binary && options->version == "1.0") {
 			buffer->stringId = "binary_glTF";
 		}
 
+		// The bytes of each buffer, referenced in place so that images are never copied into it
+		std::map<GLTF::Buffer*, GLTF::SegmentWriter> bufferSegments;
+		for (GLTF::Buffer* buffer : buffers) {
+			bufferSegments[buffer].append(buffer->data, buffer->byteLength);
+		}
+
 		// Create image bufferViews for binary glTF
 		if (options->binary && options->embeddedTextures) {
-			size_t imageBufferLength = 0;
-			std::vector<GLTF::Image*> images = asset->getAllImages();
-			for (GLTF::Image* image : images) {
-				imageBufferLength += image->byteLength;
-			}
-			unsigned char* bufferData = buffer->data;
-			bufferData = (unsigned char*)realloc(bufferData, buffer->byteLength + imageBufferLength);
-			size_t byteOffset = buffer->byteLength;
-			for (GLTF::Image* image : images) {
-				GLTF::BufferView* bufferView = new GLTF::BufferView(byteOffset, image->byteLength, buffer);
-				image->bufferView = bufferView;
-				std::memcpy(bufferData + byteOffset, image->data, image->byteLength);
-				byteOffset += image->byteLength;
+			// Images follow the packed data, starting a new buffer whenever the last one would go over the maximum size
+			size_t maxBufferSize = (size_t)options->maxBufferSize * 1024 * 1024;
+			GLTF::Buffer* imageBuffer = buffers.back();
+			for (GLTF::Image* image : asset->getAllImages()) {
+				size_t imageByteLength = image->getByteLength();
+				if (maxBufferSize > 0 && imageBuffer->byteLength > 0 && imageBuffer->byteLength + imageByteLength > maxBufferSize) {
+					imageBuffer = new GLTF::Buffer(NULL, 0);
+					buffers.push_back(imageBuffer);
+				}
+				image->bufferView = new GLTF::BufferView(imageBuffer->byteLength, imageByteLength, imageBuffer);
+				imageBuffer->byteLength += imageByteLength;
+				bufferSegments[imageBuffer].append(image->getData(), imageByteLength);
 			}
-			buffer->data = bufferData;
-			buffer->byteLength += imageBufferLength;
 		}
 
-		rapidjson::StringBuffer s;
-		rapidjson::Writer<rapidjson::StringBuffer> jsonWriter = rapidjson::Writer<rapidjson::StringBuffer>(s);
-		jsonWriter.StartObject();
-		asset->writeJSON(&jsonWriter, options);
-		jsonWriter.EndObject();
+		// Buffers written to their own files are not stored in the binary chunk
+		size_t binLength = options->binary && options->embeddedBuffers ? buffer->byteLength : 0;
+		if (binLength > MAX_GLB_LENGTH - (HEADER_LENGTH + CHUNK_HEADER_LENGTH * 2 + 3)) {
+			std::cout << "ERROR: The binary chunk of " << binLength << " bytes is larger than binary glTF allows, use --maxBufferSize to split it or -s to write separate buffers" << std::endl;
+			return -1;
+		}
+
+		// The JSON is streamed straight into the output file; for binary glTF the headers are
+		// written once its length is known
+		FILE* file = fopen(outputPath.generic_string().c_str(), "wb");
+		if (file == NULL) {
+			std::cout << "ERROR: couldn't write glTF to path '" << outputPath << "'" << std::endl;
+			return -1;
+		}
+		if (options->binary) {
+			fseek(file, HEADER_LENGTH + CHUNK_HEADER_LENGTH, SEEK_SET);
+		}
+		char* writeBuffer = new char[JSON_WRITE_BUFFER_SIZE];
+		rapidjson::FileWriteStream stream(file, writeBuffer, JSON_WRITE_BUFFER_SIZE);
+		if (options->binary) {
+			rapidjson::Writer<rapidjson::FileWriteStream> writer(stream);
+			writeAssetJSON(asset, &writer, &stream, options);
+		}
+		else {
+			rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(stream);
+			writeAssetJSON(asset, &writer, &stream, options);
+		}
+		stream.Flush();
+		delete[] writeBuffer;
 
 		if (!options->embeddedTextures) {
 			for (GLTF::Image* image : asset->getAllImages()) {
+				// Images that were never read are copied from their source file
 				path uri = outputDirectory / image->uri;
-				FILE* file = fopen(uri.generic_string().c_str(), "wb");
-				if (file != NULL) {
-					fwrite(image->data, sizeof(unsigned char), image->byteLength, file);
-					fclose(file);
-				}
-				else {
+				if (!image->write(uri)) {
 					std::cout << "ERROR: Couldn't write image to path '" << uri << "'" << std::endl;
 				}
 			}
 		}
 
 		if (!options->embeddedBuffers) {
-			path uri = outputDirectory / buffer->uri;
-			FILE* file = fopen(uri.generic_string().c_str(), "wb");
-			if (file != NULL) {
-				fwrite(buffer->data, sizeof(unsigned char), buffer->byteLength, file);
-				fclose(file);
-			}
-			else {
-				std::cout << "ERROR: Couldn't write buffer to path '" << uri << "'" << std::endl;
+			for (GLTF::Buffer* buffer : buffers) {
+				if (buffer->uri == "") {
+					// The buffer is not referenced by any bufferView
+					continue;
+				}
+				path uri = outputDirectory / buffer->uri;
+				FILE* file = fopen(uri.generic_string().c_str(), "wb");
+				if (file != NULL) {
+					bufferSegments[buffer].write(file);
+					fclose(file);
+				}
+				else {
+					std::cout << "ERROR: Couldn't write buffer to path '" << uri << "'" << std::endl;
+				}
 			}
 		}
 
@@ -264,75 +494,67 @@ int main(int argc, const char **argv) {
 			}
 		}
 
-		std::string jsonString = s.GetString();
 		if (!options->binary) {
-			rapidjson::Document jsonDocument;
-			jsonDocument.Parse(jsonString.c_str());
-
-			rapidjson::StringBuffer buffer;
-			rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-			jsonDocument.Accept(writer);
+			fwrite("\n", sizeof(char), 1, file);
+		}
+		else {
+			size_t jsonLength = ftell(file) - (HEADER_LENGTH + CHUNK_HEADER_LENGTH);
+			size_t jsonPadding = (4 - (jsonLength & 3)) & 3;
+			size_t binPadding = (4 - (binLength & 3)) & 3;
+			size_t length = HEADER_LENGTH + (CHUNK_HEADER_LENGTH + jsonLength + jsonPadding + binLength + binPadding);
+			if (options->version != "1.0" && binLength > 0) {
+				length += CHUNK_HEADER_LENGTH;
+			}
+			if (length > MAX_GLB_LENGTH) {
+				std::cout << "ERROR: The binary glTF would be " << length << " bytes, which is larger than binary glTF allows, use --maxBufferSize to split the buffer or -s to write separate buffers" << std::endl;
+				fclose(file);
+				std::experimental::filesystem::remove(outputPath);
+				return -1;
+			}
 
-			std::ofstream file(options->outputPath);
-			if (file.is_open()) {
-				file << buffer.GetString() << std::endl;
-				file.close();
+			GLTF::SegmentWriter segments;
+			segments.appendPadding(jsonPadding, ' ');
+			uint32_t* writeHeader = new uint32_t[2];
+			uint32_t* binHeader = new uint32_t[2];
+			if (options->version != "1.0" && binLength > 0) {
+				binHeader[0] = (uint32_t)(binLength + binPadding); // chunkLength
+				binHeader[1] = 0x004E4942; // chunkType BIN
+				segments.append(binHeader, sizeof(uint32_t) * 2);
 			}
-			else {
-				std::cout << "ERROR: couldn't write glTF to path '" << options->outputPath << "'" << std::endl;
+			if (binLength > 0) {
+				segments.append(&bufferSegments[buffer]);
 			}
-		}
-		else {
-			FILE* file = fopen(outputPath.generic_string().c_str(), "wb");
-			if (file != NULL) {
-				fwrite("glTF", sizeof(char), 4, file); // magic
-
-				uint32_t* writeHeader = new uint32_t[2];
-				// version
-				if (options->version == "1.0") {
-					writeHeader[0] = 1;
-				}
-				else {
-					writeHeader[0] = 2;
-				}
+			segments.appendPadding(binPadding, '\0');
+			if (!segments.write(file)) {
+				std::cout << "ERROR couldn't write binary glTF to path '" << outputPath << "'" << std::endl;
+			}
+			delete[] binHeader;
 
-				int jsonPadding = (4 - (jsonString.length() & 3)) & 3;
-				int binPadding = (4 - (buffer->byteLength & 3)) & 3;
+			fseek(file, 0, SEEK_SET);
+			fwrite("glTF", sizeof(char), 4, file); // magic
 
-				writeHeader[1] = HEADER_LENGTH + (CHUNK_HEADER_LENGTH + jsonString.length() + jsonPadding + buffer->byteLength + binPadding); // length
-				if (options->version != "1.0") {
-					writeHeader[1] += CHUNK_HEADER_LENGTH;
-				}
-				fwrite(writeHeader, sizeof(uint32_t), 2, file); // GLB header
+			// version
+			if (options->version == "1.0") {
+				writeHeader[0] = 1;
+			}
+			else {
+				writeHeader[0] = 2;
+			}
 
-				writeHeader[0] = jsonString.length() + jsonPadding; // 2.0 - chunkLength / 1.0 - contentLength
-				if (options->version == "1.0") {
-					writeHeader[1] = 0; // 1.0 - contentFormat
-				}
-				else {
-					writeHeader[1] = 0x4E4F534A; // 2.0 - chunkType JSON
-				}
-				fwrite(writeHeader, sizeof(uint32_t), 2, file);
-				fwrite(jsonString.c_str(), sizeof(char), jsonString.length(), file);
-				for (int i = 0; i < jsonPadding; i++) {
-					fwrite(" ", sizeof(char), 1, file);
-				}
-				if (options->version != "1.0") {
-					writeHeader[0] = buffer->byteLength + binPadding; // chunkLength
-					writeHeader[1] = 0x004E4942; // chunkType BIN
-					fwrite(writeHeader, sizeof(uint32_t), 2, file);
-				}
-				fwrite(buffer->data, sizeof(unsigned char), buffer->byteLength, file);
-				for (int i = 0; i < binPadding; i++) {
-					fwrite("\0", sizeof(char), 1, file);
-				}
+			writeHeader[1] = (uint32_t)length; // length
+			fwrite(writeHeader, sizeof(uint32_t), 2, file); // GLB header
 
-				fclose(file);
+			writeHeader[0] = (uint32_t)(jsonLength + jsonPadding); // 2.0 - chunkLength / 1.0 - contentLength
+			if (options->version == "1.0") {
+				writeHeader[1] = 0; // 1.0 - contentFormat
 			}
 			else {
-				std::cout << "ERROR couldn't write binary glTF to path '" << outputPath << "'" << std::endl;
+				writeHeader[1] = 0x4E4F534A; // 2.0 - chunkType JSON
 			}
+			fwrite(writeHeader, sizeof(uint32_t), 2, file);
+			delete[] writeHeader;
 		}
+		fclose(file);
 
 		std::clock_t end = std::clock();
 		std::cout << "Time: " << ((end - start) / (double)(CLOCKS_PER_SEC / 1000)) << " ms" << std::endl;
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "COLLADA2GLTFVertexIndex.h"
+#include "gtest/gtest.h"
+
+namespace {
+  class COLLADA2GLTFVertexIndexTest : public ::testing::Test {
+  };
+}
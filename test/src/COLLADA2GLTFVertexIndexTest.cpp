@@ -0,0 +1,43 @@
+#include "COLLADA2GLTFVertexIndexTest.h"
+
+TEST_F(COLLADA2GLTFVertexIndexTest, FindOrInsert_AssignsIndicesInInsertionOrder) {
+	COLLADA2GLTF::VertexIndex vertexIndex(2, 4);
+	unsigned int a[2] = { 1, 2 };
+	unsigned int b[2] = { 2, 1 };
+	bool inserted;
+	EXPECT_EQ(vertexIndex.findOrInsert(a, &inserted), 0);
+	EXPECT_TRUE(inserted);
+	EXPECT_EQ(vertexIndex.findOrInsert(b, &inserted), 1);
+	EXPECT_TRUE(inserted);
+	EXPECT_EQ(vertexIndex.findOrInsert(a, &inserted), 0);
+	EXPECT_FALSE(inserted);
+	EXPECT_EQ(vertexIndex.size(), 2);
+}
+
+TEST_F(COLLADA2GLTFVertexIndexTest, FindOrInsert_GrowsPastExpectedVertexCount) {
+	COLLADA2GLTF::VertexIndex vertexIndex(1, 1);
+	bool inserted;
+	for (unsigned int i = 0; i < 1000; i++) {
+		EXPECT_EQ(vertexIndex.findOrInsert(&i, &inserted), i);
+		EXPECT_TRUE(inserted);
+	}
+	for (unsigned int i = 0; i < 1000; i++) {
+		EXPECT_EQ(vertexIndex.findOrInsert(&i, &inserted), i);
+		EXPECT_FALSE(inserted);
+	}
+	EXPECT_EQ(vertexIndex.size(), 1000);
+}
+
+TEST_F(COLLADA2GLTFVertexIndexTest, FindOrInsert_KeysDifferingInOneSemanticStayApart) {
+	COLLADA2GLTF::VertexIndex vertexIndex(3, 4);
+	unsigned int keys[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+	bool inserted;
+	for (unsigned int i = 0; i < 4; i++) {
+		EXPECT_EQ(vertexIndex.findOrInsert(keys[i], &inserted), i);
+		EXPECT_TRUE(inserted);
+	}
+	unsigned int same[3] = { 0, 0, 1 };
+	EXPECT_EQ(vertexIndex.findOrInsert(same, &inserted), 3);
+	EXPECT_FALSE(inserted);
+	EXPECT_EQ(vertexIndex.size(), 4);
+}
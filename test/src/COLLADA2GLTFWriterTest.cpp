@@ -1,8 +1,12 @@
+#include <string>
 #include <vector>
 
 #include "COLLADA2GLTFWriterTest.h"
 #include "COLLADABU.h"
 #include "COLLADAFW.h"
+#include "GLTFJSONWriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 
 COLLADA2GLTFWriterTest::COLLADA2GLTFWriterTest() {
 	asset = new GLTF::Asset();
@@ -80,3 +84,162 @@ TEST_F(COLLADA2GLTFWriterTest, WriteLibraryNodes_MeshDoesExist) {
 	GLTF::Mesh* mesh = sceneNode->mesh;
 	ASSERT_TRUE(mesh != NULL);
 }
+
+void appendValues(COLLADAFW::MeshVertexData& data, const std::vector<float>& values) {
+	data.setType(COLLADAFW::FloatOrDoubleArray::DATA_TYPE_FLOAT);
+	for (float value : values) {
+		data.getFloatValues()->append(value);
+	}
+}
+
+void appendIndices(COLLADAFW::UIntValuesArray& indices, const std::vector<unsigned int>& values) {
+	for (unsigned int value : values) {
+		indices.append(value);
+	}
+}
+
+/**
+ * Creates a mesh with one triangles primitive over a unit quad, where the last position repeats
+ * the value of the second.
+ */
+COLLADAFW::Mesh* createQuadMesh(const std::vector<unsigned int>& positionIndices, const std::vector<unsigned int>& normalIndices, const std::vector<unsigned int>& uvIndices) {
+	COLLADAFW::Mesh* mesh = new COLLADAFW::Mesh(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 0, 0));
+	appendValues(mesh->getPositions(), { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0 });
+	appendValues(mesh->getNormals(), { 0, 0, 1, 0, 0, -1 });
+	appendValues(mesh->getUVCoords(), { 0, 0, 1, 0, 0, 1, 1, 1, 0.5, 0 });
+	COLLADAFW::Triangles* triangles = new COLLADAFW::Triangles(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::TRIANGLES, 0, 0));
+	appendIndices(triangles->getPositionIndices(), positionIndices);
+	appendIndices(triangles->getNormalIndices(), normalIndices);
+	COLLADAFW::IndexList* uvIndexList = new COLLADAFW::IndexList();
+	appendIndices(uvIndexList->getIndices(), uvIndices);
+	triangles->getUVCoordIndicesArray().append(uvIndexList);
+	triangles->setFaceCount(positionIndices.size() / 3);
+	mesh->getMeshPrimitives().append(triangles);
+	return mesh;
+}
+
+/**
+ * Writes a COLLADA mesh and returns the glTF primitive built for it.
+ */
+GLTF::Primitive* writeQuadMesh(COLLADA2GLTF::Writer* writer, GLTF::Asset* asset, COLLADAFW::Mesh* mesh) {
+	COLLADAFW::FileInfo fileInfo;
+	writer->writeGlobalAsset(&fileInfo);
+	writer->writeGeometry(mesh);
+	COLLADAFW::LibraryNodes* nodes = new COLLADAFW::LibraryNodes();
+	COLLADAFW::Node* node = new COLLADAFW::Node(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::NODE, 0, 0));
+	COLLADAFW::InstanceGeometry* instanceGeometry = new COLLADAFW::InstanceGeometry(
+		COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 1, 0),
+		COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 0, 0)
+	);
+	node->getInstanceGeometries().append(instanceGeometry);
+	nodes->getNodes().append(node);
+	writer->writeLibraryNodes(nodes);
+	std::vector<GLTF::Mesh*> meshes = asset->getAllMeshes();
+	if (meshes.size() != 1 || meshes[0]->primitives.size() != 1) {
+		return NULL;
+	}
+	return meshes[0]->primitives[0];
+}
+
+std::vector<float> getAccessorValues(GLTF::Accessor* accessor) {
+	int numberOfComponents = accessor->getNumberOfComponents();
+	std::vector<float> values(accessor->count * numberOfComponents);
+	for (int i = 0; i < accessor->count; i++) {
+		accessor->getComponentAtIndex(i, &values[i * numberOfComponents]);
+	}
+	return values;
+}
+
+TEST_F(COLLADA2GLTFWriterTest, WriteGeometry_WeldsIdenticalCorners) {
+	// The second triangle uses the repeated position, which has the same value as the second one
+	COLLADAFW::Mesh* mesh = createQuadMesh({ 0, 1, 2, 2, 4, 3 }, { 0, 0, 0, 0, 0, 0 }, { 0, 1, 2, 2, 1, 3 });
+	GLTF::Primitive* primitive = writeQuadMesh(this->writer, this->asset, mesh);
+	ASSERT_TRUE(primitive != NULL);
+	EXPECT_EQ(getAccessorValues(primitive->indices), std::vector<float>({ 0, 1, 2, 2, 1, 3 }));
+	EXPECT_EQ(getAccessorValues(primitive->attributes["POSITION"]), std::vector<float>({ 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 }));
+	EXPECT_EQ(primitive->attributes["NORMAL"]->count, 4);
+	// Texture coordinates are flipped vertically
+	EXPECT_EQ(getAccessorValues(primitive->attributes["TEXCOORD_0"]), std::vector<float>({ 0, 1, 1, 1, 0, 0, 1, 0 }));
+}
+
+TEST_F(COLLADA2GLTFWriterTest, WriteGeometry_KeepsCornersWithDifferentAttributesApart) {
+	// The fourth corner has another normal and the fifth another texture coordinate than the corners sharing their positions
+	COLLADAFW::Mesh* mesh = createQuadMesh({ 0, 1, 2, 2, 1, 3 }, { 0, 0, 0, 1, 0, 0 }, { 0, 1, 2, 2, 4, 3 });
+	GLTF::Primitive* primitive = writeQuadMesh(this->writer, this->asset, mesh);
+	ASSERT_TRUE(primitive != NULL);
+	EXPECT_EQ(getAccessorValues(primitive->indices), std::vector<float>({ 0, 1, 2, 3, 4, 5 }));
+	std::vector<float> positions = getAccessorValues(primitive->attributes["POSITION"]);
+	ASSERT_EQ(positions.size(), 18);
+	EXPECT_EQ(std::vector<float>(positions.begin() + 9, positions.begin() + 12), std::vector<float>(positions.begin() + 6, positions.begin() + 9));
+	EXPECT_EQ(std::vector<float>(positions.begin() + 12, positions.begin() + 15), std::vector<float>(positions.begin() + 3, positions.begin() + 6));
+	std::vector<float> normals = getAccessorValues(primitive->attributes["NORMAL"]);
+	EXPECT_EQ(normals[11], -1);
+	EXPECT_EQ(normals[14], 1);
+	std::vector<float> texCoords = getAccessorValues(primitive->attributes["TEXCOORD_0"]);
+	EXPECT_EQ(texCoords[8], 0.5);
+}
+
+/**
+ * Converts a mesh with a primitive for each material and returns the glTF JSON followed by the binary data.
+ */
+std::string convertMaterialGroups(int threads) {
+	GLTF::Asset* asset = new GLTF::Asset();
+	COLLADA2GLTF::Options* options = new COLLADA2GLTF::Options();
+	options->threads = threads;
+	COLLADASaxFWL::Loader* loader = new COLLADASaxFWL::Loader();
+	COLLADA2GLTF::ExtrasHandler* extrasHandler = new COLLADA2GLTF::ExtrasHandler(loader);
+	COLLADA2GLTF::Writer* writer = new COLLADA2GLTF::Writer(asset, options, extrasHandler);
+
+	COLLADAFW::Mesh* mesh = new COLLADAFW::Mesh(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 0, 0));
+	appendValues(mesh->getNormals(), { 0, 0, 1 });
+	for (unsigned int i = 0; i < 16; i++) {
+		// Each group is a strip of quads of a different length, so the primitives take different times to build
+		COLLADAFW::Triangles* triangles = new COLLADAFW::Triangles(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::TRIANGLES, i, 0));
+		unsigned int first = mesh->getPositions().getValuesCount() / 3;
+		unsigned int quadCount = (i * 7) % 16 + 1;
+		for (unsigned int j = 0; j <= quadCount; j++) {
+			appendValues(mesh->getPositions(), { (float)j, (float)i, 0, (float)j, (float)i + 1, 0 });
+		}
+		for (unsigned int j = 0; j < quadCount; j++) {
+			unsigned int a = first + j * 2;
+			appendIndices(triangles->getPositionIndices(), { a, a + 2, a + 1, a + 1, a + 2, a + 3 });
+			appendIndices(triangles->getNormalIndices(), { 0, 0, 0, 0, 0, 0 });
+		}
+		triangles->setFaceCount(quadCount * 2);
+		triangles->setMaterialId(i);
+		mesh->getMeshPrimitives().append(triangles);
+	}
+	COLLADAFW::FileInfo fileInfo;
+	writer->writeGlobalAsset(&fileInfo);
+	writer->writeGeometry(mesh);
+	COLLADAFW::LibraryNodes* nodes = new COLLADAFW::LibraryNodes();
+	COLLADAFW::Node* node = new COLLADAFW::Node(COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::NODE, 0, 0));
+	node->getInstanceGeometries().append(new COLLADAFW::InstanceGeometry(
+		COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 1, 0),
+		COLLADAFW::UniqueId(COLLADAFW::COLLADA_TYPE::MESH, 0, 0)
+	));
+	nodes->getNodes().append(node);
+	writer->writeLibraryNodes(nodes);
+
+	std::vector<GLTF::Buffer*> buffers = asset->packAccessors(options);
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> stringWriter(s);
+	GLTF::JSONWriterAdapter<rapidjson::Writer<rapidjson::StringBuffer>, rapidjson::StringBuffer> jsonWriter(&stringWriter, &s);
+	jsonWriter.StartObject();
+	asset->writeJSON(&jsonWriter, options);
+	jsonWriter.EndObject();
+	std::string output = s.GetString();
+	for (GLTF::Buffer* buffer : buffers) {
+		output.append((const char*)buffer->data, buffer->byteLength);
+	}
+	delete writer;
+	delete asset;
+	return output;
+}
+
+TEST_F(COLLADA2GLTFWriterTest, WriteGeometry_OutputDoesNotDependOnThreads) {
+	std::string serial = convertMaterialGroups(1);
+	EXPECT_GT(serial.size(), 0);
+	EXPECT_EQ(convertMaterialGroups(4), serial);
+	EXPECT_EQ(convertMaterialGroups(16), serial);
+}
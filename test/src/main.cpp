@@ -1,3 +1,4 @@
+#include "COLLADA2GLTFVertexIndexTest.h"
 #include "COLLADA2GLTFWriterTest.h"
 
 int main(int argc, char **argv) {